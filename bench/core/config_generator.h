@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace caps::bench {
+
+// Vocabulary shared with the workload generator, so generated key streams hit the keys,
+// apps and modifiers that generated configs actually name.
+inline constexpr const char* kSources[] = {"j", "k", "i", "l", "u", "o", "h", "n", "m", "p", "y", "b"};
+inline constexpr const char* kTargets[] = {"Left", "Down", "Up", "Right", "Home", "End",
+                                           "PageUp", "PageDown", "Shift! Left", "Control! C"};
+inline constexpr const char* kModifiers[] = {"a", "s", "d", "f", "g", "q", "w", "e", "r", "t", "z", "x"};
+inline constexpr std::size_t kSourceCount = sizeof(kSources) / sizeof(kSources[0]);
+inline constexpr std::size_t kTargetCount = sizeof(kTargets) / sizeof(kTargets[0]);
+inline constexpr std::size_t kModifierCount = sizeof(kModifiers) / sizeof(kModifiers[0]);
+inline constexpr std::uint32_t kDefaultSeed = 2463534242u;
+
+// xorshift32: cheap and reproducible across platforms and standard libraries.
+class Xorshift {
+public:
+    explicit Xorshift(std::uint32_t seed) : state_(seed == 0 ? kDefaultSeed : seed) {}
+    std::uint32_t operator()() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+private:
+    std::uint32_t state_;
+};
+
+// Deterministic stand-in for the production config generator: a [modifiers] block
+// followed by `lines` mapping rows spread across per-app sections ("App0".."App<apps-1>"
+// and "*"). The same arguments always produce byte-identical output so results compare
+// across commits; another `seed` gives a different config of the same shape.
+inline std::string GenerateConfig(std::size_t lines,
+                                  std::size_t apps = 64,
+                                  std::size_t modifiers = 4,
+                                  std::uint32_t seed = kDefaultSeed) {
+    if (modifiers > kModifierCount) {
+        modifiers = kModifierCount;
+    }
+
+    std::string out;
+    out.reserve(lines * 40 + 64);
+    out += "# generated\n[modifiers]\n";
+    for (std::size_t m = 0; m < modifiers; ++m) {
+        out += kModifiers[m];
+        out += '\n';
+    }
+    out += "\n[maps]\n";
+
+    Xorshift next(seed);
+
+    for (std::size_t line = 0; line < lines; ++line) {
+        const std::size_t app = next() % (apps + 1);
+        out += '[';
+        if (app == apps) {
+            out += '*';
+        } else {
+            out += "App";
+            out += std::to_string(app);
+        }
+        out += "] [";
+        if (modifiers > 0) {
+            const std::uint32_t mods = next() % (1u << (modifiers < 3 ? modifiers : 3));
+            for (std::size_t m = 0; m < 3 && m < modifiers; ++m) {
+                if (mods & (1u << m)) {
+                    out += kModifiers[m];
+                    out += ' ';
+                }
+            }
+        }
+        out += kSources[next() % kSourceCount];
+        out += "] [";
+        out += kTargets[next() % kTargetCount];
+        out += "]\n";
+    }
+    return out;
+}
+
+} // namespace caps::bench
@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "config_generator.h"
+#include "core/config/config_loader.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Writes each generated size once and reuses it across repetitions.
+const fs::path& ConfigForLines(std::size_t lines) {
+    static std::map<std::size_t, fs::path> cache;
+    auto it = cache.find(lines);
+    if (it == cache.end()) {
+        const fs::path path = fs::temp_directory_path() /
+                              ("capsunlocked_bench_" + std::to_string(lines) + ".ini");
+        std::ofstream(path, std::ios::binary) << caps::bench::GenerateConfig(lines);
+        it = cache.emplace(lines, path).first;
+    }
+    return it->second;
+}
+
+void BM_ConfigParse(benchmark::State& state) {
+    const auto lines = static_cast<std::size_t>(state.range(0));
+    const fs::path& path = ConfigForLines(lines);
+    const auto bytes = static_cast<int64_t>(fs::file_size(path));
+
+    for (auto _ : state) {
+        caps::core::ConfigLoader loader;
+        loader.Load(path.string());
+        benchmark::DoNotOptimize(loader.Mappings().size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines));
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_ConfigParse)->RangeMultiplier(10)->Range(100, 1'000'000)->Unit(benchmark::kMillisecond);
+
+// Hot-reload after a one-line edit in the middle of the file: toggles an extra "*" row in
+// and out so every iteration is a real change. File writes are excluded from the timing.
+void BM_ConfigReloadOneLine(benchmark::State& state) {
+    const auto lines = static_cast<std::size_t>(state.range(0));
+    const std::string original = caps::bench::GenerateConfig(lines);
+    std::string edited = original;
+    edited.insert(edited.find('\n', edited.size() / 2) + 1, "[*] [j] [End]\n");
+    const fs::path path = fs::temp_directory_path() / "capsunlocked_bench_reload.ini";
+    std::ofstream(path, std::ios::binary) << original;
+
+    caps::core::ConfigLoader loader;
+    loader.Load(path.string());
+    bool toggled = false;
+    for (auto _ : state) {
+        state.PauseTiming();
+        toggled = !toggled;
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << (toggled ? edited : original);
+        state.ResumeTiming();
+
+        loader.Reload();
+        benchmark::DoNotOptimize(loader.Compiled().get());
+    }
+    state.counters["incremental"] = loader.LastDelta().full_reload ? 0 : 1;
+    fs::remove(path);
+}
+BENCHMARK(BM_ConfigReloadOneLine)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/sync/mpsc_queue.h"
+
+namespace {
+
+constexpr std::int64_t kItemsPerProducer = 200'000;
+
+// Producers push kItemsPerProducer items each while the benchmark thread drains, the
+// shape of several OS callbacks feeding the layer's owner thread. Reports items/s.
+template <typename Queue>
+void RunInbox(benchmark::State& state) {
+    const auto producers = static_cast<int>(state.range(0));
+    const std::int64_t total = kItemsPerProducer * producers;
+    for (auto _ : state) {
+        Queue queue;
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, &go] {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (std::int64_t i = 0; i < kItemsPerProducer;) {
+                    if (queue.Push(static_cast<std::uint64_t>(i))) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield(); // full: let the consumer run on small machines
+                    }
+                }
+            });
+        }
+        go.store(true, std::memory_order_release);
+        std::int64_t received = 0;
+        std::uint64_t value = 0;
+        while (received < total) {
+            if (queue.Pop(value)) {
+                benchmark::DoNotOptimize(value);
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+struct LockFreeInbox {
+    caps::core::MpscQueue<std::uint64_t, 1024> queue;
+    bool Push(std::uint64_t value) { return queue.TryPush(value); }
+    bool Pop(std::uint64_t& value) { return queue.TryPop(value); }
+};
+
+// What the inbox replaces: the same hand-off behind a mutex.
+struct MutexInbox {
+    std::mutex mutex;
+    std::deque<std::uint64_t> items;
+    bool Push(std::uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.size() == 1024) {
+            return false;
+        }
+        items.push_back(value);
+        return true;
+    }
+    bool Pop(std::uint64_t& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) {
+            return false;
+        }
+        value = items.front();
+        items.pop_front();
+        return true;
+    }
+};
+
+void BM_InboxMpsc(benchmark::State& state) {
+    RunInbox<LockFreeInbox>(state);
+}
+BENCHMARK(BM_InboxMpsc)->DenseRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_InboxMutex(benchmark::State& state) {
+    RunInbox<MutexInbox>(state);
+}
+BENCHMARK(BM_InboxMutex)->DenseRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "config_generator.h"
+#include "core/config/config_loader.h"
+#include "core/layer/layer_controller.h"
+#include "core/logging.h"
+#include "core/mapping/mapping_engine.h"
+#include "workload_generator.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using caps::bench::KeyMix;
+
+// A loaded controller with the layer held and a focused app that has its own rows, fed a
+// generated key stream. Logging is raised to Warning so the numbers are the key path's.
+struct KeyPath {
+    explicit KeyPath(KeyMix mix, std::size_t lines = 256) {
+        caps::core::logging::SetLevel(caps::core::logging::Level::Warning);
+        const fs::path path = fs::temp_directory_path() / "capsunlocked_bench_key_path.ini";
+        std::ofstream(path, std::ios::binary) << caps::bench::GenerateConfig(lines);
+        loader.Load(path.string());
+        mapping.Initialize();
+        controller.SetAppResolver([] { return caps::core::MappingEngine::FocusedApp{"APP7", 1}; });
+        controller.OnCapsLockPressed();
+        fs::remove(path);
+        events = caps::bench::GenerateKeyStream(mix, 4096);
+    }
+
+    const caps::core::KeyEvent& Next() {
+        const auto& event = events[next];
+        next = next + 1 == events.size() ? 0 : next + 1;
+        return event;
+    }
+
+    caps::core::ConfigLoader loader;
+    caps::core::MappingEngine mapping{loader};
+    caps::core::LayerController controller{mapping};
+    std::vector<caps::core::KeyEvent> events;
+    std::size_t next{0};
+};
+
+// The per-key path as the hooks run it, by traffic shape.
+void BM_OnKeyEvent(benchmark::State& state) {
+    const auto mix = static_cast<KeyMix>(state.range(0));
+    state.SetLabel(caps::bench::KeyMixName(mix));
+    KeyPath path(mix);
+    std::uint64_t ops = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(path.controller.OnKeyEvent(
+            path.Next(), [&ops](const caps::core::ActionProgram& program, bool) { ops += program.size(); }));
+    }
+    benchmark::DoNotOptimize(ops);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OnKeyEvent)
+    ->Arg(static_cast<int>(KeyMix::kMapped))
+    ->Arg(static_cast<int>(KeyMix::kUnmapped))
+    ->Arg(static_cast<int>(KeyMix::kModifier))
+    ->Arg(static_cast<int>(KeyMix::kRepeat));
+
+// Mapped keys emitted through the type-erased program callback instead of a static sink.
+void BM_KeyPathCallback(benchmark::State& state) {
+    KeyPath path(KeyMix::kMapped);
+    std::uint64_t ops = 0;
+    path.controller.SetProgramCallback(
+        [&ops](const caps::core::ActionProgram& program, bool) { ops += program.size(); });
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(path.controller.OnKeyEvent(path.Next()));
+    }
+    benchmark::DoNotOptimize(ops);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KeyPathCallback);
+
+// The same stream with the sink bound at compile time, as the hooks call it.
+void BM_KeyPathStaticSink(benchmark::State& state) {
+    KeyPath path(KeyMix::kMapped);
+    std::uint64_t ops = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(path.controller.OnKeyEvent(
+            path.Next(), [&ops](const caps::core::ActionProgram& program, bool) { ops += program.size(); }));
+    }
+    benchmark::DoNotOptimize(ops);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KeyPathStaticSink);
+
+} // namespace
@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "config_generator.h"
+#include "core/config/config_loader.h"
+#include "core/mapping/mapping_engine.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using caps::core::MappingEngine;
+
+// A config of the given shape loaded into a MappingEngine, plus a deterministic set of
+// lookups over its keys, apps (and one it does not know) and modifier combinations.
+struct ResolveSetup {
+    ResolveSetup(std::size_t lines, std::size_t apps, std::size_t modifiers) {
+        const fs::path path = fs::temp_directory_path() / "capsunlocked_bench_resolve.ini";
+        std::ofstream(path, std::ios::binary) << caps::bench::GenerateConfig(lines, apps, modifiers);
+        loader.Load(path.string());
+        mapping.Initialize();
+        fs::remove(path);
+
+        const auto snapshot = mapping.Acquire();
+        caps::bench::Xorshift next(7);
+        for (std::size_t i = 0; i < 1024; ++i) {
+            Query query;
+            query.key = snapshot->FindKey(caps::bench::kSources[next() % caps::bench::kSourceCount]);
+            const std::size_t app = next() % (apps + 1);
+            query.app = app == apps ? "UNLISTED" : "APP" + std::to_string(app);
+            query.app_id = snapshot->FindApp(query.app);
+            for (std::size_t m = 0; m < modifiers; ++m) {
+                if (next() % 4 == 0) {
+                    query.mods |= snapshot->ModifierBit(snapshot->FindKey(caps::bench::kModifiers[m]));
+                }
+            }
+            queries.push_back(query);
+        }
+    }
+
+    struct Query {
+        caps::core::KeyId key{caps::core::kInvalidKeyId};
+        std::string app;
+        caps::core::AppId app_id{caps::core::kFallbackAppId};
+        caps::core::ModifierMask mods{0};
+    };
+
+    caps::core::ConfigLoader loader;
+    MappingEngine mapping{loader};
+    std::vector<Query> queries;
+};
+
+// lines x apps x declared modifiers.
+void ResolveShapes(benchmark::internal::Benchmark* bench) {
+    for (const int lines : {1'000, 100'000}) {
+        for (const int apps : {1, 64, 1'024}) {
+            for (const int modifiers : {0, 4, 12}) {
+                bench->Args({lines, apps, modifiers});
+            }
+        }
+    }
+    bench->ArgNames({"lines", "apps", "mods"});
+}
+
+// Allocation-free resolution against an app row already looked up, as the layer does it.
+void BM_ResolveRef(benchmark::State& state) {
+    ResolveSetup setup(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)),
+                       static_cast<std::size_t>(state.range(2)));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto snapshot = setup.mapping.Acquire();
+        const auto& query = setup.queries[i++ & 1023];
+        benchmark::DoNotOptimize(MappingEngine::ResolveRef(snapshot, query.key, query.app_id, query.mods));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ResolveRef)->Apply(ResolveShapes);
+
+// The string-in, strings-out ResolveMapping(): app name lookup plus the copied result.
+void BM_ResolveMapping(benchmark::State& state) {
+    ResolveSetup setup(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)),
+                       static_cast<std::size_t>(state.range(2)));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto& query = setup.queries[i++ & 1023];
+        benchmark::DoNotOptimize(setup.mapping.ResolveMapping(query.key, query.app, query.mods));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ResolveMapping)->Apply(ResolveShapes);
+
+// Reload plus UpdateFromConfig() after the file was replaced by a different config of the
+// same shape: the full-reparse path a config swap takes. File writes are not timed.
+void BM_ReloadAndPublish(benchmark::State& state) {
+    const auto lines = static_cast<std::size_t>(state.range(0));
+    const std::string configs[] = {caps::bench::GenerateConfig(lines),
+                                   caps::bench::GenerateConfig(lines, 64, 4, 12345)};
+    const fs::path path = fs::temp_directory_path() / "capsunlocked_bench_publish.ini";
+    std::ofstream(path, std::ios::binary) << configs[0];
+
+    caps::core::ConfigLoader loader;
+    loader.Load(path.string());
+    MappingEngine mapping(loader);
+    mapping.Initialize();
+    std::size_t which = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        which ^= 1;
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << configs[which];
+        state.ResumeTiming();
+
+        loader.Reload();
+        mapping.UpdateFromConfig();
+        benchmark::DoNotOptimize(mapping.Acquire()->KeyCount());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(lines));
+    fs::remove(path);
+}
+BENCHMARK(BM_ReloadAndPublish)->RangeMultiplier(10)->Range(100, 100'000)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config_generator.h"
+#include "core/layer/layer_controller.h"
+
+namespace caps::bench {
+
+// Shapes of key traffic the layer sees while CapsLock is held.
+enum class KeyMix {
+    kMapped,   // press/release pairs of keys the generated config maps
+    kUnmapped, // press/release pairs of keys no generated config names
+    kModifier, // press/release pairs of declared layer modifiers
+    kRepeat,   // one press, a run of auto-repeat presses, one release
+};
+
+inline const char* KeyMixName(KeyMix mix) {
+    switch (mix) {
+        case KeyMix::kMapped:
+            return "mapped";
+        case KeyMix::kUnmapped:
+            return "unmapped";
+        case KeyMix::kModifier:
+            return "modifier";
+        case KeyMix::kRepeat:
+            return "repeat";
+    }
+    return "?";
+}
+
+// Deterministic stream of `events` key events for `mix`, over the vocabulary of
+// GenerateConfig(..., modifiers, ...). Events carry no app so the layer's resolver path
+// runs; the same arguments always give the same stream.
+inline std::vector<core::KeyEvent> GenerateKeyStream(KeyMix mix,
+                                                     std::size_t events,
+                                                     std::size_t modifiers = 4,
+                                                     std::uint32_t seed = kDefaultSeed) {
+    static constexpr const char* kUnnamed[] = {"1", "2", "3", "4", "5", "6", "7", "8", "9", "0"};
+    constexpr std::size_t kRepeatRun = 30; // about one second of auto-repeat
+    if (modifiers > kModifierCount) {
+        modifiers = kModifierCount;
+    }
+    if (modifiers == 0 && mix == KeyMix::kModifier) {
+        modifiers = 1;
+    }
+
+    Xorshift next(seed);
+    std::vector<core::KeyEvent> stream;
+    stream.reserve(events + kRepeatRun + 2);
+    while (stream.size() < events) {
+        switch (mix) {
+            case KeyMix::kMapped:
+            case KeyMix::kUnmapped:
+            case KeyMix::kModifier: {
+                const char* key = mix == KeyMix::kMapped     ? kSources[next() % kSourceCount]
+                                  : mix == KeyMix::kUnmapped ? kUnnamed[next() % (sizeof(kUnnamed) / sizeof(*kUnnamed))]
+                                                             : kModifiers[next() % modifiers];
+                stream.push_back({key, "", true});
+                stream.push_back({key, "", false});
+                break;
+            }
+            case KeyMix::kRepeat: {
+                const char* key = kSources[next() % kSourceCount];
+                for (std::size_t i = 0; i < kRepeatRun + 1; ++i) {
+                    stream.push_back({key, "", true});
+                }
+                stream.push_back({key, "", false});
+                break;
+            }
+        }
+    }
+    return stream;
+}
+
+} // namespace caps::bench
@@ -3,10 +3,20 @@
 // CapsUnlocked core: central wiring point that stitches config, mapping, and
 // layer controller services together for platform entry points.
 
+#include <chrono>
+#include <exception>
+
 #include "core/logging.h"
 
 namespace caps::core {
 
+namespace {
+
+// Long enough to swallow an editor's save burst, short enough to feel instant.
+constexpr std::chrono::milliseconds kReloadDebounce{150};
+
+} // namespace
+
 AppContext::AppContext()
     : mapping_engine_(config_loader_),
       layer_controller_(mapping_engine_) {
@@ -16,12 +26,48 @@ AppContext::AppContext()
 // Platform main() calls this once after picking a config path to wire everything up.
 void AppContext::Initialize(const std::string& config_path) {
     logging::Info("[AppContext] Initializing with config " + config_path);
-    // Step 1: read the INI file so downstream services can see the new mappings.
+    config_path_ = config_path;
+    // Step 1: read the INI file so downstream services can see the new mappings. The
+    // compiled cache lets warm starts skip parsing entirely.
+    config_loader_.SetCacheEnabled(true);
     config_loader_.Load(config_path);
     // Step 2: ensure the mapping engine has fresh caches before it serves lookups.
     mapping_engine_.Initialize();
     mapping_engine_.UpdateFromConfig();
-    // TODO: Wire config change notifications and persist context state.
+    // Step 3: pick up config edits without restarting the process.
+    try {
+        if (auto backend = CreateDefaultWatchBackend()) {
+            WatchConfig(std::move(backend));
+        } else {
+            logging::Info("[AppContext] No config watcher on this platform; restart to apply config changes");
+        }
+    } catch (const std::exception& ex) {
+        logging::Warn(std::string("[AppContext] Config watcher unavailable: ") + ex.what());
+    }
+    // TODO: Persist context state.
+}
+
+// Parsing and compiling happen on the calling thread; the hook thread only sees the
+// finished snapshot swap.
+void AppContext::ReloadConfig() {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    try {
+        config_loader_.Reload();
+    } catch (const std::exception& ex) {
+        logging::Error(std::string("[AppContext] Config reload failed, keeping previous mappings: ") + ex.what());
+        return;
+    }
+    mapping_engine_.UpdateFromConfig();
+    const ConfigDelta& delta = config_loader_.LastDelta();
+    logging::Info(std::string("[AppContext] Config reloaded (") + (delta.full_reload ? "full" : "incremental") +
+                  "): " + delta.Summary());
+}
+
+void AppContext::WatchConfig(std::unique_ptr<FileWatchBackend> backend) {
+    config_watcher_.reset();
+    auto watcher = std::make_unique<ConfigWatcher>(std::move(backend), kReloadDebounce, [this] { ReloadConfig(); });
+    watcher->Start(config_path_);
+    config_watcher_ = std::move(watcher);
 }
 
 ConfigLoader& AppContext::Config() {
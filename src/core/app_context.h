@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "core/config/config_loader.h"
+#include "core/config/config_watcher.h"
 #include "core/layer/layer_controller.h"
 #include "core/mapping/mapping_engine.h"
 
@@ -15,7 +18,14 @@ public:
     AppContext();
 
     // Loads the config, initializes dependent services, and wires them together.
+    // Also starts watching the config file when the platform has a watch backend.
     void Initialize(const std::string& config_path);
+    // Re-reads the config and publishes the new mappings. A broken config is logged and
+    // the current mappings stay live. Safe to call from any thread.
+    void ReloadConfig();
+    // Hot-reloads the config whenever `backend` reports a change. Replaces any
+    // previous watcher; lets platforms without a built-in backend plug one in.
+    void WatchConfig(std::unique_ptr<FileWatchBackend> backend);
 
     ConfigLoader& Config();
     MappingEngine& Mapping();
@@ -25,6 +35,10 @@ private:
     ConfigLoader config_loader_;
     MappingEngine mapping_engine_;
     LayerController layer_controller_;
+    std::string config_path_;
+    std::mutex reload_mutex_; // serializes reloads from the watcher and callers
+    // Declared last so its thread stops before the services it reloads are destroyed.
+    std::unique_ptr<ConfigWatcher> config_watcher_;
 };
 
 } // namespace caps::core
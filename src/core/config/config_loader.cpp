@@ -3,18 +3,142 @@
 #include <algorithm>
 #include <cctype>
 #include <fstream>
-#include <regex>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+
+#include "core/config/default_mappings.h"
+#include "core/logging.h"
+#include "core/mapping/action_program.h"
+#include "core/mapping/key_codes.h"
+#include "core/mapping/compiled_table.h"
 
 namespace caps::core {
 
 namespace {
 
+// Image flag bits stored alongside the compiled cache.
+constexpr std::uint32_t kFlagHasModifiersSection = 1u << 0;
+
+// Slurps the whole file; false when it cannot be opened.
+bool ReadWholeFile(const std::string& path, std::string& contents) {
+    // Binary mode keeps tellg() honest on Windows; stray '\r' is trimmed like any whitespace.
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream.seekg(0, std::ios::end);
+    const std::streamoff size = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+    contents.assign(static_cast<std::size_t>(size > 0 ? size : 0), '\0');
+    stream.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+    contents.resize(static_cast<std::size_t>(stream.gcount()));
+    return true;
+}
+
+bool IsSpace(char ch) {
+    return std::isspace(static_cast<unsigned char>(ch)) != 0;
+}
+
+char Upper(char ch) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+}
+
+std::string_view TrimView(std::string_view value) {
+    std::size_t begin = 0;
+    while (begin < value.size() && IsSpace(value[begin])) {
+        ++begin;
+    }
+    std::size_t end = value.size();
+    while (end > begin && IsSpace(value[end - 1])) {
+        --end;
+    }
+    return value.substr(begin, end - begin);
+}
+
+// Case-insensitive ASCII comparison; `upper` must already be uppercase.
+bool EqualsUpper(std::string_view value, std::string_view upper) {
+    if (value.size() != upper.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (Upper(value[i]) != upper[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pops the next whitespace-delimited token off the front of `rest`. Returns an empty
+// view once the input is exhausted.
+std::string_view NextToken(std::string_view& rest) {
+    std::size_t begin = 0;
+    while (begin < rest.size() && IsSpace(rest[begin])) {
+        ++begin;
+    }
+    std::size_t end = begin;
+    while (end < rest.size() && !IsSpace(rest[end])) {
+        ++end;
+    }
+    const std::string_view token = rest.substr(begin, end - begin);
+    rest.remove_prefix(end);
+    return token;
+}
+
+// Same rules as ConfigLoader::NormalizeKeyToken (uppercase, inner whitespace runs
+// collapsed to one space) without the intermediate trimmed copy.
+std::string NormalizeKeyView(std::string_view token) {
+    const std::string_view trimmed = TrimView(token);
+    if (trimmed.empty()) {
+        throw std::runtime_error("Empty key token in config file");
+    }
+
+    std::string normalized;
+    normalized.reserve(trimmed.size());
+    bool previous_was_space = false;
+    for (char ch : trimmed) {
+        if (IsSpace(ch)) {
+            if (!previous_was_space) {
+                normalized.push_back(' ');
+                previous_was_space = true;
+            }
+            continue;
+        }
+        previous_was_space = false;
+        normalized.push_back(Upper(ch));
+    }
+    return normalized;
+}
+
+// Hooks report keys the shared key table names by that name ("LEFT") rather than by
+// native code, so a hex key token ("0x7B" on macOS) is stored under the same spelling.
+// Named tokens are kept as written.
+std::string NormalizeKeyName(std::string_view token) {
+    std::string normalized = NormalizeKeyView(token);
+    if (IsNativeKey(LookupKeyName(normalized))) {
+        const std::string_view canonical = CanonicalKeyToken(normalized);
+        if (!canonical.empty()) {
+            normalized.assign(canonical.data(), canonical.size());
+        }
+    }
+    return normalized;
+}
+
+// Aliases ("ESCAPE", "SHIFT") are fine in targets, but hooks only ever report the
+// canonical name, so a source or modifier spelled as an alias cannot match.
+void WarnIfAliasKey(const std::string& key, size_t line_number) {
+    const std::string_view canonical = CanonicalKeyToken(key);
+    if (!canonical.empty() && canonical != key) {
+        logging::Warn("[ConfigLoader] Line " + std::to_string(line_number) + ": key '" + key +
+                      "' is reported as '" + std::string(canonical) + "'; use that name for it to match");
+    }
+}
+
 // Returns true if the current line begins with comment prefixes after trimming.
-bool IsComment(const std::string& line) {
+bool IsComment(std::string_view line) {
     for (char ch : line) {
-        if (std::isspace(static_cast<unsigned char>(ch))) {
+        if (IsSpace(ch)) {
             continue;
         }
         return ch == '#' || ch == ';';
@@ -25,42 +149,35 @@ bool IsComment(const std::string& line) {
 // Section type enumeration for INI parsing
 enum class SectionType { None, Maps, Modifiers };
 
-// Parse a section header like [modifiers] or [maps]
+// Parse a section header like [modifiers] or [maps] (expects a trimmed line)
 // Returns the section type if recognized, or None if unrecognized
-SectionType ParseSectionHeader(const std::string& line) {
-    std::string trimmed = ConfigLoader::Trim(line);
-    if (trimmed.empty() || trimmed.front() != '[' || trimmed.back() != ']') {
+SectionType ParseSectionHeader(std::string_view trimmed) {
+    if (trimmed.size() < 2 || trimmed.front() != '[' || trimmed.back() != ']') {
         return SectionType::None;
     }
-    
-    std::string section_name = trimmed.substr(1, trimmed.size() - 2);
-    // Normalize to lowercase for comparison
-    std::transform(section_name.begin(), section_name.end(), section_name.begin(),
-                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    
-    if (section_name == "modifiers") {
+
+    const std::string_view section_name = trimmed.substr(1, trimmed.size() - 2);
+    if (EqualsUpper(section_name, "MODIFIERS")) {
         return SectionType::Modifiers;
     }
-    if (section_name == "maps") {
+    if (EqualsUpper(section_name, "MAPS")) {
         return SectionType::Maps;
     }
     return SectionType::None;
 }
 
 // Check if a line is a section header (single bracket group only, e.g. [modifiers] or [maps])
-bool IsSectionHeader(const std::string& line) {
-    std::string trimmed = ConfigLoader::Trim(line);
+bool IsSectionHeader(std::string_view trimmed) {
     if (trimmed.empty() || trimmed.front() != '[') {
         return false;
     }
     // Find the first closing bracket
-    size_t close = trimmed.find(']');
-    if (close == std::string::npos) {
+    const std::size_t close = trimmed.find(']');
+    if (close == std::string_view::npos) {
         return false;
     }
     // Section header: nothing after the first closing bracket (except whitespace)
-    std::string after = ConfigLoader::Trim(trimmed.substr(close + 1));
-    return after.empty();
+    return TrimView(trimmed.substr(close + 1)).empty();
 }
 
 // Parse bracket-delimited tokens from a mapping line
@@ -78,118 +195,314 @@ struct ParsedMapping {
     bool skip{false}; // true when OS filter does not match current platform
 };
 
-std::string ToUpperNoSpace(const std::string& value) {
-    std::string out;
-    out.reserve(value.size());
-    for (char ch : value) {
-        if (std::isspace(static_cast<unsigned char>(ch))) {
-            continue;
-        }
-        out.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
-    }
-    return out;
-}
+enum class OsFilter { None, Current, Other };
 
-bool MatchesCurrentPlatform(const std::string& os_token) {
-    const std::string upper = ToUpperNoSpace(os_token);
-    if (upper == "MAC" || upper == "MACOS") {
+OsFilter ClassifyOsToken(std::string_view token) {
+    if (EqualsUpper(token, "MAC") || EqualsUpper(token, "MACOS")) {
 #if defined(__APPLE__)
-        return true;
+        return OsFilter::Current;
 #else
-        return false;
+        return OsFilter::Other;
 #endif
     }
-    if (upper == "WIN" || upper == "WINDOWS" || upper == "WIN32" || upper == "WIN64") {
+    if (EqualsUpper(token, "WIN") || EqualsUpper(token, "WINDOWS") ||
+        EqualsUpper(token, "WIN32") || EqualsUpper(token, "WIN64")) {
 #if defined(_WIN32)
-        return true;
+        return OsFilter::Current;
 #else
-        return false;
+        return OsFilter::Other;
 #endif
     }
-    return false;
+    return OsFilter::None;
 }
 
-ParsedMapping ParseMappingLine(const std::string& line, size_t line_number) {
+// Single pass over the line: bracket groups are sliced as views and only the final
+// normalized tokens are materialized.
+ParsedMapping ParseMappingLine(std::string_view line, size_t line_number) {
     ParsedMapping result;
-    
-    // Match bracket groups: [content] - static regex to avoid recompilation overhead
-    static const std::regex bracket_regex(R"(\[([^\]]*)\])");
-    std::vector<std::string> groups;
-    
-    auto begin = std::sregex_iterator(line.begin(), line.end(), bracket_regex);
-    auto end = std::sregex_iterator();
-    
-    for (auto it = begin; it != end; ++it) {
-        groups.push_back((*it)[1].str());
-    }
-    
-    if (groups.size() == 3) {
-        // Format: [app] [mods? source] [target]
-        std::istringstream app_stream(ConfigLoader::Trim(groups[0]));
-        std::vector<std::string> app_tokens;
-        std::string app_token;
-        while (app_stream >> app_token) {
-            app_tokens.push_back(app_token);
+
+    // Collect [content] groups; text outside brackets is ignored and an unterminated
+    // '[' ends the scan, matching the previous regex-based grammar.
+    constexpr std::size_t kMaxGroups = 3;
+    std::string_view groups[kMaxGroups];
+    std::size_t group_count = 0;
+    std::size_t pos = 0;
+    while (true) {
+        const std::size_t open = line.find('[', pos);
+        if (open == std::string_view::npos) {
+            break;
         }
-        if (app_tokens.empty()) {
-            result.error = "Invalid config line " + std::to_string(line_number) + ": empty app token";
-            return result;
+        const std::size_t close = line.find(']', open + 1);
+        if (close == std::string_view::npos) {
+            break;
         }
-
-        size_t app_index = 0;
-        if (app_tokens.size() >= 2 && MatchesCurrentPlatform(app_tokens[0])) {
-            app_index = 1; // skip platform token
-        } else if (app_tokens.size() >= 2 && (ToUpperNoSpace(app_tokens[0]) == "MAC" || ToUpperNoSpace(app_tokens[0]) == "MACOS" ||
-                                              ToUpperNoSpace(app_tokens[0]) == "WIN" || ToUpperNoSpace(app_tokens[0]) == "WINDOWS" ||
-                                              ToUpperNoSpace(app_tokens[0]) == "WIN32" || ToUpperNoSpace(app_tokens[0]) == "WIN64")) {
-            result.skip = true; // OS token present but not matching current platform
-            result.valid = true;
-            return result;
+        if (group_count < kMaxGroups) {
+            groups[group_count] = line.substr(open + 1, close - open - 1);
         }
+        ++group_count;
+        pos = close + 1;
+    }
 
-        std::string app_raw;
-        for (; app_index < app_tokens.size(); ++app_index) {
-            app_raw += app_tokens[app_index];
-        }
-        result.app = ConfigLoader::NormalizeAppToken(app_raw);
+    if (group_count != kMaxGroups) {
+        result.error = "Invalid config line " + std::to_string(line_number) +
+                      ": expected '[app] [source] [target]' or '[app] [mods source] [target]'";
+        return result;
+    }
 
-        std::istringstream src_stream(ConfigLoader::Trim(groups[1]));
-        std::string token;
-        while (src_stream >> token) {
-            result.modifiers.push_back(ConfigLoader::NormalizeKeyToken(token));
+    // Format: [app] [mods? source] [target]
+    std::string_view app_rest = groups[0];
+    std::string_view app_token = NextToken(app_rest);
+    if (app_token.empty()) {
+        result.error = "Invalid config line " + std::to_string(line_number) + ": empty app token";
+        return result;
+    }
+
+    // An OS filter only counts when an app token follows it.
+    std::string_view after_os = app_rest;
+    if (!NextToken(after_os).empty()) {
+        switch (ClassifyOsToken(app_token)) {
+            case OsFilter::Current:
+                app_token = NextToken(app_rest); // skip platform token
+                break;
+            case OsFilter::Other:
+                result.skip = true; // OS token present but not matching current platform
+                result.valid = true;
+                return result;
+            case OsFilter::None:
+                break;
         }
-        if (result.modifiers.empty()) {
-            result.error = "Invalid config line " + std::to_string(line_number) +
-                           ": missing source key in second bracket";
-            return result;
+    }
+
+    // Remaining app tokens are concatenated, uppercased, with whitespace dropped.
+    for (; !app_token.empty(); app_token = NextToken(app_rest)) {
+        for (char ch : app_token) {
+            result.app.push_back(Upper(ch));
         }
-        result.source = std::move(result.modifiers.back());
-        result.modifiers.pop_back(); // remaining tokens are modifiers
+    }
 
-        result.target = ConfigLoader::NormalizeKeyToken(ConfigLoader::Trim(groups[2]));
-        result.valid = true;
-    } else {
+    std::string_view src_rest = groups[1];
+    for (std::string_view token = NextToken(src_rest); !token.empty(); token = NextToken(src_rest)) {
+        result.modifiers.push_back(NormalizeKeyName(token));
+    }
+    if (result.modifiers.empty()) {
         result.error = "Invalid config line " + std::to_string(line_number) +
-                      ": expected '[app] [source] [target]' or '[app] [mods source] [target]'";
+                       ": missing source key in second bracket";
+        return result;
     }
-    
+    result.source = std::move(result.modifiers.back());
+    result.modifiers.pop_back(); // remaining tokens are modifiers
+
+    result.target = NormalizeKeyView(groups[2]);
+    result.valid = true;
     return result;
 }
 
+// Parses one mapping line and enforces the [modifiers] rules against the declarations seen
+// so far. Returns false when the line's OS filter excludes this platform.
+bool ParseDefinitionLine(std::string_view trimmed, size_t line_number, const std::set<std::string>& modifiers,
+                         bool has_modifiers_section, std::string& app, MappingDefinition& def) {
+    auto parsed = ParseMappingLine(trimmed, line_number);
+    if (!parsed.valid) {
+        throw std::runtime_error(parsed.error);
+    }
+    if (parsed.skip) {
+        return false; // OS-filtered mapping not for this platform
+    }
+
+    // Validation: if modifiers section exists, check constraints
+    if (has_modifiers_section) {
+        // Check that source key is not a modifier (unless it's in the modifier list)
+        if (modifiers.count(parsed.source) > 0) {
+            throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
+                                   ": source key '" + parsed.source + 
+                                   "' is declared as a modifier and cannot be used as a source key");
+        }
+        
+        // Check that target key is not a modifier
+        // Note: target could be space-separated for multi-key output
+        std::string_view target_rest = parsed.target;
+        for (std::string_view target_key = NextToken(target_rest); !target_key.empty();
+             target_key = NextToken(target_rest)) {
+            if (modifiers.count(std::string(target_key)) > 0) {
+                throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
+                                       ": target key '" + std::string(target_key) + 
+                                       "' is declared as a modifier and cannot be used as a target key");
+            }
+        }
+        
+        // Check that all modifiers in the mapping are defined
+        for (const auto& mod : parsed.modifiers) {
+            if (modifiers.count(mod) == 0) {
+                throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
+                                       ": modifier '" + mod + 
+                                       "' used in mapping but not declared in [modifiers] section");
+            }
+        }
+    }
+
+    WarnIfAliasKey(parsed.source, line_number);
+    for (const auto& mod : parsed.modifiers) {
+        WarnIfAliasKey(mod, line_number);
+    }
+
+    // The table compiles every target into key ops; say once here, rather than on every
+    // press, when one will not emit anything.
+    std::string_view bad_token;
+    switch (CompileAction(parsed.target, [](ActionOp) {}, &bad_token)) {
+        case ActionError::kUnknownKey:
+            logging::Warn("[ConfigLoader] Line " + std::to_string(line_number) + ": unknown key '" +
+                          std::string(bad_token) + "' in target '" + parsed.target + "'; the mapping emits nothing");
+            break;
+        case ActionError::kDanglingHold:
+            logging::Warn("[ConfigLoader] Line " + std::to_string(line_number) + ": hold '" + std::string(bad_token) +
+                          "' has no following key in target '" + parsed.target + "'; the mapping emits nothing");
+            break;
+        case ActionError::kTooManyHolds:
+            logging::Warn("[ConfigLoader] Line " + std::to_string(line_number) + ": hold '" + std::string(bad_token) +
+                          "' nests deeper than " + std::to_string(kMaxActionHolds) + " holds in target '" +
+                          parsed.target + "'; the mapping emits nothing");
+            break;
+        case ActionError::kEmpty:
+        case ActionError::kNone:
+            break;
+    }
+
+    app = std::move(parsed.app);
+    def.source = std::move(parsed.source);
+    def.target = std::move(parsed.target);
+    def.required_mods = std::move(parsed.modifiers);
+    return true;
+}
+
+// Lines as ParseConfigText counts them: a trailing newline does not start another line.
+std::size_t CountLines(std::string_view text) {
+    const auto newlines = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    return newlines + (!text.empty() && text.back() != '\n' ? 1 : 0);
+}
+
+// Appends (app, source) for every source whose ordered definitions differ between the lists.
+void CollectChangedGroups(const std::string& app,
+                          const MappingDefinition* before, std::size_t before_count,
+                          const MappingDefinition* after, std::size_t after_count,
+                          std::vector<std::pair<std::string, std::string>>& changed) {
+    using Group = std::vector<const MappingDefinition*>;
+    std::map<std::string_view, std::pair<Group, Group>> groups;
+    for (std::size_t i = 0; i < before_count; ++i) {
+        groups[before[i].source].first.push_back(&before[i]);
+    }
+    for (std::size_t i = 0; i < after_count; ++i) {
+        groups[after[i].source].second.push_back(&after[i]);
+    }
+    for (const auto& [source, lists] : groups) {
+        const bool same = std::equal(lists.first.begin(), lists.first.end(), lists.second.begin(),
+                                     lists.second.end(),
+                                     [](const MappingDefinition* lhs, const MappingDefinition* rhs) {
+                                         return *lhs == *rhs;
+                                     });
+        if (!same) {
+            changed.emplace_back(app, std::string(source));
+        }
+    }
+}
+
+// Replays table edits on the definitions they were computed from.
+void SpliceEdits(ConfigLoader::MappingTable& mappings, const std::vector<CompiledTable::Edit>& edits) {
+    for (const auto& edit : edits) {
+        auto& defs = mappings[edit.app];
+        const auto first = defs.begin() + edit.index;
+        const auto position = defs.erase(first, first + edit.removed);
+        defs.insert(position, edit.inserted.begin(), edit.inserted.end());
+        if (defs.empty()) {
+            mappings.erase(edit.app);
+        }
+    }
+}
+
 } // namespace
 
-ConfigLoader::ConfigLoader()
-    : mappings_(BuildDefaultMappings()),
-      modifiers_(BuildDefaultModifiers()),
-      has_modifiers_section_(true) {}
+bool operator==(const MappingDefinition& lhs, const MappingDefinition& rhs) {
+    return lhs.source == rhs.source && lhs.target == rhs.target && lhs.required_mods == rhs.required_mods;
+}
+
+bool operator!=(const MappingDefinition& lhs, const MappingDefinition& rhs) {
+    return !(lhs == rhs);
+}
+
+bool ConfigDelta::Empty() const {
+    return changed_groups.empty() && modifiers_added.empty() && modifiers_removed.empty();
+}
+
+std::string ConfigDelta::Summary() const {
+    if (Empty()) {
+        return "no changes";
+    }
+    // Enough to recognize a hand edit without flooding the log after a bulk rewrite.
+    constexpr std::size_t kMaxListedGroups = 5;
+
+    std::ostringstream output;
+    output << changed_groups.size() << (changed_groups.size() == 1 ? " group" : " groups") << " changed";
+    if (!changed_groups.empty()) {
+        output << " (";
+        const std::size_t listed = std::min(changed_groups.size(), kMaxListedGroups);
+        for (std::size_t i = 0; i < listed; ++i) {
+            if (i > 0) output << ", ";
+            output << "[" << changed_groups[i].first << "] " << changed_groups[i].second;
+        }
+        if (changed_groups.size() > listed) {
+            output << ", ...";
+        }
+        output << ")";
+    }
+    if (!modifiers_added.empty() || !modifiers_removed.empty()) {
+        output << ", modifiers";
+        for (const auto& mod : modifiers_added) output << " +" << mod;
+        for (const auto& mod : modifiers_removed) output << " -" << mod;
+    }
+    return output.str();
+}
+
+ConfigLoader::ConfigLoader() {
+    ApplyDefaults();
+}
 
 // Reads the config at `path`, remembering it so Reload() can reuse the same source.
 void ConfigLoader::Load(const std::string& path) {
     config_path_ = path;
-    auto result = ParseConfigFile(path);
-    mappings_ = std::move(result.mappings);
-    modifiers_ = std::move(result.modifiers);
-    has_modifiers_section_ = result.has_modifiers_section;
+    last_delta_ = ConfigDelta{};
+    std::string contents;
+    if (!ReadWholeFile(path, contents)) {
+        ApplyDefaults();
+        return;
+    }
+    const std::uint64_t hash = HashContents(contents);
+    LoadContents(std::move(contents), hash);
+}
+
+void ConfigLoader::LoadContents(std::string contents, std::uint64_t hash) {
+    if (cache_enabled_) {
+        const std::string cache_path = CachePath(config_path_);
+        std::uint32_t flags = 0;
+        if (auto cached = CompiledTable::LoadImage(cache_path, hash, &flags)) {
+            compiled_ = std::move(cached);
+            has_modifiers_section_ = (flags & kFlagHasModifiersSection) != 0;
+            mappings_.clear();
+            mappings_pending_ = true;
+            modifiers_.clear();
+            modifiers_pending_ = true;
+            loaded_from_cache_ = true;
+            // No line table without a parse, so the next edit takes a full reload.
+            incremental_ready_ = false;
+            contents_.clear();
+            contents_hash_ = hash;
+            definition_lines_.clear();
+            CAPS_LOG_DEBUG(Config, "[ConfigLoader] Using compiled cache " << cache_path);
+            return;
+        }
+    }
+
+    ParseResult result = ParseConfigText(contents);
+    Apply(std::move(result), std::move(contents), hash);
+    WriteCache(hash);
 }
 
 // Convenience helper for hot-reloads; uses the last path passed into Load().
@@ -198,17 +511,295 @@ void ConfigLoader::Reload() {
         throw std::runtime_error("ConfigLoader::Reload called before Load");
     }
 
-    auto result = ParseConfigFile(config_path_);
+    std::string contents;
+    const bool exists = ReadWholeFile(config_path_, contents);
+    const std::uint64_t hash = HashContents(contents);
+    if (exists) {
+        // Editors and sync tools often rewrite identical bytes; skip those outright.
+        const bool unchanged = incremental_ready_ ? contents == contents_ : contents_hash_ == hash;
+        if (unchanged) {
+            last_delta_ = ConfigDelta{};
+            last_delta_.full_reload = false;
+            return;
+        }
+        if (incremental_ready_ && TryIncrementalReload(contents, hash)) {
+            return;
+        }
+    }
+
+    const MappingTable before = Mappings();
+    const ModifierSet before_modifiers = Modifiers();
+    if (exists) {
+        LoadContents(std::move(contents), hash);
+    } else {
+        ApplyDefaults();
+    }
+
+    ConfigDelta delta = Diff(before, Mappings());
+    const ModifierSet& after_modifiers = Modifiers();
+    std::set_difference(after_modifiers.begin(), after_modifiers.end(), before_modifiers.begin(),
+                        before_modifiers.end(), std::inserter(delta.modifiers_added, delta.modifiers_added.end()));
+    std::set_difference(before_modifiers.begin(), before_modifiers.end(), after_modifiers.begin(),
+                        after_modifiers.end(), std::inserter(delta.modifiers_removed, delta.modifiers_removed.end()));
+    last_delta_ = std::move(delta);
+}
+
+// Narrows the edit to the lines between the longest common prefix and suffix of the old
+// and new bytes, reparses just those, and patches the compiled table. Returns false (with
+// nothing changed) when the edit reaches section headers or [modifiers], or would empty
+// the config, since those need the full parse.
+bool ConfigLoader::TryIncrementalReload(const std::string& contents, std::uint64_t hash) {
+    const std::string& old = contents_;
+    const std::size_t limit = std::min(old.size(), contents.size());
+    std::size_t begin = 0;
+    while (begin < limit && old[begin] == contents[begin]) {
+        ++begin;
+    }
+    while (begin > 0 && old[begin - 1] != '\n') {
+        --begin;
+    }
+    std::size_t suffix = 0;
+    while (suffix < limit - begin && old[old.size() - 1 - suffix] == contents[contents.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    std::size_t old_end = old.size() - suffix;
+    std::size_t new_end = contents.size() - suffix;
+    const auto at_line_start = [](const std::string& text, std::size_t pos) {
+        return pos == 0 || text[pos - 1] == '\n';
+    };
+    if (!at_line_start(old, old_end) || !at_line_start(contents, new_end)) {
+        // The suffix is shared, so its next newline sits at the same offset in both.
+        const std::size_t newline = old.find('\n', old_end);
+        const std::size_t advance = newline == std::string::npos ? suffix : newline + 1 - old_end;
+        old_end += advance;
+        new_end += advance;
+    }
+
+    const auto first_line = static_cast<std::uint32_t>(std::count(old.begin(), old.begin() + begin, '\n'));
+    const std::string_view new_middle(contents.data() + begin, new_end - begin);
+    const auto old_count = static_cast<std::uint32_t>(CountLines(std::string_view(old).substr(begin, old_end - begin)));
+    const auto new_count = static_cast<std::uint32_t>(CountLines(new_middle));
+    if (ends_in_modifiers_ || first_line < structure_end_) {
+        return false;
+    }
+
+    MappingTable inserted;
+    LineTable inserted_lines;
+    std::size_t line_number = first_line;
+    for (std::size_t line_begin = 0; line_begin < new_middle.size();) {
+        std::size_t line_end = new_middle.find('\n', line_begin);
+        if (line_end == std::string_view::npos) {
+            line_end = new_middle.size();
+        }
+        const std::string_view trimmed = TrimView(new_middle.substr(line_begin, line_end - line_begin));
+        line_begin = line_end + 1;
+
+        ++line_number;
+        if (trimmed.empty() || IsComment(trimmed)) {
+            continue;
+        }
+        if (IsSectionHeader(trimmed)) {
+            return false;
+        }
+        std::string app;
+        MappingDefinition def;
+        if (ParseDefinitionLine(trimmed, line_number, modifiers_, has_modifiers_section_, app, def)) {
+            inserted[app].push_back(std::move(def));
+            inserted_lines[app].push_back(static_cast<std::uint32_t>(line_number));
+        }
+    }
+
+    // Old definitions on lines [removed_begin, removed_end) are replaced by `inserted`.
+    const std::uint32_t removed_begin = first_line + 1;
+    const std::uint32_t removed_end = first_line + old_count + 1;
+    const auto removed_range = [&](const std::vector<std::uint32_t>& lines) {
+        const auto lo = std::lower_bound(lines.begin(), lines.end(), removed_begin);
+        const auto hi = std::lower_bound(lo, lines.end(), removed_end);
+        return std::make_pair(static_cast<std::uint32_t>(lo - lines.begin()),
+                              static_cast<std::uint32_t>(hi - lines.begin()));
+    };
+
+    std::set<std::string> touched;
+    std::size_t remaining = 0;
+    for (const auto& [app, lines] : definition_lines_) {
+        const auto [lo, hi] = removed_range(lines);
+        remaining += lines.size() - (hi - lo);
+        if (hi > lo) {
+            touched.insert(app);
+        }
+    }
+    for (const auto& [app, defs] : inserted) {
+        remaining += defs.size();
+        touched.insert(app);
+    }
+    if (remaining == 0) {
+        return false; // a full parse falls back to the defaults
+    }
+
+    ConfigDelta delta;
+    delta.full_reload = false;
+    std::vector<CompiledTable::Edit> edits;
+    static const std::vector<MappingDefinition> kNoDefinitions;
+    for (const auto& app : touched) {
+        CompiledTable::Edit edit;
+        edit.app = app;
+        const auto lines = definition_lines_.find(app);
+        if (lines != definition_lines_.end()) {
+            const auto [lo, hi] = removed_range(lines->second);
+            edit.index = lo;
+            edit.removed = hi - lo;
+        }
+        if (auto defs = inserted.find(app); defs != inserted.end()) {
+            edit.inserted = std::move(defs->second);
+        }
+
+        const auto existing = mappings_.find(app);
+        const auto& defs = existing != mappings_.end() ? existing->second : kNoDefinitions;
+        const MappingDefinition* removed = defs.data() + edit.index;
+        if (std::equal(removed, removed + edit.removed, edit.inserted.begin(), edit.inserted.end())) {
+            continue; // moved or reformatted, same definitions
+        }
+        CollectChangedGroups(app, removed, edit.removed, edit.inserted.data(), edit.inserted.size(),
+                             delta.changed_groups);
+        edits.push_back(std::move(edit));
+    }
+    std::sort(delta.changed_groups.begin(), delta.changed_groups.end());
+
+    // Compile before committing anything, as Apply() does.
+    std::shared_ptr<const CompiledTable> compiled = compiled_;
+    std::optional<MappingTable> rebuilt;
+    if (!edits.empty()) {
+        compiled = compiled_->Patch(edits);
+        if (!compiled) {
+            rebuilt = mappings_;
+            SpliceEdits(*rebuilt, edits);
+            compiled = CompiledTable::Build(*rebuilt, modifiers_);
+        }
+    }
+
+    if (rebuilt) {
+        mappings_ = std::move(*rebuilt);
+    } else {
+        SpliceEdits(mappings_, edits);
+    }
+    const std::int64_t shift = static_cast<std::int64_t>(new_count) - static_cast<std::int64_t>(old_count);
+    for (auto& [app, lines] : definition_lines_) {
+        const auto [lo, hi] = removed_range(lines);
+        for (auto it = lines.begin() + hi; it != lines.end(); ++it) {
+            *it = static_cast<std::uint32_t>(*it + shift);
+        }
+        const auto position = lines.erase(lines.begin() + lo, lines.begin() + hi);
+        if (auto added = inserted_lines.find(app); added != inserted_lines.end()) {
+            lines.insert(position, added->second.begin(), added->second.end());
+            inserted_lines.erase(added);
+        }
+    }
+    for (auto& [app, lines] : inserted_lines) {
+        definition_lines_.emplace(app, std::move(lines));
+    }
+    for (auto it = definition_lines_.begin(); it != definition_lines_.end();) {
+        it = it->second.empty() ? definition_lines_.erase(it) : std::next(it);
+    }
+
+    compiled_ = std::move(compiled);
+    loaded_from_cache_ = false;
+    contents_ = contents;
+    contents_hash_ = hash;
+    last_delta_ = std::move(delta);
+    if (!edits.empty()) {
+        WriteCache(hash);
+    }
+    CAPS_LOG_DEBUG(Config, "[ConfigLoader] Reparsed " << new_count << " edited line(s) from line " << removed_begin);
+    return true;
+}
+
+const ConfigDelta& ConfigLoader::LastDelta() const {
+    return last_delta_;
+}
+
+void ConfigLoader::SetCacheEnabled(bool enabled) {
+    cache_enabled_ = enabled;
+}
+
+bool ConfigLoader::LoadedFromCache() const {
+    return loaded_from_cache_;
+}
+
+// Compiles before committing anything so a config that fails to compile leaves the
+// previous state untouched.
+void ConfigLoader::Apply(ParseResult result, std::string contents, std::optional<std::uint64_t> hash) {
+    compiled_ = CompiledTable::Build(result.mappings, result.modifiers);
     mappings_ = std::move(result.mappings);
+    mappings_pending_ = false;
     modifiers_ = std::move(result.modifiers);
+    modifiers_pending_ = false;
     has_modifiers_section_ = result.has_modifiers_section;
+    loaded_from_cache_ = false;
+
+    incremental_ready_ = hash.has_value() && !result.used_defaults;
+    contents_ = incremental_ready_ ? std::move(contents) : std::string();
+    contents_hash_ = hash;
+    definition_lines_ = std::move(result.lines);
+    structure_end_ = result.structure_end;
+    ends_in_modifiers_ = result.ends_in_modifiers;
 }
 
+void ConfigLoader::WriteCache(std::uint64_t hash) const {
+    if (!cache_enabled_) {
+        return;
+    }
+    const std::string cache_path = CachePath(config_path_);
+    const std::uint32_t flags = has_modifiers_section_ ? kFlagHasModifiersSection : 0;
+    if (!compiled_->WriteImage(cache_path, hash, flags)) {
+        logging::Warn("[ConfigLoader] Could not write compiled cache " + cache_path);
+    }
+}
+
+// Groups are compared per source in priority order, so reordering two different keys'
+// lines is not a change but reordering two lines for the same key is.
+ConfigDelta ConfigLoader::Diff(const MappingTable& before, const MappingTable& after) {
+    ConfigDelta delta;
+    static const std::vector<MappingDefinition> kNoDefinitions;
+    std::set<std::string> apps;
+    for (const auto& [app, defs] : before) apps.insert(app);
+    for (const auto& [app, defs] : after) apps.insert(app);
+    for (const auto& app : apps) {
+        const auto old_defs = before.find(app);
+        const auto new_defs = after.find(app);
+        const auto& lhs = old_defs != before.end() ? old_defs->second : kNoDefinitions;
+        const auto& rhs = new_defs != after.end() ? new_defs->second : kNoDefinitions;
+        if (lhs != rhs) {
+            CollectChangedGroups(app, lhs.data(), lhs.size(), rhs.data(), rhs.size(), delta.changed_groups);
+        }
+    }
+    std::sort(delta.changed_groups.begin(), delta.changed_groups.end());
+    return delta;
+}
+
+// A cache hit or the compiled-in defaults only carry the compiled rows; turn them back
+// into definitions on demand.
+// Rows were compiled in MappingTable order, so this reproduces the parsed table exactly.
 const ConfigLoader::MappingTable& ConfigLoader::Mappings() const {
+    if (mappings_pending_) {
+        for (const auto& row : compiled_->Rows()) {
+            MappingDefinition def;
+            def.source = std::string(compiled_->KeyName(row.source));
+            def.target = std::string(compiled_->Action(row.action));
+            for (KeyId mod : compiled_->RowModifiers(row)) {
+                def.required_mods.emplace_back(compiled_->KeyName(mod));
+            }
+            mappings_[std::string(compiled_->AppName(row.app))].push_back(std::move(def));
+        }
+        mappings_pending_ = false;
+    }
     return mappings_;
 }
 
 const ConfigLoader::ModifierSet& ConfigLoader::Modifiers() const {
+    if (modifiers_pending_) {
+        modifiers_ = compiled_->Modifiers();
+        modifiers_pending_ = false;
+    }
     return modifiers_;
 }
 
@@ -216,30 +807,34 @@ bool ConfigLoader::HasModifiersSection() const {
     return has_modifiers_section_;
 }
 
+std::shared_ptr<const CompiledTable> ConfigLoader::Compiled() const {
+    return compiled_;
+}
+
 // Produces a quick human-readable summary that is handy for logging and debugging.
 std::string ConfigLoader::Describe() const {
     std::ostringstream output;
     size_t count = 0;
-    for (const auto& [app, definitions] : mappings_) {
+    for (const auto& [app, definitions] : Mappings()) {
         count += definitions.size();
     }
     output << "Config (" << count << " entries";
     if (has_modifiers_section_) {
-        output << ", " << modifiers_.size() << " modifiers";
+        output << ", " << Modifiers().size() << " modifiers";
     }
     output << ")";
     
-    if (has_modifiers_section_ && !modifiers_.empty()) {
+    if (has_modifiers_section_ && !Modifiers().empty()) {
         output << "\nModifiers: ";
         bool first = true;
-        for (const auto& mod : modifiers_) {
+        for (const auto& mod : Modifiers()) {
             if (!first) output << ", ";
             output << mod;
             first = false;
         }
     }
     
-    for (const auto& [app, definitions] : mappings_) {
+    for (const auto& [app, definitions] : Mappings()) {
         for (const auto& def : definitions) {
             output << "\n[" << app << "] ";
             if (!def.required_mods.empty()) {
@@ -256,31 +851,49 @@ std::string ConfigLoader::Describe() const {
     return output.str();
 }
 
-// Opens the ini file, parses sections and mapping lines.
-ConfigLoader::ParseResult ConfigLoader::ParseConfigFile(const std::string& path) const {
-    std::ifstream stream(path);
-    if (!stream.is_open()) {
-        ParseResult result;
-        result.mappings = BuildDefaultMappings();
-        result.modifiers = BuildDefaultModifiers();
-        result.has_modifiers_section = true;
-        return result;
-    }
+// Used when the config file does not exist. Points at the compiled-in table and leaves
+// the definition lists to be materialized on demand, so nothing is allocated or
+// normalized here; clearing the containers below only frees what an earlier load held.
+void ConfigLoader::ApplyDefaults() {
+    compiled_ = CompiledTable::Defaults();
+    mappings_.clear();
+    mappings_pending_ = true;
+    modifiers_.clear();
+    modifiers_pending_ = true;
+    has_modifiers_section_ = true;
+    loaded_from_cache_ = false;
+
+    incremental_ready_ = false;
+    contents_.clear();
+    contents_hash_.reset();
+    definition_lines_.clear();
+    structure_end_ = 0;
+    ends_in_modifiers_ = false;
+}
 
+// Parses sections and mapping lines from the raw INI bytes.
+ConfigLoader::ParseResult ConfigLoader::ParseConfigText(std::string_view text) const {
     ParseResult result;
-    std::string line;
     size_t line_number = 0;
     SectionType current_section = SectionType::None;
     
-    while (std::getline(stream, line)) {
+    for (std::size_t line_begin = 0; line_begin < text.size();) {
+        std::size_t line_end = text.find('\n', line_begin);
+        if (line_end == std::string_view::npos) {
+            line_end = text.size();
+        }
+        const std::string_view line = text.substr(line_begin, line_end - line_begin);
+        line_begin = line_end + 1;
+
         ++line_number;
-        const std::string trimmed = Trim(line);
+        const std::string_view trimmed = TrimView(line);
         if (trimmed.empty() || IsComment(trimmed)) {
             continue;
         }
 
         // Check for section header
         if (IsSectionHeader(trimmed)) {
+            result.structure_end = line_number;
             SectionType new_section = ParseSectionHeader(trimmed);
             if (new_section != SectionType::None) {
                 current_section = new_section;
@@ -295,57 +908,19 @@ ConfigLoader::ParseResult ConfigLoader::ParseConfigFile(const std::string& path)
         // Process line based on current section
         if (current_section == SectionType::Modifiers) {
             // Each line in [modifiers] is a single key name
-            std::string mod_key = NormalizeKeyToken(trimmed);
-            result.modifiers.insert(mod_key);
+            result.modifiers.insert(NormalizeKeyName(trimmed));
+            result.structure_end = line_number;
         } else {
             // Default section or [maps] section: parse mapping lines
-            auto parsed = ParseMappingLine(trimmed, line_number);
-            if (!parsed.valid) {
-                throw std::runtime_error(parsed.error);
-            }
-            if (parsed.skip) {
-                continue; // OS-filtered mapping not for this platform
-            }
-            
-            // Validation: if modifiers section exists, check constraints
-            if (result.has_modifiers_section) {
-                // Check that source key is not a modifier (unless it's in the modifier list)
-                if (result.modifiers.count(parsed.source) > 0) {
-                    throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
-                                           ": source key '" + parsed.source + 
-                                           "' is declared as a modifier and cannot be used as a source key");
-                }
-                
-                // Check that target key is not a modifier
-                // Note: target could be space-separated for multi-key output
-                std::istringstream target_stream(parsed.target);
-                std::string target_key;
-                while (target_stream >> target_key) {
-                    if (result.modifiers.count(target_key) > 0) {
-                        throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
-                                               ": target key '" + target_key + 
-                                               "' is declared as a modifier and cannot be used as a target key");
-                    }
-                }
-                
-                // Check that all modifiers in the mapping are defined
-                for (const auto& mod : parsed.modifiers) {
-                    if (result.modifiers.count(mod) == 0) {
-                        throw std::runtime_error("Invalid config line " + std::to_string(line_number) +
-                                               ": modifier '" + mod + 
-                                               "' used in mapping but not declared in [modifiers] section");
-                    }
-                }
-            }
-            
+            std::string app;
             MappingDefinition def;
-            def.source = parsed.source;
-            def.target = parsed.target;
-            def.required_mods = std::move(parsed.modifiers);
-            
-            result.mappings[parsed.app].push_back(std::move(def));
+            if (ParseDefinitionLine(trimmed, line_number, result.modifiers, result.has_modifiers_section, app, def)) {
+                result.lines[app].push_back(static_cast<std::uint32_t>(line_number));
+                result.mappings[app].push_back(std::move(def));
+            }
         }
     }
+    result.ends_in_modifiers = current_section == SectionType::Modifiers;
 
     if (result.mappings.empty()) {
         result.mappings = BuildDefaultMappings();
@@ -353,33 +928,46 @@ ConfigLoader::ParseResult ConfigLoader::ParseConfigFile(const std::string& path)
             result.modifiers = BuildDefaultModifiers();
         }
         result.has_modifiers_section = true;
+        result.used_defaults = true;
     }
 
     return result;
 }
 
-// Default arrow keys that keep the product useful when no config exists.
+// Default arrow keys that keep the product useful when no config exists; only needed
+// as definitions when a config declares no mappings of its own.
 ConfigLoader::MappingTable ConfigLoader::BuildDefaultMappings() {
-    return {
-        {"*", {
-            MappingDefinition{"J", "LEFT", {}},
-            MappingDefinition{"K", "DOWN", {}},
-            MappingDefinition{"I", "UP", {}},
-            MappingDefinition{"L", "RIGHT", {}},
-            MappingDefinition{"J", "HOME", {"D"}},
-            MappingDefinition{"K", "PAGEDOWN", {"D"}},
-            MappingDefinition{"I", "PAGEUP", {"D"}},
-            MappingDefinition{"L", "END", {"D"}},
-            MappingDefinition{"J", "SHIFT! LEFT", {"S"}},
-            MappingDefinition{"K", "SHIFT! DOWN", {"S"}},
-            MappingDefinition{"I", "SHIFT! UP", {"S"}},
-            MappingDefinition{"L", "SHIFT! RIGHT", {"S"}}
-        }},
-    };
+    MappingTable mappings;
+    for (const DefaultMapping& mapping : kDefaultMappings) {
+        MappingDefinition def;
+        def.source = std::string(mapping.source);
+        def.target = std::string(mapping.target);
+        for (const std::string_view& mod : mapping.required_mods) {
+            if (!mod.empty()) {
+                def.required_mods.emplace_back(mod);
+            }
+        }
+        mappings[std::string(mapping.app)].push_back(std::move(def));
+    }
+    return mappings;
 }
 
 ConfigLoader::ModifierSet ConfigLoader::BuildDefaultModifiers() {
-    return {"S", "D"};
+    return ModifierSet(std::begin(kDefaultModifiers), std::end(kDefaultModifiers));
+}
+
+// FNV-1a 64 over the raw file bytes; keys the compiled cache to the exact INI contents.
+std::uint64_t ConfigLoader::HashContents(std::string_view contents) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char ch : contents) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string ConfigLoader::CachePath(const std::string& path) {
+    return path + ".cache";
 }
 
 // Uppercases and strips whitespace so that config lookups become case-insensitive.
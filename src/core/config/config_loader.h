@@ -1,12 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace caps::core {
 
+class CompiledTable;
+
 // Represents a single key mapping with optional modifier requirements.
 struct MappingDefinition {
     std::string source;                       // Normalized source key
@@ -14,6 +21,23 @@ struct MappingDefinition {
     std::vector<std::string> required_mods;   // Modifiers that must be held (logical AND)
 };
 
+bool operator==(const MappingDefinition& lhs, const MappingDefinition& rhs);
+bool operator!=(const MappingDefinition& lhs, const MappingDefinition& rhs);
+
+// What the last Reload() changed, so callers can log it and skip no-op reloads.
+struct ConfigDelta {
+    // False when only the edited lines were reparsed and the compiled table patched.
+    bool full_reload{true};
+    // (app, source) groups whose definitions differ from before, sorted.
+    std::vector<std::pair<std::string, std::string>> changed_groups;
+    std::set<std::string> modifiers_added;
+    std::set<std::string> modifiers_removed;
+
+    [[nodiscard]] bool Empty() const;
+    // One line for logs, e.g. "2 groups changed ([*] J, [CHROME] K), modifiers +F".
+    [[nodiscard]] std::string Summary() const;
+};
+
 // Loads key remap definitions from disk and keeps a normalized copy that the
 // rest of the core can query without touching the filesystem again.
 class ConfigLoader {
@@ -26,14 +50,26 @@ public:
 
     // Reads mappings from the provided path, falling back to defaults when the
     // file is missing. Throws if the file exists but contains invalid syntax.
+    // With the cache enabled, a compiled image next to the file ("<path>.cache") is
+    // mapped instead of parsing when its content hash still matches the INI bytes.
     void Load(const std::string& path);
     // Re-reads the last successfully loaded file. Useful for hot-reload workflows.
+    // When the edit is confined to mapping lines, only the changed lines are reparsed and
+    // the compiled table is patched rather than rebuilt; LastDelta() reports the change.
     void Reload();
+    // Changes made by the last Reload(). After Load() it is a full reload listing nothing.
+    [[nodiscard]] const ConfigDelta& LastDelta() const;
+
+    // Off by default so tests and tools never leave files behind; AppContext turns it on.
+    void SetCacheEnabled(bool enabled);
+    [[nodiscard]] bool LoadedFromCache() const;
 
     [[nodiscard]] const MappingTable& Mappings() const;
     [[nodiscard]] const ModifierSet& Modifiers() const;
     [[nodiscard]] bool HasModifiersSection() const;
     [[nodiscard]] std::string Describe() const;
+    // Dispatch table compiled from the current mappings (or mapped from the cache).
+    [[nodiscard]] std::shared_ptr<const CompiledTable> Compiled() const;
 
     // Expose normalization utilities for external use
     [[nodiscard]] static std::string NormalizeKeyToken(const std::string& token);
@@ -41,20 +77,53 @@ public:
     [[nodiscard]] static std::string Trim(const std::string& value);
 
 private:
+    using LineTable = std::map<std::string, std::vector<std::uint32_t>>;
+
     struct ParseResult {
         MappingTable mappings;
         ModifierSet modifiers;
         bool has_modifiers_section{false};
+        // Source line of every definition, parallel to `mappings`.
+        LineTable lines;
+        // Last line that is a section header or belongs to [modifiers]. Later lines are all
+        // mapping lines, which is what makes splicing edits in safe.
+        std::size_t structure_end{0};
+        bool ends_in_modifiers{false};
+        bool used_defaults{false};
     };
 
-    [[nodiscard]] ParseResult ParseConfigFile(const std::string& path) const;
+    void ApplyDefaults();
+    [[nodiscard]] ParseResult ParseConfigText(std::string_view text) const;
+    void LoadContents(std::string contents, std::uint64_t hash);
+    void Apply(ParseResult result, std::string contents, std::optional<std::uint64_t> hash);
+    [[nodiscard]] bool TryIncrementalReload(const std::string& contents, std::uint64_t hash);
+    void WriteCache(std::uint64_t hash) const;
+    [[nodiscard]] static ConfigDelta Diff(const MappingTable& before, const MappingTable& after);
+    [[nodiscard]] static std::uint64_t HashContents(std::string_view contents);
+    [[nodiscard]] static std::string CachePath(const std::string& path);
     [[nodiscard]] static MappingTable BuildDefaultMappings();
     [[nodiscard]] static ModifierSet BuildDefaultModifiers();
 
     std::string config_path_;
-    MappingTable mappings_;
-    ModifierSet modifiers_;
+    // Rebuilt from compiled_ on first use after a cache hit or when running on the
+    // defaults; most runs never ask for them.
+    mutable MappingTable mappings_;
+    mutable bool mappings_pending_{false};
+    mutable ModifierSet modifiers_;
+    mutable bool modifiers_pending_{false};
     bool has_modifiers_section_{false};
+    bool cache_enabled_{false};
+    bool loaded_from_cache_{false};
+    std::shared_ptr<const CompiledTable> compiled_;
+    ConfigDelta last_delta_;
+
+    // State for incremental reloads; only valid after a successful text parse.
+    bool incremental_ready_{false};
+    std::string contents_;
+    std::optional<std::uint64_t> contents_hash_; // hash of the file behind the current state
+    LineTable definition_lines_;
+    std::size_t structure_end_{0};
+    bool ends_in_modifiers_{false};
 };
 
 } // namespace caps::core
@@ -0,0 +1,463 @@
+#include "config_watcher.h"
+
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#include "core/logging.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+
+#include <condition_variable>
+#include <mutex>
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <array>
+#include <string_view>
+#endif
+
+namespace caps::core {
+
+namespace {
+
+#if defined(__linux__)
+
+// inotify watch on the config's directory, filtered to the config's file name, plus an
+// eventfd so Interrupt() can wake poll().
+class InotifyWatchBackend final : public FileWatchBackend {
+public:
+    InotifyWatchBackend()
+        : inotify_fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+          wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (inotify_fd_ < 0 || wake_fd_ < 0) {
+            Close();
+            throw std::runtime_error(std::string("Could not create inotify watcher: ") + std::strerror(errno));
+        }
+    }
+
+    ~InotifyWatchBackend() override {
+        Close();
+    }
+
+    void Watch(const std::string& path) override {
+        const std::filesystem::path file(path);
+        std::string directory = file.parent_path().string();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        file_name_ = file.filename().string();
+        // Close-after-write covers in-place saves; moved-to covers write-and-rename saves.
+        if (inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            throw std::runtime_error("Could not watch " + directory + ": " + std::strerror(errno));
+        }
+    }
+
+    WaitResult WaitForChange(std::optional<std::chrono::milliseconds> timeout) override {
+        const auto deadline = std::chrono::steady_clock::now() + timeout.value_or(std::chrono::milliseconds(0));
+        while (true) {
+            int wait_ms = -1;
+            if (timeout) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                wait_ms = left.count() > 0 ? static_cast<int>(left.count()) : 0;
+            }
+
+            pollfd fds[2] = {{wake_fd_, POLLIN, 0}, {inotify_fd_, POLLIN, 0}};
+            const int ready = poll(fds, 2, wait_ms);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return WaitResult::Stopped;
+            }
+            if (fds[0].revents != 0) {
+                return WaitResult::Stopped;
+            }
+            if (ready == 0) {
+                return WaitResult::Timeout;
+            }
+            if (DrainMatchesFile()) {
+                return WaitResult::Changed;
+            }
+            // Only sibling files changed (including our own .cache); keep waiting.
+        }
+    }
+
+    void Interrupt() override {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto written = write(wake_fd_, &one, sizeof(one));
+    }
+
+private:
+    bool DrainMatchesFile() {
+        alignas(inotify_event) char buffer[4096];
+        bool matched = false;
+        while (true) {
+            const ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+            if (length <= 0) {
+                return matched;
+            }
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0 && file_name_ == event->name) {
+                    matched = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+    }
+
+    void Close() {
+        if (inotify_fd_ >= 0) {
+            close(inotify_fd_);
+        }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
+        inotify_fd_ = -1;
+        wake_fd_ = -1;
+    }
+
+    int inotify_fd_;
+    int wake_fd_;
+    std::string file_name_;
+};
+
+#elif defined(__APPLE__)
+
+// FSEvents stream on the config's directory with per-file events, delivered on a private
+// dispatch queue; the callback filters for the config's file name and wakes the waiter.
+class FsEventsWatchBackend final : public FileWatchBackend {
+public:
+    FsEventsWatchBackend() : queue_(dispatch_queue_create("capsunlocked.config-watch", DISPATCH_QUEUE_SERIAL)) {
+        if (!queue_) {
+            throw std::runtime_error("Could not create the FSEvents dispatch queue");
+        }
+    }
+
+    ~FsEventsWatchBackend() override {
+        if (stream_) {
+            // Once stopped and invalidated no callback runs, so `this` can go.
+            FSEventStreamStop(stream_);
+            FSEventStreamInvalidate(stream_);
+            FSEventStreamRelease(stream_);
+        }
+        dispatch_release(queue_);
+    }
+
+    void Watch(const std::string& path) override {
+        const std::filesystem::path file = std::filesystem::absolute(path);
+        const std::string directory = file.parent_path().string();
+        file_name_ = file.filename().string();
+
+        CFStringRef directory_ref =
+            CFStringCreateWithCString(kCFAllocatorDefault, directory.c_str(), kCFStringEncodingUTF8);
+        if (!directory_ref) {
+            throw std::runtime_error("Could not watch " + directory + ": bad path");
+        }
+        const void* paths_values[] = {directory_ref};
+        CFArrayRef paths = CFArrayCreate(kCFAllocatorDefault, paths_values, 1, &kCFTypeArrayCallBacks);
+        FSEventStreamContext context{0, this, nullptr, nullptr, nullptr};
+        stream_ = FSEventStreamCreate(kCFAllocatorDefault, &FsEventsWatchBackend::OnEvents, &context, paths,
+                                      kFSEventStreamEventIdSinceNow, kLatencySeconds,
+                                      kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer);
+        if (paths) {
+            CFRelease(paths);
+        }
+        CFRelease(directory_ref);
+        if (!stream_) {
+            throw std::runtime_error("Could not watch " + directory + ": FSEventStreamCreate failed");
+        }
+        FSEventStreamSetDispatchQueue(stream_, queue_);
+        if (!FSEventStreamStart(stream_)) {
+            throw std::runtime_error("Could not watch " + directory + ": FSEventStreamStart failed");
+        }
+    }
+
+    WaitResult WaitForChange(std::optional<std::chrono::milliseconds> timeout) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto ready = [this] { return stopped_ || changed_; };
+        if (timeout) {
+            if (!wake_.wait_for(lock, *timeout, ready)) {
+                return WaitResult::Timeout;
+            }
+        } else {
+            wake_.wait(lock, ready);
+        }
+        if (stopped_) {
+            return WaitResult::Stopped;
+        }
+        changed_ = false;
+        return WaitResult::Changed;
+    }
+
+    void Interrupt() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        wake_.notify_all();
+    }
+
+private:
+    // FSEvents coalesces within this window; the watcher debounces on top of it anyway.
+    static constexpr CFTimeInterval kLatencySeconds = 0.05;
+
+    static void OnEvents(ConstFSEventStreamRef,
+                         void* info,
+                         size_t count,
+                         void* event_paths,
+                         const FSEventStreamEventFlags*,
+                         const FSEventStreamEventId*) {
+        auto* self = static_cast<FsEventsWatchBackend*>(info);
+        const auto* const* paths = static_cast<const char* const*>(event_paths);
+        for (size_t i = 0; i < count; ++i) {
+            // Only the name is compared: FSEvents reports resolved paths (/private/var/...).
+            if (std::filesystem::path(paths[i]).filename() == self->file_name_) {
+                {
+                    std::lock_guard<std::mutex> lock(self->mutex_);
+                    self->changed_ = true;
+                }
+                self->wake_.notify_all();
+                return;
+            }
+        }
+        // Only sibling files changed (including our own .cache); nothing to report.
+    }
+
+    dispatch_queue_t queue_;
+    FSEventStreamRef stream_{nullptr};
+    std::string file_name_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool changed_{false};
+    bool stopped_{false};
+};
+
+#elif defined(_WIN32)
+
+// Overlapped ReadDirectoryChangesW on the config's directory, filtered to the config's
+// file name, plus a manual-reset event so Interrupt() can wake the wait.
+class DirectoryChangesWatchBackend final : public FileWatchBackend {
+public:
+    DirectoryChangesWatchBackend()
+        : stop_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+          io_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {
+        if (!stop_event_ || !io_event_) {
+            const DWORD error = GetLastError();
+            Close();
+            throw std::runtime_error("Could not create directory watcher events (error " + std::to_string(error) +
+                                     ")");
+        }
+    }
+
+    ~DirectoryChangesWatchBackend() override {
+        Close();
+    }
+
+    void Watch(const std::string& path) override {
+        const std::filesystem::path file(path);
+        std::filesystem::path directory = file.parent_path();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        file_name_ = file.filename().wstring();
+        directory_ = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                 FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Could not watch " + directory.string() + " (error " +
+                                     std::to_string(GetLastError()) + ")");
+        }
+        if (!Arm()) {
+            throw std::runtime_error("Could not watch " + directory.string() + ": ReadDirectoryChangesW failed (error " +
+                                     std::to_string(GetLastError()) + ")");
+        }
+    }
+
+    WaitResult WaitForChange(std::optional<std::chrono::milliseconds> timeout) override {
+        const auto deadline = std::chrono::steady_clock::now() + timeout.value_or(std::chrono::milliseconds(0));
+        while (true) {
+            DWORD wait_ms = INFINITE;
+            if (timeout) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                wait_ms = left.count() > 0 ? static_cast<DWORD>(left.count()) : 0;
+            }
+
+            const HANDLE handles[2] = {stop_event_, io_event_};
+            const DWORD result = WaitForMultipleObjects(2, handles, FALSE, wait_ms);
+            if (result == WAIT_TIMEOUT) {
+                return WaitResult::Timeout;
+            }
+            if (result != WAIT_OBJECT_0 + 1) {
+                return WaitResult::Stopped;
+            }
+            DWORD bytes = 0;
+            const bool matched = GetOverlappedResult(directory_, &overlapped_, &bytes, FALSE) && MatchesFile(bytes);
+            if (!Arm()) {
+                return WaitResult::Stopped;
+            }
+            if (matched) {
+                return WaitResult::Changed;
+            }
+            // Only sibling files changed (including our own .cache); keep waiting.
+        }
+    }
+
+    void Interrupt() override {
+        SetEvent(stop_event_);
+    }
+
+private:
+    // Queues the next read; the kernel collects changes between reads into the buffer.
+    bool Arm() {
+        ResetEvent(io_event_);
+        overlapped_ = OVERLAPPED{};
+        overlapped_.hEvent = io_event_;
+        // Last-write covers in-place saves; file-name covers write-and-rename saves.
+        return ReadDirectoryChangesW(directory_, buffer_.data(), static_cast<DWORD>(buffer_.size()), FALSE,
+                                     FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr,
+                                     &overlapped_, nullptr) != 0;
+    }
+
+    bool MatchesFile(DWORD bytes) const {
+        if (bytes == 0) {
+            return true; // the buffer overflowed and the entries were lost; assume the file was among them
+        }
+        std::size_t offset = 0;
+        while (true) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer_.data() + offset);
+            const std::wstring_view name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME &&
+                CompareStringOrdinal(name.data(), static_cast<int>(name.size()), file_name_.data(),
+                                     static_cast<int>(file_name_.size()), TRUE) == CSTR_EQUAL) {
+                return true;
+            }
+            if (info->NextEntryOffset == 0) {
+                return false;
+            }
+            offset += info->NextEntryOffset;
+        }
+    }
+
+    void Close() {
+        if (directory_ != INVALID_HANDLE_VALUE) {
+            // The pending read writes into buffer_; let the cancellation land before it goes.
+            if (CancelIoEx(directory_, &overlapped_)) {
+                DWORD bytes = 0;
+                GetOverlappedResult(directory_, &overlapped_, &bytes, TRUE);
+            }
+            CloseHandle(directory_);
+            directory_ = INVALID_HANDLE_VALUE;
+        }
+        if (io_event_) {
+            CloseHandle(io_event_);
+            io_event_ = nullptr;
+        }
+        if (stop_event_) {
+            CloseHandle(stop_event_);
+            stop_event_ = nullptr;
+        }
+    }
+
+    HANDLE stop_event_;
+    HANDLE io_event_;
+    HANDLE directory_{INVALID_HANDLE_VALUE};
+    OVERLAPPED overlapped_{};
+    std::wstring file_name_;
+    alignas(DWORD) std::array<char, 16 * 1024> buffer_{}; // FILE_NOTIFY_INFORMATION is DWORD-aligned
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<FileWatchBackend> CreateDefaultWatchBackend() {
+#if defined(__linux__)
+    return std::make_unique<InotifyWatchBackend>();
+#elif defined(__APPLE__)
+    return std::make_unique<FsEventsWatchBackend>();
+#elif defined(_WIN32)
+    return std::make_unique<DirectoryChangesWatchBackend>();
+#else
+    return nullptr;
+#endif
+}
+
+ConfigWatcher::ConfigWatcher(std::unique_ptr<FileWatchBackend> backend,
+                             std::chrono::milliseconds debounce,
+                             ChangeCallback on_change)
+    : backend_(std::move(backend)),
+      debounce_(debounce),
+      on_change_(std::move(on_change)) {
+    if (!backend_) {
+        throw std::invalid_argument("ConfigWatcher requires a backend");
+    }
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    Stop();
+}
+
+void ConfigWatcher::Start(const std::string& path) {
+    if (thread_.joinable()) {
+        throw std::logic_error("ConfigWatcher::Start called twice");
+    }
+    backend_->Watch(path);
+    thread_ = std::thread([this] { Run(); });
+    logging::Info("[ConfigWatcher] Watching " + path);
+}
+
+void ConfigWatcher::Stop() {
+    if (thread_.joinable()) {
+        backend_->Interrupt();
+        thread_.join();
+    }
+}
+
+// Sleeps in the backend until something changes, then keeps extending the quiet period
+// while the burst continues and fires once it settles.
+void ConfigWatcher::Run() {
+    using WaitResult = FileWatchBackend::WaitResult;
+    while (true) {
+        WaitResult result = backend_->WaitForChange(std::nullopt);
+        if (result == WaitResult::Stopped) {
+            return;
+        }
+        if (result != WaitResult::Changed) {
+            continue;
+        }
+        do {
+            result = backend_->WaitForChange(debounce_);
+        } while (result == WaitResult::Changed);
+        if (result == WaitResult::Stopped) {
+            return;
+        }
+
+        try {
+            on_change_();
+        } catch (const std::exception& ex) {
+            logging::Error(std::string("[ConfigWatcher] Reload handler failed: ") + ex.what());
+        }
+    }
+}
+
+} // namespace caps::core
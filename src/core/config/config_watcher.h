@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace caps::core {
+
+// OS-specific source of "this file changed" notifications. Implementations block in the
+// kernel while idle; nothing polls on a timer.
+class FileWatchBackend {
+public:
+    enum class WaitResult {
+        Changed,
+        Timeout,
+        Stopped,
+    };
+
+    virtual ~FileWatchBackend() = default;
+
+    // Starts watching `path`. Watches the parent directory so editors that save by
+    // writing a temp file and renaming it over the original are still noticed.
+    // Throws std::runtime_error if the OS refuses the watch.
+    virtual void Watch(const std::string& path) = 0;
+    // Blocks until the watched file changes, `timeout` elapses (if set), or Interrupt()
+    // was called. Once interrupted, every later call returns Stopped immediately.
+    virtual WaitResult WaitForChange(std::optional<std::chrono::milliseconds> timeout) = 0;
+    // Wakes WaitForChange(). Safe to call from any thread.
+    virtual void Interrupt() = 0;
+};
+
+// inotify on Linux, FSEvents on macOS, ReadDirectoryChangesW on Windows; nullptr on
+// other platforms, whose platform code can hand its own backend to
+// AppContext::WatchConfig().
+std::unique_ptr<FileWatchBackend> CreateDefaultWatchBackend();
+
+// Background thread that turns bursts of file-change notifications into one callback.
+// Editors often touch a file several times per save (truncate, write, chmod, rename), so
+// the callback only fires after the file has been quiet for `debounce`.
+class ConfigWatcher {
+public:
+    using ChangeCallback = std::function<void()>;
+
+    ConfigWatcher(std::unique_ptr<FileWatchBackend> backend,
+                  std::chrono::milliseconds debounce,
+                  ChangeCallback on_change);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Begins watching `path`; `on_change` runs on the watcher thread.
+    void Start(const std::string& path);
+    // Stops the thread. Idempotent; also called by the destructor.
+    void Stop();
+
+private:
+    void Run();
+
+    std::unique_ptr<FileWatchBackend> backend_;
+    std::chrono::milliseconds debounce_;
+    ChangeCallback on_change_;
+    std::thread thread_;
+};
+
+} // namespace caps::core
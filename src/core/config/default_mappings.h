@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace caps::core {
+
+// Most modifiers a single built-in mapping may require.
+inline constexpr std::size_t kMaxDefaultModifiers = 2;
+
+// One built-in mapping, spelled exactly as ConfigLoader normalizes config tokens so it
+// can be compiled without going through the parser.
+struct DefaultMapping {
+    std::string_view app;
+    std::string_view source;
+    std::string_view target;
+    std::array<std::string_view, kMaxDefaultModifiers> required_mods{}; // unused entries empty
+};
+
+// Used when no config file exists. Kept in ModifierSet order (sorted) and with rows
+// grouped by app in MappingTable order, so the compile-time table in default_table.cpp
+// comes out identical to CompiledTable::Build() over the same definitions.
+inline constexpr std::string_view kDefaultModifiers[] = {"D", "S"};
+
+inline constexpr DefaultMapping kDefaultMappings[] = {
+    {"*", "J", "LEFT", {}},
+    {"*", "K", "DOWN", {}},
+    {"*", "I", "UP", {}},
+    {"*", "L", "RIGHT", {}},
+    {"*", "J", "HOME", {"D"}},
+    {"*", "K", "PAGEDOWN", {"D"}},
+    {"*", "I", "PAGEUP", {"D"}},
+    {"*", "L", "END", {"D"}},
+    {"*", "J", "SHIFT! LEFT", {"S"}},
+    {"*", "K", "SHIFT! DOWN", {"S"}},
+    {"*", "I", "SHIFT! UP", {"S"}},
+    {"*", "L", "SHIFT! RIGHT", {"S"}},
+};
+
+} // namespace caps::core
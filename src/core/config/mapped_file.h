@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace caps::core {
+
+// Read-only memory mapping of a whole file. Used for the compiled config cache so a
+// warm start pages the tables in instead of parsing and copying them.
+class MappedFile {
+public:
+    // Returns nullptr when the file is missing, empty, or cannot be mapped.
+    static std::unique_ptr<MappedFile> Open(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] const void* Data() const;
+    [[nodiscard]] std::size_t Size() const;
+
+private:
+    MappedFile() = default;
+
+    const void* data_{nullptr};
+    std::size_t size_{0};
+#if defined(_WIN32)
+    void* file_{nullptr};
+    void* mapping_{nullptr};
+#endif
+};
+
+} // namespace caps::core
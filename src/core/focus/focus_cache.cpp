@@ -0,0 +1,90 @@
+#include "focus_cache.h"
+
+#include <utility>
+
+namespace caps::core {
+
+FocusCache::FocusCache(const FocusProvider& provider, Clock::duration ttl)
+    : provider_(provider), ttl_(ttl) {}
+
+// With no TTL the fast path never reads the clock: only a notification ends the focus.
+const std::string& FocusCache::Current() {
+    if (ttl_ == Clock::duration::zero()) {
+        if (!stale_.load(std::memory_order_acquire)) {
+            return Focused();
+        }
+        return Refresh(Clock::now());
+    }
+    return Current(Clock::now());
+}
+
+const std::string& FocusCache::Current(Clock::time_point now) {
+    if (!stale_.load(std::memory_order_acquire) &&
+        (ttl_ == Clock::duration::zero() || now - checked_ < ttl_)) {
+        return Focused();
+    }
+    return Refresh(now);
+}
+
+void FocusCache::Invalidate() {
+    stale_.store(true, std::memory_order_release);
+}
+
+const std::string& FocusCache::Refresh(Clock::time_point now) {
+    // Cleared before asking the provider, so a notification that lands mid-query marks
+    // the result stale again instead of being lost.
+    stale_.store(false, std::memory_order_release);
+    checked_ = now;
+
+    ++process_queries_;
+    const ProcessId pid = provider_.FocusedProcess();
+    focused_ = kMemoSize;
+    if (pid == kNoProcess) {
+        return Settle(empty_);
+    }
+
+    for (std::size_t i = 0; i < kMemoSize; ++i) {
+        const Entry& entry = memo_[i];
+        if (entry.pid == pid && now - entry.resolved < kNameLifetime) {
+            focused_ = i;
+            return Settle(entry.name);
+        }
+    }
+
+    ++name_queries_;
+    std::string name = provider_.AppName(pid);
+    if (name.empty()) {
+        return Settle(empty_); // not memoized: ask again next time rather than pin a failure
+    }
+
+    // Reuse this pid's stale slot if it has one, otherwise the next one in turn.
+    std::size_t slot = kMemoSize;
+    for (std::size_t i = 0; i < kMemoSize; ++i) {
+        if (memo_[i].pid == pid) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == kMemoSize) {
+        slot = next_victim_;
+        next_victim_ = (next_victim_ + 1) % kMemoSize;
+    }
+    memo_[slot] = Entry{pid, now, std::move(name)};
+    focused_ = slot;
+    return Settle(memo_[slot].name);
+}
+
+// Refreshes are rare, so comparing names here keeps Generation() exact.
+const std::string& FocusCache::Settle(const std::string& name) {
+    if (name != last_name_) {
+        ++generation_;
+        last_name_ = name;
+    }
+    return name;
+}
+
+const std::string& FocusCache::Focused() const {
+    return focused_ == kMemoSize ? empty_ : memo_[focused_].name;
+}
+
+} // namespace caps::core
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace caps::core {
+
+// Platform process id widened to one type; kNoProcess when nothing has focus.
+using ProcessId = std::int64_t;
+inline constexpr ProcessId kNoProcess = -1;
+
+// What a platform knows about focus. FocusedProcess() should be cheap (a window-manager
+// query); AppName() may be expensive (opening the process, reading its bundle) and is
+// what FocusCache memoizes.
+class FocusProvider {
+public:
+    virtual ~FocusProvider() = default;
+
+    [[nodiscard]] virtual ProcessId FocusedProcess() const = 0;
+    // Normalized app token for `pid`, or empty when it cannot be determined.
+    [[nodiscard]] virtual std::string AppName(ProcessId pid) const = 0;
+};
+
+// Memoizes the focused app's name so repeated keystrokes in one window skip the process
+// lookups. The cached focus ends when:
+//  - Invalidate() is called, from a platform focus-change notification on any thread;
+//  - the TTL lapses, for platforms without such a notification (zero disables it).
+// Until then Current() is a single atomic load (plus a clock read when a TTL is set).
+// Ending the cached focus only re-asks for the focused pid: names are memoized per pid,
+// so switching back to a recent window costs no AppName() call.
+//
+// Current() belongs to one thread (the hook's); only Invalidate() may be called from others.
+class FocusCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Recently focused processes whose names are kept.
+    static constexpr std::size_t kMemoSize = 8;
+    // How long a memoized name is trusted, since pids are reused once a process exits.
+    static constexpr Clock::duration kNameLifetime = std::chrono::seconds(30);
+
+    FocusCache(const FocusProvider& provider, Clock::duration ttl);
+
+    FocusCache(const FocusCache&) = delete;
+    FocusCache& operator=(const FocusCache&) = delete;
+
+    // Name of the focused app; empty when unknown. Valid until the next Current() call.
+    [[nodiscard]] const std::string& Current();
+    // Same, at an explicit time (tests drive the TTL with this).
+    [[nodiscard]] const std::string& Current(Clock::time_point now);
+
+    void Invalidate();
+
+    // Changes whenever Current() starts answering with a different name, so callers can
+    // key their own caches on it instead of comparing names.
+    [[nodiscard]] std::uint64_t Generation() const { return generation_; }
+
+    // Provider calls so far, for tests and diagnostics.
+    [[nodiscard]] std::size_t ProcessQueries() const { return process_queries_; }
+    [[nodiscard]] std::size_t NameQueries() const { return name_queries_; }
+
+private:
+    struct Entry {
+        ProcessId pid{kNoProcess};
+        Clock::time_point resolved{};
+        std::string name;
+    };
+
+    const std::string& Refresh(Clock::time_point now);
+    const std::string& Settle(const std::string& name);
+    [[nodiscard]] const std::string& Focused() const;
+
+    const FocusProvider& provider_;
+    const Clock::duration ttl_;
+    std::atomic<bool> stale_{true};
+    Clock::time_point checked_{};
+    std::array<Entry, kMemoSize> memo_;
+    std::size_t focused_{kMemoSize}; // memo_ index of the focused app; kMemoSize: none
+    std::size_t next_victim_{0};     // memo_ slots are reused round-robin
+    std::uint64_t generation_{0};
+    std::string last_name_;          // name of the current generation
+    std::size_t process_queries_{0};
+    std::size_t name_queries_{0};
+    const std::string empty_;
+};
+
+} // namespace caps::core
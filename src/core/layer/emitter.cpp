@@ -0,0 +1,143 @@
+#include "emitter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "core/logging.h"
+
+namespace caps::core {
+
+namespace {
+
+// How long the idle thread sleeps between checks when nothing is posted; posts signal
+// it directly and never wait for this.
+constexpr auto kIdleWait = std::chrono::milliseconds(100);
+
+} // namespace
+
+Emitter::Emitter(Sink sink) : sink_(std::move(sink)) {
+    if (!sink_) {
+        throw std::invalid_argument("Emitter requires a sink");
+    }
+    pending_.reserve(kOpsPerEntry * 4);
+}
+
+Emitter::~Emitter() {
+    Stop();
+}
+
+void Emitter::Start() {
+    if (thread_.joinable()) {
+        throw std::logic_error("Emitter::Start called twice");
+    }
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread([this] { Run(); });
+}
+
+void Emitter::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_release);
+    wake_.Signal();
+    thread_.join();
+}
+
+bool Emitter::Post(const ActionProgram& program, bool pressed) {
+    if (program.empty()) {
+        return true;
+    }
+    const std::size_t entries = (program.size() + kOpsPerEntry - 1) / kOpsPerEntry;
+    if (ring_.FreeSlots() < entries) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Entry entry;
+    entry.pressed = pressed;
+    for (std::size_t offset = 0; offset < program.size(); offset += kOpsPerEntry) {
+        const std::size_t count = std::min(kOpsPerEntry, program.size() - offset);
+        std::copy(program.begin() + offset, program.begin() + offset + count, entry.ops.begin());
+        entry.count = static_cast<std::uint8_t>(count);
+        entry.continued = offset + count < program.size();
+        ring_.TryPush(entry); // cannot fail: the free slots were counted above
+    }
+    posted_ += entries;
+    Wake();
+    return true;
+}
+
+void Emitter::Flush() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    const std::uint64_t target = posted_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (emitted_.load(std::memory_order_acquire) < target) {
+        drained_.wait_for(lock, kIdleWait);
+    }
+}
+
+// Only signals when the emitter thread may be parked, and never takes a lock, so the hook
+// thread cannot block behind the emitter thread. A signal that lands between Run()'s
+// empty check and its wait stays in the semaphore's count and ends that wait at once.
+void Emitter::Wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in Run()
+    if (sleeping_.load(std::memory_order_relaxed)) {
+        wake_.Signal();
+    }
+}
+
+void Emitter::Run() {
+    while (true) {
+        Drain();
+        if (stopping_.load(std::memory_order_acquire) && ring_.Empty()) {
+            return;
+        }
+
+        sleeping_.store(true, std::memory_order_relaxed);
+        // Either Post() sees sleeping_ and signals, or this sees its push. A signal left
+        // over from an earlier round only costs one extra empty Drain().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_.Empty() && !stopping_.load(std::memory_order_acquire)) {
+            wake_.WaitFor(kIdleWait);
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+// Reassembles programs that span entries so the sink sees each one whole, as it would
+// have on the hook thread.
+void Emitter::Drain() {
+    Entry entry;
+    bool any = false;
+    while (ring_.TryPop(entry)) {
+        any = true;
+        pending_.insert(pending_.end(), entry.ops.begin(), entry.ops.begin() + entry.count);
+        if (!entry.continued) {
+            try {
+                sink_(ActionProgram{pending_.data(), pending_.data() + pending_.size()}, entry.pressed);
+            } catch (const std::exception& ex) {
+                logging::Error(std::string("[Emitter] Sink failed: ") + ex.what());
+            }
+            pending_.clear();
+        }
+        emitted_.fetch_add(1, std::memory_order_release);
+    }
+
+    const std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+        logging::Warn("[Emitter] Queue full; dropped " + std::to_string(dropped - reported_drops_) +
+                      " key action(s)");
+        reported_drops_ = dropped;
+    }
+    if (any) {
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        drained_.notify_all();
+    }
+}
+
+} // namespace caps::core
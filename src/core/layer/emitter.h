@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/mapping/action_program.h"
+#include "core/sync/semaphore.h"
+#include "core/sync/spsc_ring.h"
+
+namespace caps::core {
+
+// Moves synthetic output off the OS hook thread. The hook decides whether to swallow a
+// key and posts the resolved program here; a dedicated thread replays it through the
+// sink (CGEventPost/SendInput), in posting order. Hooks that overrun their time budget
+// get disabled (kCGEventTapDisabledByTimeout, LowLevelHooksTimeout), so the hook side
+// only copies a few ops into a ring.
+class Emitter {
+public:
+    using Sink = std::function<void(const ActionProgram& program, bool pressed)>;
+
+    // Ops carried per ring entry; longer programs span consecutive entries.
+    static constexpr std::size_t kOpsPerEntry = 14;
+    static constexpr std::size_t kQueueDepth = 256;
+
+    explicit Emitter(Sink sink);
+    ~Emitter();
+
+    Emitter(const Emitter&) = delete;
+    Emitter& operator=(const Emitter&) = delete;
+
+    // Starts the emitter thread. Posts made before Start() are emitted once it runs.
+    void Start();
+    // Emits whatever is still queued, then stops the thread. Idempotent; also called by
+    // the destructor.
+    void Stop();
+
+    // Hook thread only. Copies the program's ops, so it need not outlive the call.
+    // Returns false if the queue had no room; the program is then dropped whole rather
+    // than stalling the hook, and the emitter thread logs the drop.
+    bool Post(const ActionProgram& program, bool pressed);
+    // Blocks until everything posted so far from this thread has reached the sink.
+    void Flush();
+
+    [[nodiscard]] std::uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::array<ActionOp, kOpsPerEntry> ops{};
+        std::uint8_t count{0};
+        bool pressed{false};
+        bool continued{false}; // more of the same program follows in the next entry
+    };
+
+    void Run();
+    void Drain();
+    void Wake();
+
+    Sink sink_;
+    SpscRing<Entry, kQueueDepth> ring_;
+    std::uint64_t posted_{0};                // entries pushed; producer only
+    std::atomic<std::uint64_t> emitted_{0};  // entries handed to the sink
+    std::atomic<std::uint64_t> dropped_{0};  // programs that did not fit
+    std::uint64_t reported_drops_{0};        // emitter thread only
+    std::vector<ActionOp> pending_;          // program being reassembled; emitter thread only
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+    Semaphore wake_;                  // emitter thread idles here
+    std::mutex mutex_;                // Flush() only
+    std::condition_variable drained_; // Flush() waits here
+    std::thread thread_;
+};
+
+} // namespace caps::core
@@ -0,0 +1,72 @@
+#include "held_keys.h"
+
+namespace caps::core {
+
+const HeldKey* HeldKeys::Find(KeyId key) const {
+    for (std::size_t probe = 0; probe < kCapacity; ++probe) {
+        const HeldKey& slot = slots_[(Home(key) + probe) & (kCapacity - 1)];
+        if (slot.key == key) {
+            return &slot;
+        }
+        if (slot.key == kInvalidKeyId) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool HeldKeys::Insert(const HeldKey& held) {
+    for (std::size_t probe = 0; probe < kCapacity; ++probe) {
+        HeldKey& slot = slots_[(Home(held.key) + probe) & (kCapacity - 1)];
+        if (slot.key == held.key) {
+            slot = held;
+            return true;
+        }
+        if (slot.key == kInvalidKeyId) {
+            slot = held;
+            ++size_;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Backward-shift deletion keeps every probe chain unbroken without tombstones.
+void HeldKeys::Erase(KeyId key) {
+    std::size_t hole = kCapacity;
+    for (std::size_t probe = 0; probe < kCapacity; ++probe) {
+        const std::size_t index = (Home(key) + probe) & (kCapacity - 1);
+        if (slots_[index].key == key) {
+            hole = index;
+            break;
+        }
+        if (slots_[index].key == kInvalidKeyId) {
+            return;
+        }
+    }
+    if (hole == kCapacity) {
+        return;
+    }
+    slots_[hole] = HeldKey{};
+    --size_;
+
+    for (std::size_t next = (hole + 1) & (kCapacity - 1); slots_[next].key != kInvalidKeyId;
+         next = (next + 1) & (kCapacity - 1)) {
+        // Move the entry into the hole if the hole lies on its probe path.
+        const std::size_t home = Home(slots_[next].key);
+        const std::size_t distance_to_next = (next - home) & (kCapacity - 1);
+        const std::size_t distance_to_hole = (hole - home) & (kCapacity - 1);
+        if (distance_to_hole < distance_to_next) {
+            slots_[hole] = slots_[next];
+            slots_[next] = HeldKey{};
+            hole = next;
+        }
+    }
+}
+
+void HeldKeys::Clear() {
+    slots_.fill(HeldKey{});
+    size_ = 0;
+}
+
+} // namespace caps::core
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/mapping/key_symbols.h"
+
+namespace caps::core {
+
+// What a key resolved to when it went down under the layer, kept until it comes back up
+// so auto-repeats and the release reuse it instead of resolving again. `action` is an
+// index into the table with `table_serial`; it means nothing against any other table.
+struct HeldKey {
+    KeyId key{kInvalidKeyId};
+    std::uint64_t table_serial{0};
+    ModifierMask mods{0}; // modifiers the press resolved under
+    std::uint32_t action{0};
+    bool mapped{false};
+};
+
+// Fixed-size table of the keys held under the layer, indexed by KeyId with linear
+// probing. Hands can only hold a few keys at once, so a full table simply stops caching
+// and callers fall back to resolving. Owned by the layer's owner thread.
+class HeldKeys {
+public:
+    static constexpr std::size_t kCapacity = 16;
+
+    // Entry for `key` if it is held, else nullptr.
+    [[nodiscard]] const HeldKey* Find(KeyId key) const;
+    // Records `held`; returns false when the table is full.
+    bool Insert(const HeldKey& held);
+    void Erase(KeyId key);
+    void Clear();
+    [[nodiscard]] std::size_t Size() const { return size_; }
+
+private:
+    static std::size_t Home(KeyId key) { return key & (kCapacity - 1); }
+
+    std::array<HeldKey, kCapacity> slots_{};
+    std::size_t size_{0};
+};
+
+} // namespace caps::core
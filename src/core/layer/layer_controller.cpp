@@ -1,43 +1,65 @@
 #include "layer_controller.h"
 
-#include <utility>
-#include <sstream>
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <charconv>
+#include <cstring>
+#include <utility>
 
 #include "core/mapping/mapping_engine.h"
 #include "core/logging.h"
+#include "core/replay/trace.h"
 
 namespace caps::core {
 
 namespace {
 
-std::string FormatAppForLog(const std::string& app) {
-    if (app.empty()) {
-        return "*";
+// Builds a debug line in place. The layer's debug lines are formatted on the hook thread
+// and the logger copies them into a fixed record, so no step allocates. A line longer
+// than the logger keeps is cut short here.
+class LogLine {
+public:
+    LogLine& operator<<(std::string_view text) {
+        const std::size_t count = std::min(text.size(), buffer_.size() - size_);
+        std::memcpy(buffer_.data() + size_, text.data(), count);
+        size_ += count;
+        return *this;
     }
-    std::string formatted;
-    formatted.reserve(app.size());
-    for (char ch : app) {
-        if (std::isalnum(static_cast<unsigned char>(ch))) {
-            formatted.push_back(ch);
-        }
+    LogLine& operator<<(int value) {
+        char digits[16];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return *this << std::string_view(digits, static_cast<std::size_t>(result.ptr - digits));
     }
-    if (formatted.empty()) {
-        return "*";
+    // Apps as the config names them: alphanumerics only, "*" when nothing is left.
+    LogLine& App(std::string_view app) {
+        const std::size_t start = size_;
+        for (char ch : app) {
+            if (std::isalnum(static_cast<unsigned char>(ch)) && size_ < buffer_.size()) {
+                buffer_[size_++] = ch;
+            }
+        }
+        return size_ == start ? *this << "*" : *this;
     }
-    return formatted;
-}
-
-std::string NormalizeKey(const std::string& key) {
-    std::string normalized;
-    normalized.reserve(key.size());
-    for (char ch : key) {
-        if (!std::isspace(static_cast<unsigned char>(ch))) {
-            normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+    // Names of the modifier keys in `mask`, joined with '+'.
+    LogLine& Modifiers(const MappingEngine::Snapshot& snapshot, ModifierMask mask) {
+        bool first = true;
+        for (std::size_t bit = 0; bit < kMaxModifiers; ++bit) {
+            if ((mask >> bit) & 1) {
+                if (!first) *this << "+";
+                *this << snapshot->KeyName(snapshot->ModifierKey(bit));
+                first = false;
+            }
         }
+        return *this;
     }
-    return normalized;
-}
+
+    [[nodiscard]] std::string_view View() const { return {buffer_.data(), size_}; }
+
+private:
+    std::array<char, logging::kMaxMessage> buffer_;
+    std::size_t size_{0};
+};
 
 } // namespace
 
@@ -49,98 +71,266 @@ void LayerController::SetActionCallback(ActionCallback callback) {
     action_callback_ = std::move(callback);
 }
 
+void LayerController::SetProgramCallback(ProgramCallback callback) {
+    program_callback_ = std::move(callback);
+}
+
+void LayerController::SetAppResolver(AppResolver resolver) {
+    app_resolver_ = std::move(resolver);
+    BindTracedResolver();
+}
+
+void LayerController::SetTraceWriter(TraceWriter* writer) {
+    trace_ = writer;
+    traced_generation_.reset(); // a new trace starts with the current focus
+    BindTracedResolver();
+}
+
+// The resolver is only asked for keys with app-specific mappings, so recording on its
+// calls captures exactly the focus changes a replay needs to resolve the same way.
+void LayerController::BindTracedResolver() {
+    if (!trace_ || !app_resolver_) {
+        traced_resolver_ = nullptr;
+        return;
+    }
+    traced_resolver_ = [this] {
+        const MappingEngine::FocusedApp focused = app_resolver_();
+        if (traced_generation_ != focused.generation) {
+            trace_->Focus(focused.name);
+            traced_generation_ = focused.generation;
+        }
+        return focused;
+    };
+}
+
+void LayerController::RecordKey(const KeyEvent& event, const Route& route, std::string_view action) {
+    trace_->Key(event, route.consumed, route.emit, action);
+}
+
 // Called whenever CapsLock is held down; activates the layer.
 void LayerController::OnCapsLockPressed() {
-    layer_active_ = true;
+    ApplyCapsLock(true, 0);
 }
 
 // Called when CapsLock is released; deactivates the layer.
 void LayerController::OnCapsLockReleased() {
-    layer_active_ = false;
+    ApplyCapsLock(false, 0);
+}
+
+bool LayerController::PostCapsLock(bool pressed, InputTime time) {
+    return inbox_.TryPush(LayerInput{pressed, time});
+}
+
+// Only takes the lock while the owner is parked in DrainInbox(), so the source's callback
+// stays lock-free for ordinary typing and the owner cannot miss the wake.
+void LayerController::AdvanceCapsSource(InputTime time) {
+    reorder_.Advance(time);
+    std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in DrainInbox()
+    if (awaiting_source_.load(std::memory_order_relaxed)) {
+        { std::lock_guard<std::mutex> lock(source_mutex_); }
+        source_advanced_.notify_one();
+    }
+}
+
+void LayerController::SetReorderWindow(std::chrono::microseconds window, Clock clock) {
+    reorder_window_us_ = window.count() > 0 ? static_cast<std::uint64_t>(window.count()) : 0;
+    clock_ = clock ? std::move(clock) : Clock([] {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    });
+}
+
+void LayerController::ApplyCapsLock(bool pressed, InputTime time) {
+    if (trace_) {
+        trace_->CapsLock(pressed, time);
+    }
+    if (pressed) {
+        layer_active_.store(true, std::memory_order_relaxed);
+        return;
+    }
+    layer_active_.store(false, std::memory_order_relaxed);
     // Clear all active modifiers when layer is deactivated
-    active_modifiers_.clear();
+    active_modifiers_ = 0;
+    // Keys still down now pass through on release; forget what they resolved to.
+    held_keys_.Clear();
+}
+
+// Moves posted transitions into the reorder buffer; one pushed out of a full buffer is
+// applied straight away, since holding it any longer cannot make it more correct.
+void LayerController::CollectInbox() {
+    LayerInput input;
+    while (inbox_.TryPop(input)) {
+        if (const auto evicted = reorder_.Insert(CapsTransition{input.time, input.caps_pressed})) {
+            ApplyCapsLock(evicted->pressed, evicted->time);
+        }
+    }
+}
+
+void LayerController::DrainInbox(InputTime key_time) {
+    const auto apply = [this](const CapsTransition& transition) { ApplyCapsLock(transition.pressed, transition.time); };
+    if (reorder_window_us_ == 0 || key_time == 0) {
+        CollectInbox();
+        reorder_.ReleaseAll(apply);
+        return;
+    }
+
+    // A transition stamped before the key may still be on its way from the CapsLock
+    // source, whichever way CapsLock is: a fast Caps+j roll can reach the tap before
+    // IOHID reports the press. Wait for the source's watermark to pass the key, but never
+    // past the window; the source signals every advance, so the wait ends as soon as it
+    // catches up. Hooks drain before their pre-check and OnKeyEvent() drains again; a key
+    // that has already had its wait does not get a second one.
+    CollectInbox();
+    if (key_time > waited_key_time_ && !reorder_.CaughtUp(key_time)) {
+        waited_key_time_ = key_time;
+        awaiting_source_.store(true, std::memory_order_relaxed);
+        // Either AdvanceCapsSource() sees awaiting_source_ and notifies under the lock, or
+        // the predicate below sees its watermark.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint64_t start = clock_();
+        while (!reorder_.CaughtUp(key_time)) {
+            const std::uint64_t elapsed = clock_() - start;
+            if (elapsed >= reorder_window_us_) {
+                CAPS_LOG_DEBUG(Layer, "CapsLock source still behind after the reorder window");
+                break;
+            }
+            std::unique_lock<std::mutex> lock(source_mutex_);
+            source_advanced_.wait_for(lock, std::chrono::microseconds(reorder_window_us_ - elapsed),
+                                      [this, key_time] { return reorder_.CaughtUp(key_time); });
+        }
+        awaiting_source_.store(false, std::memory_order_relaxed);
+    }
+    CollectInbox();
+    reorder_.Release(key_time, apply);
 }
 
 // Routes key events through the mapping table and fires the synthetic action callback.
 bool LayerController::OnKeyEvent(const KeyEvent& event) {
-    if (!layer_active_) {
-        return false;
-    }
+    return Dispatch(event, [this](const MappingEngine::Snapshot& snapshot, std::uint32_t action, bool pressed) {
+        Emit(snapshot, action, pressed);
+    });
+}
 
-    const std::string normalized_key = NormalizeKey(event.key);
+// Tracks modifiers and resolves everything else; what to emit is left to the caller.
+LayerController::Route LayerController::RouteKey(const MappingEngine::Snapshot& snapshot, const KeyEvent& event) {
+    const KeyId key = snapshot->FindKey(event.key);
     
     // Check if this key is a modifier
-    if (mapping_.IsModifier(normalized_key)) {
+    const ModifierMask modifier_bit = snapshot->ModifierBit(key);
+    if (modifier_bit != 0) {
+        const bool was_active = (active_modifiers_ & modifier_bit) != 0;
         if (event.pressed) {
-            const auto [_, inserted] = active_modifiers_.insert(normalized_key);
-            if (inserted) {
-                std::ostringstream msg;
-                msg << "Modifier " << normalized_key << " pressed (active: " << active_modifiers_.size() << ")";
-                logging::Debug(msg.str());
-            }
+            active_modifiers_ |= modifier_bit;
         } else {
-            if (active_modifiers_.erase(normalized_key) > 0) {
-                std::ostringstream msg;
-                msg << "Modifier " << normalized_key << " released (active: " << active_modifiers_.size() << ")";
-                logging::Debug(msg.str());
-            }
+            active_modifiers_ &= ~modifier_bit;
+        }
+        if (was_active != event.pressed && CAPS_LOG_ENABLED(Debug, Layer)) {
+            LogLine line;
+            line << "Modifier " << snapshot->KeyName(key) << (event.pressed ? " pressed" : " released")
+                 << " (active: " << CountModifiers(active_modifiers_) << ")";
+            logging::Log(logging::Level::Debug, logging::Subsystem::Layer, line.View());
         }
         // Swallow modifier key events - they should not pass through
-        return true;
-    }
-
-    const auto mapping_result = mapping_.ResolveMapping(event.key, event.app, active_modifiers_);
-    if (event.pressed) {
-        if (mapping_result) {
-            std::ostringstream msg;
-            const std::string resolved_app = mapping_result->app;
-            const std::string map_app =
-                resolved_app == "*" ? std::string("*") : FormatAppForLog(event.app.empty() ? resolved_app : event.app);
-            msg << "Caps-held key " << event.key << " mapped to " << mapping_result->action;
-            if (!mapping_result->required_mods.empty()) {
-                msg << " (mods: ";
-                for (size_t i = 0; i < mapping_result->required_mods.size(); ++i) {
-                    if (i > 0) msg << "+";
-                    msg << mapping_result->required_mods[i];
-                }
-                msg << ")";
-            }
-            msg << " (map=" << map_app << ")";
-            logging::Debug(msg.str());
+        return Route{true, false, 0};
+    }
+
+    // Auto-repeats and the release reuse what the key resolved to when it went down: no
+    // resolution or log formatting per repeat, and the release emits what the press did
+    // even if the modifiers changed meanwhile. A press under other modifiers (the OS stops
+    // repeating when one is pressed anyway), an explicit app, or a reload mid-hold falls
+    // back to resolving.
+    const HeldKey* held = event.app.empty() ? held_keys_.Find(key) : nullptr;
+    if (held && held->table_serial == snapshot->Serial() &&
+        (!event.pressed || held->mods == active_modifiers_)) {
+        const HeldKey hit = *held;
+        if (!event.pressed) {
+            held_keys_.Erase(key);
+        }
+        return Route{true, hit.mapped, hit.action};
+    }
+
+    const auto mapping =
+        event.app.empty() ? MappingEngine::ResolveRef(snapshot, key, active_app_,
+                                                      trace_ ? traced_resolver_ : app_resolver_, active_modifiers_)
+                          : MappingEngine::ResolveRef(snapshot, key, snapshot->FindApp(event.app), active_modifiers_);
+    if (event.pressed && CAPS_LOG_ENABLED(Debug, Layer)) {
+        LogResolution(snapshot, event, mapping);
+    }
+
+    if (key != kInvalidKeyId && event.app.empty()) {
+        if (event.pressed) {
+            // A full table only costs the repeats their shortcut.
+            held_keys_.Insert(HeldKey{key, snapshot->Serial(), active_modifiers_, mapping ? mapping->action : 0,
+                                      mapping.has_value()});
         } else {
-            std::ostringstream msg;
-            msg << "Caps-held key " << event.key << " has no mapping";
-            if (!active_modifiers_.empty()) {
-                msg << " (active mods: ";
-                bool first = true;
-                for (const auto& mod : active_modifiers_) {
-                    if (!first) msg << "+";
-                    msg << mod;
-                    first = false;
-                }
-                msg << ")";
-            }
-            logging::Debug(msg.str());
+            held_keys_.Erase(key); // pressed under a replaced table
         }
     }
 
-    if (!mapping_result) {
-        return true; // swallow unmapped keys while the layer is active
+    if (!mapping) {
+        return Route{true, false, 0}; // swallow unmapped keys while the layer is active
     }
+    return Route{true, true, mapping->action};
+}
 
+void LayerController::Emit(const MappingEngine::Snapshot& snapshot, std::uint32_t action, bool pressed) {
     if (action_callback_) {
-        // Notify the platform adapter so it can emit synthetic events immediately.
-        action_callback_(mapping_result->action, event.pressed);
+        // Reuses the buffer's capacity, so after the first few keys this does not allocate.
+        action_text_.assign(snapshot->Action(action));
+        action_callback_(action_text_, pressed);
+    }
+    if (program_callback_) {
+        program_callback_(snapshot->Program(action), pressed);
+    }
+}
+
+// Only runs at debug level, and even then without allocating: see LogLine.
+void LayerController::LogResolution(const MappingEngine::Snapshot& snapshot,
+                                    const KeyEvent& event,
+                                    const std::optional<MappingEngine::MappingRef>& mapping) const {
+    LogLine line;
+    if (mapping) {
+        line << "Caps-held key " << event.key << " mapped to " << snapshot->Action(mapping->action);
+        if (mapping->required_mods != 0) {
+            line << " (mods: ";
+            line.Modifiers(snapshot, mapping->required_mods) << ")";
+        }
+        const std::string_view map_app = snapshot->AppName(mapping->app);
+        line << " (map=";
+        if (map_app == "*") {
+            line << "*";
+        } else {
+            line.App(event.app.empty() ? map_app : std::string_view(event.app));
+        }
+        line << ")";
+    } else {
+        line << "Caps-held key " << event.key << " has no mapping";
+        if (active_modifiers_ != 0) {
+            line << " (active mods: ";
+            line.Modifiers(snapshot, active_modifiers_) << ")";
+        }
     }
-    return true;
+    logging::Log(logging::Level::Debug, logging::Subsystem::Layer, line.View());
 }
 
 bool LayerController::IsLayerActive() const {
-    return layer_active_;
+    return layer_active_.load(std::memory_order_relaxed);
 }
 
-const std::set<std::string>& LayerController::GetActiveModifiers() const {
-    return active_modifiers_;
+bool LayerController::IsKeyOfInterest(KeyCode key) const {
+    return mapping_.Acquire()->IsKeyOfInterest(key);
+}
+
+std::set<std::string> LayerController::GetActiveModifiers() const {
+    const auto snapshot = mapping_.Acquire();
+    std::set<std::string> names;
+    for (std::size_t bit = 0; bit < kMaxModifiers; ++bit) {
+        if ((active_modifiers_ >> bit) & 1) {
+            names.emplace(snapshot->KeyName(snapshot->ModifierKey(bit)));
+        }
+    }
+    return names;
 }
 
 } // namespace caps::core
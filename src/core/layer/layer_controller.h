@@ -1,42 +1,191 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+
+#include "core/mapping/action_program.h"
+#include "core/mapping/key_symbols.h"
+#include "core/layer/held_keys.h"
+#include "core/layer/reorder_buffer.h"
+#include "core/mapping/mapping_engine.h"
+#include "core/sync/mpsc_queue.h"
 
 namespace caps::core {
 
-class MappingEngine;
+class TraceWriter;
 
 // Lightweight struct that represents a key + press/release state as captured by hooks.
 struct KeyEvent {
     std::string key;
-    std::string app; // Normalized application identifier (empty uses fallback mappings).
+    std::string app; // Normalized application identifier (empty: ask the app resolver if needed).
     bool pressed{false};
+    InputTime time{0}; // Hardware timestamp of the key; 0 when the hook has none.
 };
 
 // Central coordinator that knows whether the Caps layer is active and which mappings apply.
+//
+// Layer state has a single owner: the thread that calls OnKeyEvent() (the hook thread).
+// Other threads that observe CapsLock, such as the macOS IOHID callback, Post() their
+// transitions to a lock-free inbox; the owner applies them in posting order before it
+// looks at the next key, so every key sees the layer as of the transitions before it.
+//
+// Posting order is not always hardware order: the IOHID callback can report a CapsLock
+// transition after the event tap has already delivered the key typed right after it.
+// With a reorder window set, stamped transitions are applied in timestamp order relative
+// to stamped keys: a stamped key waits, blocked, until the CapsLock source has reported
+// past it, so a press reported after the key it preceded still maps the key. The window
+// bounds that wait and is the worst-case latency reordering adds to any stamped key.
 class LayerController {
 public:
     using ActionCallback = std::function<void(const std::string& action, bool pressed)>;
+    // Receives the mapping's precompiled key ops; `program` is only valid during the call.
+    using ProgramCallback = std::function<void(const ActionProgram& program, bool pressed)>;
+
+    // Reports the focused app; see SetAppResolver().
+    using AppResolver = MappingEngine::AppResolver;
+    // Monotonic microseconds used to bound the reorder wait; tests inject a virtual clock.
+    using Clock = std::function<std::uint64_t()>;
 
     explicit LayerController(MappingEngine& mapping);
 
+    // Both callbacks run synchronously inside OnKeyEvent(), i.e. on the OS hook thread.
+    // Once warmed up, OnKeyEvent() does not allocate, debug logging included; callbacks
+    // that want the same guarantee must not allocate either.
     void SetActionCallback(ActionCallback callback);
+    // Precompiled ops instead of an action string to re-parse. Platform hooks skip both
+    // callbacks and hand their Emitter::Post() to the OnKeyEvent() sink overload instead.
+    void SetProgramCallback(ProgramCallback callback);
+    // Lets hooks leave KeyEvent::app empty: the resolver is only called for keys the
+    // config maps under some app, so "*"-only keys never pay for a focus query, and the
+    // app's row is only looked up again when the resolver reports a new generation.
+    void SetAppResolver(AppResolver resolver);
+    // Owner thread: records every CapsLock transition as applied (after reordering), every
+    // key with what it was routed to, and each focus change the resolver reports, for
+    // caps_replay. Null (the default) stops recording; `writer` must outlive its use.
+    void SetTraceWriter(TraceWriter* writer);
 
+    // Owner thread only: apply a CapsLock transition immediately.
     void OnCapsLockPressed();
     void OnCapsLockReleased();
+    // Any thread: queue a CapsLock transition for the owner, stamped with its hardware
+    // time when the source has one. Returns false if the inbox is full, which takes a
+    // backlog no human typing rate produces.
+    bool PostCapsLock(bool pressed, InputTime time = 0);
+    // Any thread: the CapsLock source has delivered everything up to `time`. Sources
+    // call it for every event they see, CapsLock or not, after posting any transition.
+    void AdvanceCapsSource(InputTime time);
+    // How long a stamped key may wait for the CapsLock source to catch up, i.e. the worst
+    // case latency reordering adds to a key, CapsLock up or down. Zero (the default)
+    // applies transitions in posting order. The source must deliver on another thread
+    // than the owner, or the wait can only time out. Call before the hook starts.
+    void SetReorderWindow(std::chrono::microseconds window, Clock clock = {});
+    // Owner thread: applies the transitions that happened before a key stamped `key_time`
+    // (everything posted so far when the key is unstamped or no window is set).
+    // OnKeyEvent() starts with this; hooks call it before the IsLayerActive() pre-check.
+    void DrainInbox(InputTime key_time = 0);
     // Returns true when the event was consumed by the layer (so hooks can swallow originals).
+    // Mapped keys are emitted through the action/program callbacks.
     bool OnKeyEvent(const KeyEvent& event);
+    // Same pipeline with the emit stage bound at compile time: `sink(program, pressed)` is
+    // called directly instead of through the callbacks, so a hook, the resolution and its
+    // Emitter::Post() inline into one function with no type-erased call per key.
+    // `program` is only valid during the call.
+    template <typename Sink>
+    bool OnKeyEvent(const KeyEvent& event, Sink&& sink) {
+        return Dispatch(event, [&sink](const MappingEngine::Snapshot& snapshot, std::uint32_t action, bool pressed) {
+            sink(snapshot->Program(action), pressed);
+        });
+    }
 
+    // Pre-checks for hooks, cheap enough to run on every keystroke before building a
+    // KeyEvent. While the layer is inactive OnKeyEvent() passes every key through, so a
+    // hook can return straight away; while it is active, keys that are not of interest
+    // are swallowed without a mapping, so a hook can swallow them without the token
+    // and app lookups.
     [[nodiscard]] bool IsLayerActive() const;
-    [[nodiscard]] const std::set<std::string>& GetActiveModifiers() const;
+    [[nodiscard]] bool IsKeyOfInterest(KeyCode key) const;
+    // Names of the currently pressed modifier keys (built on demand for introspection).
+    [[nodiscard]] std::set<std::string> GetActiveModifiers() const;
 
 private:
+    // What the filter and resolve stages decided for one key.
+    struct Route {
+        bool consumed{false}; // swallow the original event
+        bool emit{false};     // `action` is mapped and should be emitted
+        std::uint32_t action{0};
+    };
+
+    // filter (inbox, layer state) -> resolve (RouteKey) -> emit, with the emit stage
+    // supplied by the caller so it can be inlined.
+    template <typename Emit>
+    bool Dispatch(const KeyEvent& event, Emit&& emit) {
+        DrainInbox(event.time);
+        if (!layer_active_.load(std::memory_order_relaxed)) {
+            if (trace_) {
+                RecordKey(event, Route{}, {});
+            }
+            return false;
+        }
+        // One snapshot per event so the key id, modifier bit and mapping all come from the
+        // same config even if a reload is published mid-event; it stays pinned while the
+        // emit stage reads the program.
+        const auto snapshot = mapping_.Acquire();
+        const Route route = RouteKey(snapshot, event);
+        if (route.emit) {
+            emit(snapshot, route.action, event.pressed);
+        }
+        if (trace_) {
+            RecordKey(event, route, route.emit ? snapshot->Action(route.action) : std::string_view{});
+        }
+        return route.consumed;
+    }
+    Route RouteKey(const MappingEngine::Snapshot& snapshot, const KeyEvent& event);
+
+    struct LayerInput {
+        bool caps_pressed{false};
+        InputTime time{0};
+    };
+    static constexpr std::size_t kInboxDepth = 64;
+
     MappingEngine& mapping_;
     ActionCallback action_callback_;
-    bool layer_active_{false};
-    std::set<std::string> active_modifiers_; // Currently pressed modifier keys
+    ProgramCallback program_callback_;
+    AppResolver app_resolver_;
+    MappingEngine::ActiveApp active_app_;
+    std::atomic<bool> layer_active_{false}; // read lock-free by the hook pre-check
+    ModifierMask active_modifiers_{0}; // Bits of the currently pressed modifier keys
+    HeldKeys held_keys_; // what each key held under the layer resolved to when it went down
+    MpscQueue<LayerInput, kInboxDepth> inbox_;
+    ReorderBuffer reorder_;
+    std::uint64_t reorder_window_us_{0};
+    Clock clock_;
+    // The owner parks here while a key waits for the CapsLock source to catch up.
+    std::atomic<bool> awaiting_source_{false};
+    std::mutex source_mutex_;
+    std::condition_variable source_advanced_;
+    InputTime waited_key_time_{0}; // latest key stamp DrainInbox() has waited for
+    TraceWriter* trace_{nullptr};
+    AppResolver traced_resolver_; // app_resolver_ plus focus recording, while tracing
+    std::optional<std::uint64_t> traced_generation_;
+
+    void CollectInbox();
+    void ApplyCapsLock(bool pressed, InputTime time);
+    void BindTracedResolver();
+    void RecordKey(const KeyEvent& event, const Route& route, std::string_view action);
+    void Emit(const MappingEngine::Snapshot& snapshot, std::uint32_t action, bool pressed);
+    void LogResolution(const MappingEngine::Snapshot& snapshot,
+                       const KeyEvent& event,
+                       const std::optional<MappingEngine::MappingRef>& mapping) const;
+
+    std::string action_text_; // ActionCallback argument, reused between keys
 };
 
 } // namespace caps::core
@@ -0,0 +1,48 @@
+#include "reorder_buffer.h"
+
+#include <algorithm>
+
+namespace caps::core {
+
+// The source delivers in order, but Advance() may race with itself across threads
+// on platforms with several lagging callbacks; keep the maximum.
+void ReorderBuffer::Advance(InputTime time) {
+    InputTime current = watermark_.load(std::memory_order_relaxed);
+    while (current < time &&
+           !watermark_.compare_exchange_weak(current, time, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+bool ReorderBuffer::CaughtUp(InputTime time) const {
+    const InputTime watermark = watermark_.load(std::memory_order_acquire);
+    return watermark == 0 || watermark >= time;
+}
+
+std::optional<CapsTransition> ReorderBuffer::Insert(const CapsTransition& transition) {
+    std::optional<CapsTransition> evicted;
+    if (size_ == kCapacity) {
+        // The oldest of the buffered transitions and the new one goes; when that is the
+        // new one it is handed straight back, so nothing is applied out of time order.
+        if (transition.time < entries_[0].time) {
+            return transition;
+        }
+        evicted = entries_[0];
+        Drop(1);
+    }
+    // Insertion sort from the back: transitions almost always arrive in order.
+    std::size_t pos = size_;
+    while (pos > 0 && entries_[pos - 1].time > transition.time) {
+        entries_[pos] = entries_[pos - 1];
+        --pos;
+    }
+    entries_[pos] = transition;
+    ++size_;
+    return evicted;
+}
+
+void ReorderBuffer::Drop(std::size_t count) {
+    std::copy(entries_.begin() + count, entries_.begin() + size_, entries_.begin());
+    size_ -= count;
+}
+
+} // namespace caps::core
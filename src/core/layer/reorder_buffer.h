@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace caps::core {
+
+// Hardware event time in microseconds on the platform's monotonic input clock
+// (CGEventGetTimestamp/IOHIDValueGetTimeStamp, KBDLLHOOKSTRUCT::time, evdev
+// input_event.time). 0 means the source did not stamp the event.
+using InputTime = std::uint64_t;
+
+struct CapsTransition {
+    InputTime time{0};
+    bool pressed{false};
+};
+
+// Puts CapsLock transitions from a source that can lag behind the key path (the macOS
+// IOHID callback vs the event tap) back in hardware order. The owner buffers transitions
+// and, for each key, releases only those stamped at or before it; the lagging source
+// reports how far it has delivered via Advance(), so the owner knows when nothing older
+// than the key can still arrive. How long the owner is willing to wait for that is the
+// caller's latency bound; this class only keeps the order.
+class ReorderBuffer {
+public:
+    static constexpr std::size_t kCapacity = 16;
+
+    // Any thread: the lagging source has delivered everything stamped up to `time`.
+    void Advance(InputTime time);
+    // True once the lagging source has delivered up to `time`, or when it never reported
+    // at all (there is then nothing to wait for).
+    [[nodiscard]] bool CaughtUp(InputTime time) const;
+
+    // Owner only. Buffers `transition` in time order. When the buffer is full the oldest
+    // transition, counting `transition` itself, is returned so the caller can apply it
+    // right away.
+    std::optional<CapsTransition> Insert(const CapsTransition& transition);
+
+    // Owner only. Hands every transition stamped at or before `time` to `apply`, oldest
+    // first; later ones stay buffered for a later key.
+    template <typename Apply>
+    void Release(InputTime time, Apply&& apply) {
+        std::size_t released = 0;
+        while (released < size_ && entries_[released].time <= time) {
+            apply(entries_[released]);
+            ++released;
+        }
+        Drop(released);
+    }
+    // Owner only. Hands over everything regardless of time, oldest first.
+    template <typename Apply>
+    void ReleaseAll(Apply&& apply) {
+        for (std::size_t i = 0; i < size_; ++i) {
+            apply(entries_[i]);
+        }
+        size_ = 0;
+    }
+
+    [[nodiscard]] std::size_t Size() const { return size_; }
+
+private:
+    void Drop(std::size_t count);
+
+    std::atomic<InputTime> watermark_{0};
+    std::array<CapsTransition, kCapacity> entries_{}; // sorted by time, stable for ties
+    std::size_t size_{0};
+};
+
+} // namespace caps::core
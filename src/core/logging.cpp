@@ -1,22 +1,50 @@
 #include "core/logging.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
-#include <iomanip>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <mutex>
-#include <sstream>
 #include <string>
-#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "core/sync/mpsc_queue.h"
 
 namespace caps::core::logging {
 
 namespace {
 
 std::atomic<Level> g_level{Level::Debug};
-std::mutex g_stream_mutex;
+// Per-subsystem overrides; kInherit follows g_level. Written under g_levels_mutex.
+constexpr int kInherit = -1;
+std::array<int, kSubsystemCount> g_overrides{kInherit, kInherit, kInherit, kInherit, kInherit, kInherit};
+std::mutex g_levels_mutex;
+// Set once the writer has been torn down at exit; later messages are written inline.
+std::atomic<bool> g_writer_gone{false};
+
+void RecomputeThresholds() {
+    const int global = static_cast<int>(g_level.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < kSubsystemCount; ++i) {
+        detail::g_thresholds[i].store(g_overrides[i] == kInherit ? global : g_overrides[i],
+                                      std::memory_order_relaxed);
+    }
+}
+
+std::string Lowercase(std::string_view text) {
+    std::string lower{text};
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
 
 const char* ToString(Level level) {
     switch (level) {
+        case Level::Trace:
+            return "TRACE";
         case Level::Debug:
             return "DEBUG";
         case Level::Info:
@@ -29,10 +57,6 @@ const char* ToString(Level level) {
     return "INFO";
 }
 
-bool ShouldLog(Level level) {
-    return static_cast<int>(level) >= static_cast<int>(g_level.load(std::memory_order_relaxed));
-}
-
 std::ostream& StreamFor(Level level) {
     if (level == Level::Warning || level == Level::Error) {
         return std::cerr;
@@ -40,34 +64,229 @@ std::ostream& StreamFor(Level level) {
     return std::cout;
 }
 
-std::string Timestamp() {
-    using clock = std::chrono::system_clock;
-    const auto now = clock::now();
-    const auto time = clock::to_time_t(now);
-    std::tm tm{};
+// What a caller hands to the writer: the message bytes and the second it was logged.
+struct Record {
+    std::int64_t second{0};
+    Level level{Level::Info};
+    std::uint16_t length{0};
+    std::array<char, kMaxMessage> text{};
+};
+
+Record MakeRecord(Level level, std::string_view message) {
+    Record record;
+    record.second = static_cast<std::int64_t>(
+        std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    record.level = level;
+    if (message.size() > kMaxMessage) {
+        std::memcpy(record.text.data(), message.data(), kMaxMessage - 3);
+        std::memcpy(record.text.data() + kMaxMessage - 3, "...", 3);
+        record.length = static_cast<std::uint16_t>(kMaxMessage);
+    } else {
+        std::memcpy(record.text.data(), message.data(), message.size());
+        record.length = static_cast<std::uint16_t>(message.size());
+    }
+    return record;
+}
+
+// "HH:MM:SS" for a second, recomputed only when the second changes. Writer thread only.
+class TimestampCache {
+public:
+    std::string_view For(std::int64_t second) {
+        if (second != second_) {
+            const auto time = static_cast<std::time_t>(second);
+            std::tm tm{};
 #if defined(_WIN32)
-    localtime_s(&tm, &time);
+            localtime_s(&tm, &time);
 #else
-    localtime_r(&time, &tm);
+            localtime_r(&time, &tm);
 #endif
-    std::ostringstream os;
-    os << std::put_time(&tm, "%H:%M:%S");
-    return os.str();
+            length_ = std::strftime(text_.data(), text_.size(), "%H:%M:%S", &tm);
+            second_ = second;
+        }
+        return {text_.data(), length_};
+    }
+
+private:
+    std::int64_t second_{-1};
+    std::array<char, 16> text_{};
+    std::size_t length_{0};
+};
+
+// Owns the ring and the writer thread. Callers push and, only if the writer is asleep,
+// poke it; they never take a lock or touch a stream.
+class Writer {
+public:
+    Writer() : thread_([this] { Run(); }) {}
+
+    ~Writer() {
+        stopping_.store(true, std::memory_order_release);
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void Push(Level level, std::string_view message) {
+        if (!queue_.TryPush(MakeRecord(level, message))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        accepted_.fetch_add(1, std::memory_order_release);
+        if (sleeping_.load(std::memory_order_acquire)) {
+            wake_.notify_one(); // no lock: a missed wake costs at most one idle period
+        }
+    }
+
+    void Flush() {
+        const std::uint64_t target = accepted_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (written_.load(std::memory_order_acquire) < target && !stopping_.load(std::memory_order_acquire)) {
+            wake_.notify_one();
+            written_cv_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    std::uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    void SetSink(Sink sink) {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        sink_ = std::move(sink);
+    }
+
+private:
+    static constexpr auto kIdle = std::chrono::milliseconds(50);
+
+    void Run() {
+        while (true) {
+            const bool stopping = stopping_.load(std::memory_order_acquire);
+            if (Drain() == 0) {
+                if (stopping) {
+                    break;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                sleeping_.store(true, std::memory_order_seq_cst);
+                wake_.wait_for(lock, kIdle);
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Writes everything queued; returns how many records that was.
+    std::size_t Drain() {
+        std::size_t count = 0;
+        Record record;
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        while (queue_.TryPop(record)) {
+            Write(record.level, record.second, std::string_view(record.text.data(), record.length));
+            ++count;
+        }
+        const std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_drops_) {
+            const std::string note = "[Logging] Log queue full; dropped " + std::to_string(dropped - reported_drops_) +
+                                     " message(s) (" + std::to_string(dropped) + " total)";
+            reported_drops_ = dropped;
+            Write(Level::Warning, static_cast<std::int64_t>(std::chrono::system_clock::to_time_t(
+                                      std::chrono::system_clock::now())),
+                  note);
+        }
+        if (count > 0) {
+            if (!sink_) {
+                std::cout.flush();
+            }
+            written_.fetch_add(count, std::memory_order_release);
+            std::lock_guard<std::mutex> wake_lock(mutex_);
+            written_cv_.notify_all();
+        }
+        return count;
+    }
+
+    void Write(Level level, std::int64_t second, std::string_view message) {
+        line_.clear();
+        line_ += '[';
+        line_ += timestamps_.For(second);
+        line_ += "] [";
+        line_ += ToString(level);
+        line_ += "] ";
+        line_ += message;
+        if (sink_) {
+            sink_(level, line_);
+        } else {
+            StreamFor(level) << line_ << '\n';
+        }
+    }
+
+    MpscQueue<Record, kQueueDepth> queue_;
+    std::atomic<std::uint64_t> accepted_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_; // writer's idle wait and Flush(); callers never take it
+    std::condition_variable wake_;
+    std::condition_variable written_cv_;
+    std::mutex sink_mutex_; // writer thread vs SetSink()
+    Sink sink_;
+    // Writer thread only.
+    TimestampCache timestamps_;
+    std::string line_;
+    std::uint64_t reported_drops_{0};
+    std::thread thread_; // last: starts once everything above is constructed
+};
+
+// Started on first use. At exit its destructor writes what is queued and joins.
+struct WriterHolder {
+    Writer writer;
+    ~WriterHolder() { g_writer_gone.store(true, std::memory_order_release); }
+};
+
+Writer& TheWriter() {
+    static WriterHolder holder;
+    return holder.writer;
+}
+
+// Used once the writer is gone (logging from other static destructors).
+void WriteInline(Level level, std::string_view message) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    TimestampCache timestamps;
+    const auto second =
+        static_cast<std::int64_t>(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    StreamFor(level) << "[" << timestamps.For(second) << "] [" << ToString(level) << "] " << message << std::endl;
 }
 
 } // namespace
 
+namespace detail {
+// Static initialization: usable from other translation units' static constructors.
+constexpr int kDefaultThreshold = static_cast<int>(Level::Debug);
+static_assert(kSubsystemCount == 6, "one initializer per subsystem");
+std::array<std::atomic<int>, kSubsystemCount> g_thresholds{{{kDefaultThreshold},
+                                                            {kDefaultThreshold},
+                                                            {kDefaultThreshold},
+                                                            {kDefaultThreshold},
+                                                            {kDefaultThreshold},
+                                                            {kDefaultThreshold}}};
+} // namespace detail
+
 Level GetLevel() {
     return g_level.load(std::memory_order_relaxed);
 }
 
 void SetLevel(Level level) {
+    std::lock_guard<std::mutex> lock(g_levels_mutex);
     g_level.store(level, std::memory_order_relaxed);
+    RecomputeThresholds();
+}
+
+void SetSubsystemLevel(Subsystem subsystem, std::optional<Level> level) {
+    std::lock_guard<std::mutex> lock(g_levels_mutex);
+    g_overrides[static_cast<std::size_t>(subsystem)] = level ? static_cast<int>(*level) : kInherit;
+    RecomputeThresholds();
 }
 
 std::optional<Level> ParseLevel(std::string_view name) {
-    std::string lower{name};
-    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    const std::string lower = Lowercase(name);
+    if (lower == "trace") {
+        return Level::Trace;
+    }
     if (lower == "debug") {
         return Level::Debug;
     }
@@ -83,14 +302,76 @@ std::optional<Level> ParseLevel(std::string_view name) {
     return std::nullopt;
 }
 
+std::optional<Subsystem> ParseSubsystem(std::string_view name) {
+    const std::string lower = Lowercase(name);
+    if (lower == "general") {
+        return Subsystem::General;
+    }
+    if (lower == "layer") {
+        return Subsystem::Layer;
+    }
+    if (lower == "output") {
+        return Subsystem::Output;
+    }
+    if (lower == "keyboardhook" || lower == "hook") {
+        return Subsystem::KeyboardHook;
+    }
+    if (lower == "focus") {
+        return Subsystem::Focus;
+    }
+    if (lower == "config") {
+        return Subsystem::Config;
+    }
+    return std::nullopt;
+}
+
+bool ApplyLevelSpec(std::string_view spec) {
+    const auto split = spec.find_first_of("=:");
+    if (split == std::string_view::npos) {
+        const auto level = ParseLevel(spec);
+        if (level) {
+            SetLevel(*level);
+        }
+        return level.has_value();
+    }
+    const auto subsystem = ParseSubsystem(spec.substr(0, split));
+    const auto level = ParseLevel(spec.substr(split + 1));
+    if (!subsystem || !level) {
+        return false;
+    }
+    SetSubsystemLevel(*subsystem, level);
+    return true;
+}
+
 void Log(Level level, std::string_view message) {
-    if (!ShouldLog(level)) {
+    Log(level, Subsystem::General, message);
+}
+
+void Log(Level level, Subsystem subsystem, std::string_view message) {
+    if (!IsEnabled(level, subsystem)) {
+        return;
+    }
+    if (g_writer_gone.load(std::memory_order_acquire)) {
+        WriteInline(level, message);
         return;
     }
+    TheWriter().Push(level, message);
+}
+
+void Flush() {
+    if (!g_writer_gone.load(std::memory_order_acquire)) {
+        TheWriter().Flush();
+    }
+}
+
+std::uint64_t Dropped() {
+    return g_writer_gone.load(std::memory_order_acquire) ? 0 : TheWriter().Dropped();
+}
 
-    std::lock_guard<std::mutex> lock(g_stream_mutex);
-    auto& out = StreamFor(level);
-    out << "[" << Timestamp() << "] [" << ToString(level) << "] " << message << std::endl;
+void SetSink(Sink sink) {
+    if (!g_writer_gone.load(std::memory_order_acquire)) {
+        TheWriter().SetSink(std::move(sink));
+    }
 }
 
 } // namespace caps::core::logging
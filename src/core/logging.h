@@ -1,27 +1,84 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <sstream>
 #include <string_view>
 #include <optional>
 
 namespace caps::core::logging {
 
 enum class Level {
-    Debug = 0,
-    Info = 1,
-    Warning = 2,
-    Error = 3,
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warning = 3,
+    Error = 4,
 };
 
+// Areas whose threshold can be set apart from the global one, so one of them can log at
+// Debug in production without the others formatting anything.
+enum class Subsystem : std::uint8_t {
+    General,
+    Layer,        // LayerController: layer state, modifiers, resolution
+    Output,       // platform Output: synthetic events
+    KeyboardHook, // platform hooks: CapsLock transitions, raw keys
+    Focus,        // app monitors and the focus cache
+    Config,       // ConfigLoader, watcher, compiled cache
+};
+inline constexpr std::size_t kSubsystemCount = 6;
+
 // Returns the current global log level threshold. Messages below this level are suppressed.
 Level GetLevel();
-// Sets the global log level threshold.
+// Sets the global log level threshold. Subsystems without a level of their own follow it.
 void SetLevel(Level level);
+// Gives `subsystem` its own threshold; std::nullopt makes it follow the global one again.
+void SetSubsystemLevel(Subsystem subsystem, std::optional<Level> level);
 // Parses a string name into a Level (case-insensitive). Returns std::nullopt on failure.
 std::optional<Level> ParseLevel(std::string_view name);
+// Parses "layer", "output", "keyboardhook", ... (case-insensitive).
+std::optional<Subsystem> ParseSubsystem(std::string_view name);
+// Applies a --log-level value: "debug" sets the global level, "layer=debug" (or
+// "layer:debug") one subsystem's. Returns false, changing nothing, if either part is unknown.
+bool ApplyLevelSpec(std::string_view spec);
+
+namespace detail {
+// Effective threshold per subsystem, kept up to date by SetLevel()/SetSubsystemLevel() so
+// the enabled check is a single relaxed load.
+extern std::array<std::atomic<int>, kSubsystemCount> g_thresholds;
+} // namespace detail
 
-// Emits a log message at the given level if it meets the current threshold.
+// Whether a message at `level` for `subsystem` would be written right now.
+inline bool IsEnabled(Level level, Subsystem subsystem = Subsystem::General) {
+    return static_cast<int>(level) >=
+           detail::g_thresholds[static_cast<std::size_t>(subsystem)].load(std::memory_order_relaxed);
+}
+
+// Records queued between callers and the writer thread; when they are all taken, further
+// messages are dropped (and counted) rather than making the caller wait.
+inline constexpr std::size_t kQueueDepth = 512;
+// Longer messages are cut to this many bytes, ending in "...".
+inline constexpr std::size_t kMaxMessage = 480;
+
+// Emits a log message at the given level if it meets the current threshold. Never waits
+// for terminal or disk I/O: the message is copied into a lock-free ring and a background
+// thread formats and writes it, so hook threads can log.
 void Log(Level level, std::string_view message);
+void Log(Level level, Subsystem subsystem, std::string_view message);
+
+// Blocks until every message logged before the call has been written.
+void Flush();
+// Messages lost because the ring was full. The writer also reports drops as a warning.
+std::uint64_t Dropped();
+
+// Receives each formatted line (without the trailing newline) on the writer thread in
+// place of stdout/stderr. An empty sink restores the standard streams. For tests and
+// embedders; Flush() first if earlier messages must go to the previous destination.
+using Sink = std::function<void(Level level, std::string_view line)>;
+void SetSink(Sink sink);
 
 // Convenience helpers for common log levels.
 inline void Debug(std::string_view message) { Log(Level::Debug, message); }
@@ -30,3 +87,36 @@ inline void Warn(std::string_view message) { Log(Level::Warning, message); }
 inline void Error(std::string_view message) { Log(Level::Error, message); }
 
 } // namespace caps::core::logging
+
+// Levels below this are compiled out of the CAPS_LOG_* macros: the statement and its
+// message expression vanish, whatever the runtime level. Set to 2 (Info) by the
+// CAPS_STRIP_DEBUG_LOGS build option for Release builds.
+#ifndef CAPS_LOG_MIN_LEVEL
+#define CAPS_LOG_MIN_LEVEL 0
+#endif
+
+// True when a message at `level` (a Level enumerator name) for `subsystem` (a Subsystem
+// enumerator name) is compiled in and enabled. For messages built over several statements.
+#define CAPS_LOG_ENABLED(level, subsystem)                                                    \
+    (static_cast<int>(::caps::core::logging::Level::level) >= CAPS_LOG_MIN_LEVEL &&           \
+     ::caps::core::logging::IsEnabled(::caps::core::logging::Level::level,                   \
+                                      ::caps::core::logging::Subsystem::subsystem))
+
+// Streams `expr` into the message only when the level is enabled, e.g.
+//   CAPS_LOG_DEBUG(Layer, "Modifier " << name << " pressed");
+#define CAPS_LOG(level, subsystem, expr)                                                      \
+    do {                                                                                      \
+        if (CAPS_LOG_ENABLED(level, subsystem)) {                                             \
+            std::ostringstream caps_log_message_;                                             \
+            caps_log_message_ << expr;                                                        \
+            ::caps::core::logging::Log(::caps::core::logging::Level::level,                   \
+                                       ::caps::core::logging::Subsystem::subsystem,           \
+                                       caps_log_message_.str());                              \
+        }                                                                                     \
+    } while (false)
+
+#define CAPS_LOG_TRACE(subsystem, expr) CAPS_LOG(Trace, subsystem, expr)
+#define CAPS_LOG_DEBUG(subsystem, expr) CAPS_LOG(Debug, subsystem, expr)
+#define CAPS_LOG_INFO(subsystem, expr) CAPS_LOG(Info, subsystem, expr)
+#define CAPS_LOG_WARN(subsystem, expr) CAPS_LOG(Warning, subsystem, expr)
+#define CAPS_LOG_ERROR(subsystem, expr) CAPS_LOG(Error, subsystem, expr)
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "core/mapping/key_codes.h"
+
+namespace caps::core {
+
+// One synthetic key transition.
+struct ActionOp {
+    KeyCode key{KeyCode::kNone};
+    std::uint16_t down{0}; // 1 = press, 0 = release
+};
+
+// Where one target's ops live in a compiled table's op pool.
+struct ProgramRef {
+    std::uint32_t begin{0};
+    std::uint32_t count{0};
+};
+
+// A mapping target compiled to ops in emission order. Views the table that produced it,
+// so it is only valid while that table (or the snapshot pinning it) is.
+struct ActionProgram {
+    const ActionOp* first{nullptr};
+    const ActionOp* last{nullptr};
+
+    [[nodiscard]] const ActionOp* begin() const { return first; }
+    [[nodiscard]] const ActionOp* end() const { return last; }
+    [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    [[nodiscard]] bool empty() const { return first == last; }
+    [[nodiscard]] const ActionOp& operator[](std::size_t index) const { return first[index]; }
+};
+
+enum class ActionError {
+    kNone,
+    kEmpty,        // target has no tokens
+    kUnknownKey,   // a token names no key
+    kDanglingHold, // "X!" with nothing after it to hold X around
+    kTooManyHolds, // more than kMaxActionHolds "X!" nested around one key
+};
+
+// Pending holds are replayed in reverse once their tap is out, so CompileAction() bounds
+// how deep they nest rather than allocating; real targets hold at most a few modifiers.
+inline constexpr std::size_t kMaxActionHolds = 8;
+
+// Compiles a normalized target (single spaces, uppercase: "SHIFT! LEFT") into key ops and
+// hands each one to `emit(ActionOp)` in emission order. A plain token taps its key; "X!"
+// holds X around everything up to and including the next plain token, so "SHIFT! LEFT"
+// is SHIFT down, LEFT down, LEFT up, SHIFT up and "CTRL! SHIFT! T" nests both holds.
+// Hex codes this platform's key table knows become canonical keys; others pass through
+// as native keys. On error `bad_token` (when given) is set to the offending token and the caller should
+// discard whatever was emitted.
+template <typename Emit>
+constexpr ActionError CompileAction(std::string_view target, Emit&& emit, std::string_view* bad_token = nullptr) {
+    KeyCode holds[kMaxActionHolds]{};
+    std::size_t hold_count = 0;
+    std::string_view last_hold;
+    bool any = false;
+
+    std::size_t pos = 0;
+    while (pos < target.size()) {
+        while (pos < target.size() && target[pos] == ' ') {
+            ++pos;
+        }
+        std::size_t end = pos;
+        while (end < target.size() && target[end] != ' ') {
+            ++end;
+        }
+        if (end == pos) {
+            break;
+        }
+        const std::string_view token = target.substr(pos, end - pos);
+        pos = end;
+        any = true;
+
+        const bool hold = token.back() == '!';
+        const std::string_view name = hold ? token.substr(0, token.size() - 1) : token;
+        const KeyCode key = ResolveNative(LookupKeyName(name));
+        if (key == KeyCode::kNone) {
+            if (bad_token) *bad_token = token;
+            return ActionError::kUnknownKey;
+        }
+        if (hold && hold_count == kMaxActionHolds) {
+            if (bad_token) *bad_token = token;
+            return ActionError::kTooManyHolds;
+        }
+        emit(ActionOp{key, 1});
+        if (hold) {
+            holds[hold_count++] = key;
+            last_hold = token;
+            continue;
+        }
+        emit(ActionOp{key, 0});
+        while (hold_count > 0) {
+            emit(ActionOp{holds[--hold_count], 0});
+        }
+    }
+
+    if (!any) {
+        return ActionError::kEmpty;
+    }
+    if (hold_count > 0) {
+        if (bad_token) *bad_token = last_hold;
+        return ActionError::kDanglingHold;
+    }
+    return ActionError::kNone;
+}
+
+} // namespace caps::core
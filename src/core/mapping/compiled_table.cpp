@@ -0,0 +1,902 @@
+#include "compiled_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "core/config/mapped_file.h"
+
+namespace caps::core {
+
+namespace {
+
+// Bump whenever the image layout or any persisted hash changes. Older caches are then
+// rejected and rebuilt from the INI. Key table edits need no bump: the header records
+// kKeyTableFingerprint.
+constexpr std::uint32_t kImageMagic = 0x54435043; // "CPCT"
+constexpr std::uint32_t kImageVersion = 4;
+constexpr std::size_t kSectionAlign = 8;
+// Patched tables keep dead rows and candidate runs; past this many (plus the live count)
+// Patch() defers to a full Build() to compact them.
+constexpr std::size_t kPatchSlack = 1024;
+
+enum Section : std::uint32_t {
+    kStrings,
+    kKeyNames,
+    kKeySlots,
+    kAppNames,
+    kAppSlots,
+    kActions,
+    kModifierNames,
+    kModifierBits,
+    kModifierKeys,
+    kSlots,
+    kCandidates,
+    kRows,
+    kRowMods,
+    kPrograms,
+    kProgramOps,
+    kSectionCount,
+};
+
+struct SectionEntry {
+    std::uint64_t offset{0};
+    std::uint64_t size{0};
+};
+
+struct ImageHeader {
+    std::uint32_t magic{kImageMagic};
+    std::uint32_t version{kImageVersion};
+    std::uint32_t platform{0};
+    std::uint32_t flags{0};
+    std::uint64_t content_hash{0};
+    std::uint64_t key_table{kKeyTableFingerprint}; // KeyCodes and names the image was compiled with
+    std::uint64_t total_size{0};
+    SectionEntry sections[kSectionCount];
+};
+
+// Images are raw memory dumps, so a cache is only valid for the same byte order and
+// key-code platform that wrote it.
+std::uint32_t PlatformTag() {
+    const std::uint16_t probe = 1;
+    std::uint8_t little = 0;
+    std::memcpy(&little, &probe, 1);
+#if defined(_WIN32)
+    constexpr std::uint32_t os = 1;
+#elif defined(__APPLE__)
+    constexpr std::uint32_t os = 2;
+#else
+    constexpr std::uint32_t os = 3;
+#endif
+    return (os << 8) | little;
+}
+
+std::size_t AlignUp(std::size_t value) {
+    return (value + kSectionAlign - 1) & ~(kSectionAlign - 1);
+}
+
+// Lays sections out back to back behind the header, each 8-byte aligned. A section may
+// be assembled from several chunks, which lets Patch() splice new data between runs
+// copied straight out of the previous image.
+class ImageBuilder {
+public:
+    template <typename T>
+    void Add(Section section, const T* data, std::size_t count) {
+        if (count != 0) {
+            chunks_[section].push_back(Chunk{reinterpret_cast<const char*>(data), count * sizeof(T)});
+        }
+    }
+    template <typename T>
+    void Add(Section section, const CompiledTable::Range<T>& range) {
+        Add(section, range.begin(), range.size());
+    }
+    template <typename T>
+    void Add(Section section, const std::vector<T>& values) {
+        Add(section, values.data(), values.size());
+    }
+
+    std::vector<std::uint64_t> Finish() {
+        ImageHeader header;
+        header.platform = PlatformTag();
+        std::size_t offset = AlignUp(sizeof(ImageHeader));
+        for (std::uint32_t i = 0; i < kSectionCount; ++i) {
+            std::size_t size = 0;
+            for (const Chunk& chunk : chunks_[i]) {
+                size += chunk.size;
+            }
+            header.sections[i] = SectionEntry{offset, size};
+            offset = AlignUp(offset + size);
+        }
+        header.total_size = offset;
+
+        std::vector<std::uint64_t> image(offset / sizeof(std::uint64_t), 0);
+        auto* bytes = reinterpret_cast<char*>(image.data());
+        std::memcpy(bytes, &header, sizeof(header));
+        for (std::uint32_t i = 0; i < kSectionCount; ++i) {
+            char* out = bytes + header.sections[i].offset;
+            for (const Chunk& chunk : chunks_[i]) {
+                std::memcpy(out, chunk.data, chunk.size);
+                out += chunk.size;
+            }
+        }
+        return image;
+    }
+
+private:
+    struct Chunk {
+        const char* data;
+        std::size_t size;
+    };
+    std::vector<Chunk> chunks_[kSectionCount];
+};
+
+template <typename T>
+bool ViewSection(const char* base, const ImageHeader& header, Section section, CompiledTable::Range<T>& out) {
+    const SectionEntry& entry = header.sections[section];
+    if (entry.offset % alignof(T) != 0 || entry.size % sizeof(T) != 0 || entry.offset > header.total_size ||
+        entry.size > header.total_size - entry.offset) {
+        return false;
+    }
+    const auto* first = reinterpret_cast<const T*>(base + entry.offset);
+    out = CompiledTable::Range<T>{first, first + entry.size / sizeof(T)};
+    return true;
+}
+
+bool ValidNames(const CompiledTable::Range<NameRef>& names, std::size_t pool_size) {
+    return std::all_of(names.begin(), names.end(), [&](const NameRef& name) {
+        return name.offset <= pool_size && name.size <= pool_size - name.offset;
+    });
+}
+
+// Slot arrays must be a power of two with at least one empty slot so probing terminates.
+bool ValidSlots(const CompiledTable::Range<KeyId>& slots, std::size_t count) {
+    if (slots.empty()) {
+        return count == 0;
+    }
+    if ((slots.size() & (slots.size() - 1)) != 0 || slots.size() <= count) {
+        return false;
+    }
+    bool has_empty = false;
+    for (KeyId id : slots) {
+        if (id == kInvalidKeyId) {
+            has_empty = true;
+        } else if (id >= count) {
+            return false;
+        }
+    }
+    return has_empty;
+}
+
+std::vector<NameRef> Rebase(const std::vector<NameRef>& names, std::size_t base) {
+    std::vector<NameRef> rebased(names);
+    for (NameRef& name : rebased) {
+        name.offset += static_cast<std::uint32_t>(base);
+    }
+    return rebased;
+}
+
+// Compiles one row. Returns false when the row needs a modifier that was never declared,
+// in which case it can never match and stays out of the dispatch slots.
+bool CompileRow(const CompiledTable::Row& row, const KeyId* mods, const ModifierMask* modifier_bits,
+                Candidate& candidate) {
+    candidate = Candidate{};
+    candidate.app = row.app;
+    candidate.action = row.action;
+    bool reachable = true;
+    for (std::uint32_t m = 0; m < row.mods_count; ++m) {
+        const ModifierMask bit = modifier_bits[mods[m]];
+        reachable = reachable && bit != 0;
+        candidate.required_mask |= bit;
+    }
+    candidate.specificity = static_cast<std::uint16_t>(CountModifiers(candidate.required_mask));
+    return reachable;
+}
+
+bool MoreSpecific(const Candidate& lhs, const Candidate& rhs) {
+    return lhs.specificity > rhs.specificity;
+}
+
+NameRef AppendName(std::string& pool, std::string_view name) {
+    NameRef ref{static_cast<std::uint32_t>(pool.size()), static_cast<std::uint32_t>(name.size())};
+    pool.append(name);
+    return ref;
+}
+
+// Compiles `target` onto the end of `ops`, whose first element sits `base` ops into the
+// image's pool. A target that does not compile gets an empty program; ConfigLoader has
+// already warned about it while parsing.
+ProgramRef AppendProgram(std::string_view target, std::vector<ActionOp>& ops, std::size_t base) {
+    const std::size_t begin = ops.size();
+    if (CompileAction(target, [&](ActionOp op) { ops.push_back(op); }) != ActionError::kNone) {
+        ops.resize(begin);
+    }
+    return ProgramRef{static_cast<std::uint32_t>(base + begin), static_cast<std::uint32_t>(ops.size() - begin)};
+}
+
+} // namespace
+
+CompiledTable::CompiledTable() = default;
+
+std::uint64_t CompiledTable::NextSerial() {
+    static std::atomic<std::uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+CompiledTable::~CompiledTable() = default;
+
+// Flattens the per-app definition lists into the (app, key) grid, then packs everything
+// into the image layout. Runs only when the config changes, so it favours clarity over
+// squeezing out allocations.
+std::shared_ptr<const CompiledTable> CompiledTable::Build(const ConfigLoader::MappingTable& mappings,
+                                                          const ConfigLoader::ModifierSet& modifiers) {
+    if (modifiers.size() > kMaxModifiers) {
+        throw std::runtime_error("Config declares " + std::to_string(modifiers.size()) +
+                                 " modifiers; at most " + std::to_string(kMaxModifiers) + " are supported");
+    }
+
+    KeySymbolTable keys;
+    KeySymbolTable apps;
+    apps.Intern("*");
+
+    // Modifiers are interned first so their bit positions follow the sorted modifier set.
+    std::vector<KeyId> modifier_keys;
+    for (const auto& mod : modifiers) {
+        modifier_keys.push_back(keys.Intern(mod));
+    }
+
+    std::vector<std::string_view> actions;
+    std::vector<Row> rows;
+    std::vector<KeyId> row_mods;
+    for (const auto& [app, definitions] : mappings) {
+        const KeyId app_id = apps.Intern(app);
+        const auto row_app = app_id == kInvalidKeyId ? kFallbackAppId : static_cast<AppId>(app_id);
+        for (const auto& def : definitions) {
+            Row row;
+            row.app = row_app;
+            row.source = keys.Intern(def.source);
+            row.action = static_cast<std::uint32_t>(actions.size());
+            actions.push_back(def.target);
+            row.mods_begin = static_cast<std::uint32_t>(row_mods.size());
+            row.mods_count = static_cast<std::uint32_t>(def.required_mods.size());
+            for (const auto& mod : def.required_mods) {
+                row_mods.push_back(keys.Intern(mod));
+            }
+            rows.push_back(row);
+        }
+    }
+
+    const std::size_t key_count = keys.Size();
+    std::vector<ModifierMask> modifier_bits(key_count, 0);
+    for (std::size_t bit = 0; bit < modifier_keys.size(); ++bit) {
+        modifier_bits[modifier_keys[bit]] = ModifierMask{1} << bit;
+    }
+
+    // Compile each row into a candidate. Without a [modifiers] section a mapping may name
+    // keys that can never be held as layer modifiers; such rows simply never match.
+    std::vector<Candidate> compiled(rows.size());
+    std::vector<bool> reachable(rows.size(), true);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        reachable[i] = CompileRow(rows[i], row_mods.data() + rows[i].mods_begin, modifier_bits.data(), compiled[i]);
+    }
+
+    // Group reachable rows by (app, key) while keeping config order inside each group.
+    std::vector<std::uint32_t> order;
+    order.reserve(rows.size());
+    for (std::uint32_t i = 0; i < rows.size(); ++i) {
+        if (reachable[i]) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        const Row& a = rows[lhs];
+        const Row& b = rows[rhs];
+        return a.app != b.app ? a.app < b.app : a.source < b.source;
+    });
+
+    const std::size_t app_count = apps.Size();
+    std::vector<SlotRange> own(app_count * key_count);
+    for (std::size_t pos = 0; pos < order.size(); ++pos) {
+        const Row& row = rows[order[pos]];
+        SlotRange& range = own[row.app * key_count + row.source];
+        if (range.count == 0) {
+            range.begin = static_cast<std::uint32_t>(pos);
+        }
+        ++range.count;
+    }
+
+    // Each slot is the app's own rows followed by the "*" rows, stably sorted by
+    // specificity. Stability gives the existing tie-breaks: app before fallback,
+    // then config order.
+    std::vector<SlotRange> slots(own.size());
+    std::vector<Candidate> candidates;
+    for (std::size_t app = 0; app < app_count; ++app) {
+        for (std::size_t key = 0; key < key_count; ++key) {
+            const std::size_t slot = app * key_count + key;
+            const auto begin = static_cast<std::uint32_t>(candidates.size());
+            const SlotRange& mine = own[slot];
+            for (std::uint32_t i = 0; i < mine.count; ++i) {
+                candidates.push_back(compiled[order[mine.begin + i]]);
+            }
+            if (app != kFallbackAppId) {
+                const SlotRange& fallback = own[kFallbackAppId * key_count + key];
+                for (std::uint32_t i = 0; i < fallback.count; ++i) {
+                    candidates.push_back(compiled[order[fallback.begin + i]]);
+                }
+            }
+            const auto first = candidates.begin() + begin;
+            std::stable_sort(first, candidates.end(), MoreSpecific);
+            slots[slot] = SlotRange{begin, static_cast<std::uint32_t>(candidates.size() - begin)};
+        }
+    }
+
+    // One string pool: key names, app names, then actions and modifier spellings.
+    std::string strings = keys.Pool();
+    const std::vector<NameRef> app_names = Rebase(apps.Names(), strings.size());
+    strings += apps.Pool();
+    std::vector<NameRef> action_names;
+    action_names.reserve(actions.size());
+    for (std::string_view action : actions) {
+        action_names.push_back(AppendName(strings, action));
+    }
+    std::vector<ProgramRef> programs;
+    std::vector<ActionOp> program_ops;
+    programs.reserve(actions.size());
+    for (std::string_view action : actions) {
+        programs.push_back(AppendProgram(action, program_ops, 0));
+    }
+    std::vector<NameRef> modifier_names;
+    for (const auto& mod : modifiers) {
+        modifier_names.push_back(AppendName(strings, mod));
+    }
+    if (strings.size() > UINT32_MAX) {
+        throw std::runtime_error("Config is too large to compile");
+    }
+
+    ImageBuilder builder;
+    builder.Add(kStrings, strings.data(), strings.size());
+    builder.Add(kKeyNames, keys.Names());
+    builder.Add(kKeySlots, keys.Slots());
+    builder.Add(kAppNames, app_names);
+    builder.Add(kAppSlots, apps.Slots());
+    builder.Add(kActions, action_names);
+    builder.Add(kModifierNames, modifier_names);
+    builder.Add(kModifierBits, modifier_bits);
+    builder.Add(kModifierKeys, modifier_keys);
+    builder.Add(kSlots, slots);
+    builder.Add(kCandidates, candidates);
+    builder.Add(kRows, rows);
+    builder.Add(kRowMods, row_mods);
+    builder.Add(kPrograms, programs);
+    builder.Add(kProgramOps, program_ops);
+
+    std::shared_ptr<CompiledTable> table(new CompiledTable());
+    table->owned_ = builder.Finish();
+    if (!table->Attach(table->owned_.data(), table->owned_.size() * sizeof(std::uint64_t))) {
+        throw std::logic_error("Compiled table failed its own validation");
+    }
+    return table;
+}
+
+// Splices the edited rows into a copy of this image. Slots are recomputed only for the
+// (app, key) groups an edit touches, and those runs are appended to the candidate pool;
+// the runs they replace stay behind as dead entries until a full Build() compacts them.
+// Everything untouched is copied section by section without being looked at.
+std::shared_ptr<const CompiledTable> CompiledTable::Patch(const std::vector<Edit>& edits) const {
+    const std::size_t key_count = keys_.count;
+    const std::size_t app_count = apps_.count;
+    const auto row_count = static_cast<std::uint32_t>(rows_.size());
+
+    // Where each app's rows live. Apps without rows splice in at the end.
+    std::vector<SlotRange> segments(app_count, SlotRange{row_count, 0});
+    std::vector<bool> seen(app_count, false);
+    for (std::uint32_t i = 0; i < row_count;) {
+        const AppId app = rows_[i].app;
+        if (seen[app]) {
+            return nullptr; // not grouped by app; only a fresh Build() restores that
+        }
+        seen[app] = true;
+        std::uint32_t end = i;
+        while (end < row_count && rows_[end].app == app) {
+            ++end;
+        }
+        segments[app] = SlotRange{i, end - i};
+        i = end;
+    }
+
+    struct Splice {
+        AppId app;
+        std::uint32_t at; // absolute position in rows_
+        std::uint32_t removed;
+        std::vector<Row> rows;
+        std::vector<KeyId> keys; // sources whose groups change, sorted
+    };
+    std::string strings_tail;
+    std::vector<NameRef> actions_tail;
+    std::vector<ProgramRef> programs_tail;
+    std::vector<ActionOp> program_ops_tail;
+    std::vector<KeyId> row_mods_tail;
+    std::vector<Splice> splices;
+    std::vector<bool> edited(app_count, false);
+    std::size_t removed_total = 0;
+    std::size_t inserted_total = 0;
+    for (const Edit& edit : edits) {
+        const KeyId app_id = apps_.Find(edit.app);
+        if (app_id == kInvalidKeyId || edited[app_id]) {
+            return nullptr;
+        }
+        edited[app_id] = true;
+        const auto app = static_cast<AppId>(app_id);
+        const SlotRange segment = segments[app];
+        if (edit.index > segment.count || edit.removed > segment.count - edit.index) {
+            throw std::invalid_argument("CompiledTable::Patch edit is out of range for app " + edit.app);
+        }
+
+        Splice splice{app, segment.begin + edit.index, edit.removed, {}, {}};
+        for (std::uint32_t i = 0; i < edit.removed; ++i) {
+            splice.keys.push_back(rows_[splice.at + i].source);
+        }
+        for (const MappingDefinition& def : edit.inserted) {
+            Row row;
+            row.app = app;
+            row.source = keys_.Find(def.source);
+            if (row.source == kInvalidKeyId) {
+                return nullptr;
+            }
+            row.action = static_cast<std::uint32_t>(actions_.size() + actions_tail.size());
+            actions_tail.push_back(NameRef{static_cast<std::uint32_t>(strings_.size() + strings_tail.size()),
+                                           static_cast<std::uint32_t>(def.target.size())});
+            strings_tail += def.target;
+            programs_tail.push_back(AppendProgram(def.target, program_ops_tail, program_ops_.size()));
+            row.mods_begin = static_cast<std::uint32_t>(row_mods_.size() + row_mods_tail.size());
+            row.mods_count = static_cast<std::uint32_t>(def.required_mods.size());
+            for (const auto& mod : def.required_mods) {
+                const KeyId mod_id = keys_.Find(mod);
+                if (mod_id == kInvalidKeyId) {
+                    return nullptr;
+                }
+                row_mods_tail.push_back(mod_id);
+            }
+            splice.keys.push_back(row.source);
+            splice.rows.push_back(row);
+        }
+        std::sort(splice.keys.begin(), splice.keys.end());
+        splice.keys.erase(std::unique(splice.keys.begin(), splice.keys.end()), splice.keys.end());
+        removed_total += edit.removed;
+        inserted_total += edit.inserted.size();
+        splices.push_back(std::move(splice));
+    }
+    // Appending to one app's segment and editing the start of the next share a position;
+    // the earlier segment's splice has to come first.
+    std::sort(splices.begin(), splices.end(), [&](const Splice& lhs, const Splice& rhs) {
+        if (lhs.at != rhs.at) {
+            return lhs.at < rhs.at;
+        }
+        return segments[lhs.app].begin < segments[rhs.app].begin;
+    });
+
+    const std::size_t live_rows = rows_.size() - removed_total + inserted_total;
+    if (actions_.size() + inserted_total > 2 * live_rows + kPatchSlack ||
+        strings_.size() + strings_tail.size() > UINT32_MAX) {
+        return nullptr;
+    }
+
+    // Fresh candidate lists for every changed (app, key) group, in config order, then
+    // sorted the same way Build() sorts them.
+    const auto mods_of = [&](const Row& row) {
+        return row.mods_begin < row_mods_.size() ? row_mods_.begin() + row.mods_begin
+                                                 : row_mods_tail.data() + (row.mods_begin - row_mods_.size());
+    };
+    std::map<std::pair<AppId, KeyId>, std::vector<Candidate>> groups;
+    for (const Splice& splice : splices) {
+        for (KeyId key : splice.keys) {
+            groups[{splice.app, key}];
+        }
+        const auto collect = [&](const Row* first, const Row* last) {
+            for (const Row* row = first; row != last; ++row) {
+                if (std::binary_search(splice.keys.begin(), splice.keys.end(), row->source)) {
+                    Candidate candidate;
+                    if (CompileRow(*row, mods_of(*row), modifier_bits_.begin(), candidate)) {
+                        groups[{splice.app, row->source}].push_back(candidate);
+                    }
+                }
+            }
+        };
+        const SlotRange segment = segments[splice.app];
+        collect(rows_.begin() + segment.begin, rows_.begin() + splice.at);
+        collect(splice.rows.data(), splice.rows.data() + splice.rows.size());
+        collect(rows_.begin() + splice.at + splice.removed, rows_.begin() + segment.begin + segment.count);
+    }
+    for (auto& entry : groups) {
+        std::stable_sort(entry.second.begin(), entry.second.end(), MoreSpecific);
+    }
+
+    // A changed app group dirties its own slot; a changed "*" group dirties that key in
+    // every app, since the fallback is merged into all of them.
+    std::vector<std::size_t> dirty;
+    for (const auto& entry : groups) {
+        const auto [app, key] = entry.first;
+        if (app == kFallbackAppId) {
+            for (std::size_t other = 0; other < app_count; ++other) {
+                dirty.push_back(other * key_count + key);
+            }
+        } else {
+            dirty.push_back(app * key_count + key);
+        }
+    }
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+    std::vector<SlotRange> slots(slots_.begin(), slots_.end());
+    std::vector<Candidate> candidates_tail;
+    std::vector<Candidate> own;
+    std::vector<Candidate> fallback;
+    for (std::size_t slot : dirty) {
+        const auto app = static_cast<AppId>(slot / key_count);
+        const auto key = static_cast<KeyId>(slot % key_count);
+        const CandidateRange old = Candidates(app, key);
+        // Unchanged groups are recovered from the old run; it is already in the right order.
+        const auto group_of = [&](AppId owner, std::vector<Candidate>& out) {
+            out.clear();
+            const auto it = groups.find({owner, key});
+            if (it != groups.end()) {
+                out = it->second;
+                return;
+            }
+            std::copy_if(old.begin(), old.end(), std::back_inserter(out),
+                         [&](const Candidate& candidate) { return candidate.app == owner; });
+        };
+        const auto begin = static_cast<std::uint32_t>(candidates_.size() + candidates_tail.size());
+        if (app == kFallbackAppId) {
+            group_of(kFallbackAppId, fallback);
+            candidates_tail.insert(candidates_tail.end(), fallback.begin(), fallback.end());
+        } else {
+            group_of(app, own);
+            group_of(kFallbackAppId, fallback);
+            // std::merge takes from the first range on ties: app rows beat "*".
+            std::merge(own.begin(), own.end(), fallback.begin(), fallback.end(),
+                       std::back_inserter(candidates_tail), MoreSpecific);
+        }
+        slots[slot] = SlotRange{begin, static_cast<std::uint32_t>(candidates_.size() + candidates_tail.size()) - begin};
+    }
+
+    std::size_t live_candidates = 0;
+    for (const SlotRange& slot : slots) {
+        live_candidates += slot.count;
+    }
+    if (candidates_.size() + candidates_tail.size() > 2 * live_candidates + kPatchSlack) {
+        return nullptr;
+    }
+
+    ImageBuilder builder;
+    builder.Add(kStrings, strings_);
+    builder.Add(kStrings, strings_tail.data(), strings_tail.size());
+    builder.Add(kKeyNames, keys_.names, keys_.count);
+    builder.Add(kKeySlots, keys_.slots, keys_.slot_count);
+    builder.Add(kAppNames, apps_.names, apps_.count);
+    builder.Add(kAppSlots, apps_.slots, apps_.slot_count);
+    builder.Add(kActions, actions_);
+    builder.Add(kActions, actions_tail);
+    builder.Add(kModifierNames, modifier_names_);
+    builder.Add(kModifierBits, modifier_bits_);
+    builder.Add(kModifierKeys, modifier_keys_);
+    builder.Add(kSlots, slots);
+    builder.Add(kCandidates, candidates_);
+    builder.Add(kCandidates, candidates_tail);
+    std::uint32_t copied = 0;
+    for (const Splice& splice : splices) {
+        builder.Add(kRows, rows_.begin() + copied, splice.at - copied);
+        builder.Add(kRows, splice.rows);
+        copied = splice.at + splice.removed;
+    }
+    builder.Add(kRows, rows_.begin() + copied, row_count - copied);
+    builder.Add(kRowMods, row_mods_);
+    builder.Add(kRowMods, row_mods_tail);
+    builder.Add(kPrograms, programs_);
+    builder.Add(kPrograms, programs_tail);
+    builder.Add(kProgramOps, program_ops_);
+    builder.Add(kProgramOps, program_ops_tail);
+
+    std::shared_ptr<CompiledTable> table(new CompiledTable());
+    table->owned_ = builder.Finish();
+    if (!table->Attach(table->owned_.data(), table->owned_.size() * sizeof(std::uint64_t))) {
+        throw std::logic_error("Patched table failed validation");
+    }
+    return table;
+}
+
+std::shared_ptr<const CompiledTable> CompiledTable::LoadImage(const std::string& path,
+                                                              std::uint64_t content_hash,
+                                                              std::uint32_t* flags) {
+    auto file = MappedFile::Open(path);
+    if (!file || file->Size() < sizeof(ImageHeader)) {
+        return nullptr;
+    }
+    ImageHeader header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (header.magic != kImageMagic || header.version != kImageVersion || header.platform != PlatformTag() ||
+        header.key_table != kKeyTableFingerprint || header.content_hash != content_hash) {
+        return nullptr;
+    }
+
+    std::shared_ptr<CompiledTable> table(new CompiledTable());
+    if (!table->Attach(file->Data(), file->Size())) {
+        return nullptr;
+    }
+    table->mapping_ = std::move(file);
+    if (flags) {
+        *flags = header.flags;
+    }
+    return table;
+}
+
+bool CompiledTable::WriteImage(const std::string& path, std::uint64_t content_hash, std::uint32_t flags) const {
+    std::vector<std::uint64_t> packed;
+    const void* image = image_;
+    std::size_t image_size = image_size_;
+    if (image == nullptr) {
+        packed = Pack();
+        image = packed.data();
+        image_size = packed.size() * sizeof(std::uint64_t);
+    }
+
+    ImageHeader header;
+    std::memcpy(&header, image, sizeof(header));
+    header.content_hash = content_hash;
+    header.flags = flags;
+
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(static_cast<const char*>(image) + sizeof(header),
+                  static_cast<std::streamsize>(image_size - sizeof(header)));
+        if (!out.flush()) {
+            out.close();
+            std::error_code ignored;
+            std::filesystem::remove(temp, ignored);
+            return false;
+        }
+    }
+
+    // Rename so a concurrent reader sees either the old image or the complete new one.
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::uint64_t> CompiledTable::Pack() const {
+    ImageBuilder builder;
+    builder.Add(kStrings, strings_);
+    builder.Add(kKeyNames, keys_.names, keys_.count);
+    builder.Add(kKeySlots, keys_.slots, keys_.slot_count);
+    builder.Add(kAppNames, apps_.names, apps_.count);
+    builder.Add(kAppSlots, apps_.slots, apps_.slot_count);
+    builder.Add(kActions, actions_);
+    builder.Add(kModifierNames, modifier_names_);
+    builder.Add(kModifierBits, modifier_bits_);
+    builder.Add(kModifierKeys, modifier_keys_);
+    builder.Add(kSlots, slots_);
+    builder.Add(kCandidates, candidates_);
+    builder.Add(kRows, rows_);
+    builder.Add(kRowMods, row_mods_);
+    builder.Add(kPrograms, programs_);
+    builder.Add(kProgramOps, program_ops_);
+    return builder.Finish();
+}
+
+bool CompiledTable::Attach(const void* data, std::size_t size) {
+    if (size < sizeof(ImageHeader)) {
+        return false;
+    }
+    const auto* base = static_cast<const char*>(data);
+    ImageHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.total_size != size) {
+        return false;
+    }
+
+    Range<char> strings;
+    Range<NameRef> key_names;
+    Range<KeyId> key_slots;
+    Range<NameRef> app_names;
+    Range<KeyId> app_slots;
+    if (!ViewSection(base, header, kStrings, strings) || !ViewSection(base, header, kKeyNames, key_names) ||
+        !ViewSection(base, header, kKeySlots, key_slots) || !ViewSection(base, header, kAppNames, app_names) ||
+        !ViewSection(base, header, kAppSlots, app_slots) || !ViewSection(base, header, kActions, actions_) ||
+        !ViewSection(base, header, kModifierNames, modifier_names_) ||
+        !ViewSection(base, header, kModifierBits, modifier_bits_) ||
+        !ViewSection(base, header, kModifierKeys, modifier_keys_) || !ViewSection(base, header, kSlots, slots_) ||
+        !ViewSection(base, header, kCandidates, candidates_) || !ViewSection(base, header, kRows, rows_) ||
+        !ViewSection(base, header, kRowMods, row_mods_) || !ViewSection(base, header, kPrograms, programs_) ||
+        !ViewSection(base, header, kProgramOps, program_ops_)) {
+        return false;
+    }
+
+    // Everything below indexes straight into the image on the hot path, so every id and
+    // range is checked once here rather than on each lookup.
+    const std::size_t key_count = key_names.size();
+    const std::size_t app_count = app_names.size();
+    if (key_count >= kInvalidKeyId || app_count == 0 || app_count >= kInvalidKeyId ||
+        !ValidNames(key_names, strings.size()) || !ValidNames(app_names, strings.size()) ||
+        !ValidNames(actions_, strings.size()) || !ValidNames(modifier_names_, strings.size()) ||
+        !ValidSlots(key_slots, key_count) || !ValidSlots(app_slots, app_count)) {
+        return false;
+    }
+    if (modifier_bits_.size() != key_count || modifier_keys_.size() > kMaxModifiers ||
+        modifier_names_.size() != modifier_keys_.size() || slots_.size() != app_count * key_count ||
+        programs_.size() != actions_.size()) {
+        return false;
+    }
+    const auto valid_key = [&](KeyId key) { return key < key_count; };
+    if (!std::all_of(modifier_keys_.begin(), modifier_keys_.end(), valid_key) ||
+        !std::all_of(row_mods_.begin(), row_mods_.end(), valid_key)) {
+        return false;
+    }
+    for (const SlotRange& slot : slots_) {
+        if (slot.begin > candidates_.size() || slot.count > candidates_.size() - slot.begin) {
+            return false;
+        }
+    }
+    for (const ProgramRef& program : programs_) {
+        if (program.begin > program_ops_.size() || program.count > program_ops_.size() - program.begin) {
+            return false;
+        }
+    }
+    for (const Candidate& candidate : candidates_) {
+        if (candidate.action >= actions_.size() || candidate.app >= app_count) {
+            return false;
+        }
+    }
+    for (const Row& row : rows_) {
+        if (row.app >= app_count || row.source >= key_count || row.action >= actions_.size() ||
+            row.mods_begin > row_mods_.size() || row.mods_count > row_mods_.size() - row.mods_begin) {
+            return false;
+        }
+    }
+
+    strings_ = strings;
+    keys_ = SymbolIndex{strings_.first, key_names.first, static_cast<std::uint32_t>(key_count), key_slots.first,
+                        static_cast<std::uint32_t>(key_slots.size())};
+    apps_ = SymbolIndex{strings_.first, app_names.first, static_cast<std::uint32_t>(app_count), app_slots.first,
+                        static_cast<std::uint32_t>(app_slots.size())};
+    image_ = data;
+    image_size_ = size;
+    IndexInterest();
+    return true;
+}
+
+void CompiledTable::IndexInterest() {
+    interest_.fill(0);
+    for (std::uint32_t id = 0; id < keys_.count; ++id) {
+        const KeyCode key = ResolveNative(LookupKeyName(keys_.Name(static_cast<KeyId>(id))));
+        const auto index = static_cast<std::size_t>(key);
+        if (key != KeyCode::kNone && index < kKeyCodeCount) {
+            interest_[index / 64] |= std::uint64_t{1} << (index % 64);
+        }
+    }
+
+    app_keys_.assign((keys_.count + 63) / 64, 0);
+    for (AppId app = 1; app < apps_.count; ++app) {
+        for (KeyId key = 0; key < keys_.count; ++key) {
+            for (const Candidate& candidate : Candidates(app, key)) {
+                if (candidate.app != kFallbackAppId) {
+                    app_keys_[key / 64] |= std::uint64_t{1} << (key % 64);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+KeyId CompiledTable::FindKey(std::string_view token) const {
+    return keys_.Find(token);
+}
+
+AppId CompiledTable::FindApp(std::string_view app) const {
+    const KeyId id = apps_.Find(app);
+    return id == kInvalidKeyId ? kFallbackAppId : static_cast<AppId>(id);
+}
+
+std::string_view CompiledTable::KeyName(KeyId key) const {
+    return keys_.Name(key);
+}
+
+std::string_view CompiledTable::AppName(AppId app) const {
+    return apps_.Name(app);
+}
+
+std::string_view CompiledTable::Action(std::uint32_t index) const {
+    if (index >= actions_.size()) {
+        throw std::out_of_range("Action index out of range");
+    }
+    return std::string_view(strings_.first + actions_[index].offset, actions_[index].size);
+}
+
+ActionProgram CompiledTable::Program(std::uint32_t index) const {
+    if (index >= programs_.size()) {
+        return {};
+    }
+    const ActionOp* first = program_ops_.begin() + programs_[index].begin;
+    return {first, first + programs_[index].count};
+}
+
+std::size_t CompiledTable::KeyCount() const {
+    return keys_.count;
+}
+
+std::size_t CompiledTable::AppCount() const {
+    return apps_.count;
+}
+
+bool CompiledTable::IsKeyOfInterest(KeyCode key) const {
+    const auto index = static_cast<std::size_t>(key);
+    if (key == KeyCode::kNone || index >= kKeyCodeCount) {
+        return true;
+    }
+    return ((interest_[index / 64] >> (index % 64)) & 1) != 0;
+}
+
+bool CompiledTable::HasAppCandidates(KeyId key) const {
+    if (key >= keys_.count) {
+        return false;
+    }
+    return ((app_keys_[key / 64] >> (key % 64)) & 1) != 0;
+}
+
+ModifierMask CompiledTable::ModifierBit(KeyId key) const {
+    return key < modifier_bits_.size() ? modifier_bits_[key] : 0;
+}
+
+KeyId CompiledTable::ModifierKey(std::size_t index) const {
+    return index < modifier_keys_.size() ? modifier_keys_[index] : kInvalidKeyId;
+}
+
+std::set<std::string> CompiledTable::Modifiers() const {
+    std::set<std::string> names;
+    for (const NameRef& name : modifier_names_) {
+        names.emplace(strings_.first + name.offset, name.size);
+    }
+    return names;
+}
+
+CandidateRange CompiledTable::Candidates(AppId app, KeyId key) const {
+    if (key >= keys_.count || app >= apps_.count) {
+        return {};
+    }
+    const SlotRange& slot = slots_[app * keys_.count + key];
+    const Candidate* first = candidates_.begin() + slot.begin;
+    return {first, first + slot.count};
+}
+
+const Candidate* CompiledTable::Resolve(AppId app, KeyId key, ModifierMask active_mods) const {
+    for (const Candidate& candidate : Candidates(app, key)) {
+        if ((candidate.required_mask & active_mods) == candidate.required_mask) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+CompiledTable::Range<CompiledTable::Row> CompiledTable::Rows() const {
+    return rows_;
+}
+
+CompiledTable::Range<KeyId> CompiledTable::RowModifiers(const Row& row) const {
+    const KeyId* first = row_mods_.begin() + row.mods_begin;
+    return {first, first + row.mods_count};
+}
+
+} // namespace caps::core
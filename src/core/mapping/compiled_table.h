@@ -0,0 +1,189 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/mapping/action_program.h"
+#include "core/mapping/key_symbols.h"
+
+namespace caps::core {
+
+class MappedFile;
+
+// Dense id for a normalized app token. Id 0 is always the "*" fallback row, which is
+// also what unknown apps resolve to.
+using AppId = std::uint16_t;
+inline constexpr AppId kFallbackAppId = 0;
+
+// One resolvable mapping inside a dispatch slot. Slots list their candidates most
+// specific first, so the first candidate whose modifiers are all held wins.
+struct Candidate {
+    ModifierMask required_mask{0};
+    std::uint32_t action{0};      // index into CompiledTable::Action()
+    AppId app{kFallbackAppId};    // row that provided the mapping (kFallbackAppId for "*")
+    std::uint16_t specificity{0}; // popcount of required_mask
+};
+
+// Contiguous run of candidates for one (app, key) slot.
+struct CandidateRange {
+    const Candidate* first{nullptr};
+    const Candidate* last{nullptr};
+
+    [[nodiscard]] const Candidate* begin() const { return first; }
+    [[nodiscard]] const Candidate* end() const { return last; }
+    [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    [[nodiscard]] bool empty() const { return first == last; }
+};
+
+// Immutable dispatch table compiled from the config: a dense (app, key) grid where every
+// slot already has the "*" fallback merged in under the engine's tie-break rules
+// (more modifiers first; on equal counts the app row beats "*", then config order).
+//
+// All tables live in one flat, pointer-free image. A freshly built table owns that image
+// in memory; the config cache writes the same bytes to disk and maps them back on the
+// next start, so a warm start uses the tables in place without re-parsing the INI.
+class CompiledTable {
+public:
+    // Source row kept for enumeration/debugging; the hot path never touches these.
+    struct Row {
+        AppId app{kFallbackAppId};
+        KeyId source{kInvalidKeyId};
+        std::uint32_t action{0};
+        std::uint32_t mods_begin{0}; // range in RowModifiers(), config order
+        std::uint32_t mods_count{0};
+    };
+
+    template <typename T>
+    struct Range {
+        const T* first{nullptr};
+        const T* last{nullptr};
+
+        [[nodiscard]] const T* begin() const { return first; }
+        [[nodiscard]] const T* end() const { return last; }
+        [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last - first); }
+        [[nodiscard]] bool empty() const { return first == last; }
+        [[nodiscard]] const T& operator[](std::size_t index) const { return first[index]; }
+    };
+
+    static std::shared_ptr<const CompiledTable> Build(const ConfigLoader::MappingTable& mappings,
+                                                      const ConfigLoader::ModifierSet& modifiers);
+    // The built-in defaults (kDefaultMappings), compiled at build time into static storage.
+    // Never allocates; the returned pointer owns nothing and is valid for the whole process.
+    static std::shared_ptr<const CompiledTable> Defaults();
+
+    // Replaces `removed` definitions of `app`, starting at position `index` of that app's
+    // list (config order), with `inserted`.
+    struct Edit {
+        std::string app; // normalized app token
+        std::uint32_t index{0};
+        std::uint32_t removed{0};
+        std::vector<MappingDefinition> inserted;
+    };
+
+    // Derives a new table from this one by splicing rows and recomputing only the dispatch
+    // slots whose (app, key) groups the edits touch; everything else is copied as-is.
+    // Returns nullptr when the edits need a full Build(): they name apps or keys this
+    // table has never interned, or enough dead rows have built up that compacting pays off.
+    // Modifiers must be unchanged.
+    [[nodiscard]] std::shared_ptr<const CompiledTable> Patch(const std::vector<Edit>& edits) const;
+
+    // Maps a cached image written by WriteImage(). Returns nullptr (so callers fall back to
+    // the text parser) when the file is missing, was written by another format version or
+    // platform, does not match `content_hash`, or fails validation.
+    static std::shared_ptr<const CompiledTable> LoadImage(const std::string& path,
+                                                          std::uint64_t content_hash,
+                                                          std::uint32_t* flags = nullptr);
+    // Persists the image tagged with `content_hash` and caller-defined `flags`.
+    // Writes to a temporary file and renames it into place; returns false on any I/O error.
+    bool WriteImage(const std::string& path, std::uint64_t content_hash, std::uint32_t flags = 0) const;
+
+    // Raw token -> id without allocating. kInvalidKeyId when the config never names the key.
+    [[nodiscard]] KeyId FindKey(std::string_view token) const;
+    // Raw app token -> row id without allocating. Unknown or empty apps map to the fallback row.
+    [[nodiscard]] AppId FindApp(std::string_view app) const;
+
+    [[nodiscard]] std::string_view KeyName(KeyId key) const;
+    [[nodiscard]] std::string_view AppName(AppId app) const;
+    [[nodiscard]] std::string_view Action(std::uint32_t index) const;
+    // The action compiled to key ops at load. Empty for targets that did not compile
+    // (unknown keys, a dangling hold), which ConfigLoader reports when it parses them.
+    [[nodiscard]] ActionProgram Program(std::uint32_t index) const;
+    [[nodiscard]] std::size_t KeyCount() const;
+    [[nodiscard]] std::size_t AppCount() const;
+    // Unique per table object for the life of the process, unlike its address, which a
+    // later table may reuse. Lets callers cache ids resolved against one table.
+    [[nodiscard]] std::uint64_t Serial() const { return serial_; }
+
+    // Whether a hook event for canonical `key` can matter to this config: the config names
+    // it as a source or modifier, or the key table cannot tell (kNone, native codes). Lets
+    // hooks skip building a KeyEvent for everything else.
+    [[nodiscard]] bool IsKeyOfInterest(KeyCode key) const;
+    // Whether some app row maps `key` itself. When false every app resolves `key` to the
+    // "*" candidates, so the caller need not know which app has focus.
+    [[nodiscard]] bool HasAppCandidates(KeyId key) const;
+
+    [[nodiscard]] ModifierMask ModifierBit(KeyId key) const;
+    [[nodiscard]] KeyId ModifierKey(std::size_t index) const;
+    // Declared modifier names exactly as the config loader normalized them.
+    [[nodiscard]] std::set<std::string> Modifiers() const;
+
+    // Every candidate for `key` in `app`, fallback included, most specific first.
+    [[nodiscard]] CandidateRange Candidates(AppId app, KeyId key) const;
+    // First candidate whose required modifiers are all held, or nullptr.
+    [[nodiscard]] const Candidate* Resolve(AppId app, KeyId key, ModifierMask active_mods) const;
+
+    [[nodiscard]] Range<Row> Rows() const;
+    [[nodiscard]] Range<KeyId> RowModifiers(const Row& row) const;
+
+    ~CompiledTable();
+
+private:
+    struct SlotRange {
+        std::uint32_t begin{0};
+        std::uint32_t count{0};
+    };
+
+    struct DefaultImage; // compile-time tables behind Defaults(), see default_table.cpp
+
+    CompiledTable();
+    explicit CompiledTable(const DefaultImage& image);
+    // Points the views at `data`. Returns false if the image is malformed.
+    bool Attach(const void* data, std::size_t size);
+    static std::uint64_t NextSerial();
+    // Fills interest_ from the interned key names and app_keys_ from the slots.
+    void IndexInterest();
+    // Lays the views out as an image; for tables that have no image of their own.
+    [[nodiscard]] std::vector<std::uint64_t> Pack() const;
+
+    const std::uint64_t serial_{NextSerial()};
+    std::vector<std::uint64_t> owned_;     // image storage for freshly built tables
+    std::unique_ptr<MappedFile> mapping_;  // image storage for cached tables
+                                           // (neither: compiled-in Defaults())
+    std::size_t image_size_{0};
+    const void* image_{nullptr};
+
+    SymbolIndex keys_;
+    SymbolIndex apps_; // app tokens share the key normalization rules
+    Range<char> strings_;
+    Range<NameRef> actions_;
+    Range<NameRef> modifier_names_;
+    Range<ModifierMask> modifier_bits_; // indexed by KeyId, 0 for non-modifiers
+    Range<KeyId> modifier_keys_;        // bit index -> KeyId
+    Range<SlotRange> slots_;            // app * KeyCount() + key
+    Range<Candidate> candidates_;       // slot payloads; patched tables may hold dead runs
+    Range<Row> rows_;                   // grouped by app, config order within each app
+    Range<KeyId> row_mods_;
+    Range<ProgramRef> programs_;   // parallel to actions_
+    Range<ActionOp> program_ops_;
+    std::array<std::uint64_t, kKeyCodeCount / 64> interest_{}; // bit per canonical KeyCode
+    std::vector<std::uint64_t> app_keys_; // bit per KeyId with an app-specific candidate
+};
+
+} // namespace caps::core
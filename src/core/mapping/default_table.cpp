@@ -0,0 +1,328 @@
+#include "compiled_table.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+#include "core/config/default_mappings.h"
+#include "core/config/mapped_file.h"
+#include "core/mapping/key_codes.h"
+
+namespace caps::core {
+
+namespace {
+
+constexpr std::size_t kDefaultRowCount = std::size(kDefaultMappings);
+constexpr std::size_t kDefaultModifierCount = std::size(kDefaultModifiers);
+constexpr std::size_t kMaxDefaultKeys = kDefaultModifierCount + kDefaultRowCount * (1 + kMaxDefaultModifiers);
+constexpr std::size_t kMaxDefaultApps = 1 + kDefaultRowCount;
+
+// KeySymbolTable's sizing: 64 slots, doubled while the load factor would exceed one half.
+constexpr std::size_t SlotCountFor(std::size_t names) {
+    if (names == 0) {
+        return 0;
+    }
+    std::size_t slots = 64;
+    while (names * 2 > slots) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+// HashNormalized() from key_symbols.cpp, for names that are already normalized.
+constexpr std::uint32_t HashName(std::string_view name) {
+    std::uint32_t hash = 2166136261u;
+    for (char ch : name) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr bool IsLowerOrSpace(char ch) {
+    return (ch >= 'a' && ch <= 'z') || ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// Key and app names are interned uppercase with all whitespace dropped.
+constexpr bool IsNormalizedName(std::string_view name) {
+    for (char ch : name) {
+        if (IsLowerOrSpace(ch)) {
+            return false;
+        }
+    }
+    return !name.empty();
+}
+
+// Targets keep single inner spaces ("SHIFT! LEFT") but are otherwise uppercase and trimmed.
+constexpr bool IsNormalizedTarget(std::string_view target) {
+    if (target.empty() || target.front() == ' ' || target.back() == ' ') {
+        return false;
+    }
+    for (std::size_t i = 0; i < target.size(); ++i) {
+        const bool double_space = target[i] == ' ' && target[i + 1] == ' ';
+        if ((target[i] != ' ' && IsLowerOrSpace(target[i])) || double_space) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Key names must be what the hooks report ("ESC", not "ESCAPE" or a hex code).
+constexpr bool IsCanonicalKey(std::string_view name) {
+    const std::string_view canonical = CanonicalKeyToken(name);
+    return IsNormalizedName(name) && (canonical.empty() || canonical == name);
+}
+
+constexpr bool DefaultsAreNormalized() {
+    for (std::size_t i = 0; i < kDefaultModifierCount; ++i) {
+        if (!IsCanonicalKey(kDefaultModifiers[i]) || (i > 0 && !(kDefaultModifiers[i - 1] < kDefaultModifiers[i]))) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < kDefaultRowCount; ++i) {
+        const DefaultMapping& def = kDefaultMappings[i];
+        if (!IsNormalizedName(def.app) || !IsCanonicalKey(def.source) || !IsNormalizedTarget(def.target) ||
+            (i > 0 && def.app < kDefaultMappings[i - 1].app)) {
+            return false;
+        }
+        bool ended = false;
+        for (const std::string_view& mod : def.required_mods) {
+            if (mod.empty()) {
+                ended = true;
+            } else if (ended || !IsCanonicalKey(mod)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(DefaultsAreNormalized(),
+              "kDefaultMappings must be normalized, grouped by app in sorted order, with sorted modifiers");
+
+// Ops in every default program; also rejects a default target that would not compile.
+constexpr std::size_t DefaultProgramOps() {
+    std::size_t ops = 0;
+    for (const DefaultMapping& def : kDefaultMappings) {
+        if (CompileAction(def.target, [&](ActionOp) { ++ops; }) != ActionError::kNone) {
+            return 0;
+        }
+    }
+    return ops;
+}
+
+static_assert(DefaultProgramOps() > 0, "every kDefaultMappings target must compile to an action program");
+
+constexpr std::size_t DefaultStringCapacity() {
+    std::size_t size = 1; // "*"
+    for (const std::string_view& mod : kDefaultModifiers) {
+        size += mod.size() * 2; // key name and modifier name
+    }
+    for (const DefaultMapping& def : kDefaultMappings) {
+        size += def.app.size() + def.source.size() + def.target.size();
+        for (const std::string_view& mod : def.required_mods) {
+            size += mod.size();
+        }
+    }
+    return size;
+}
+
+// Fixed-capacity stand-in for KeySymbolTable's interning order.
+template <std::size_t Capacity>
+struct NameList {
+    std::array<std::string_view, Capacity> names{};
+    std::size_t count{0};
+
+    constexpr KeyId Intern(std::string_view name) {
+        for (std::size_t id = 0; id < count; ++id) {
+            if (names[id] == name) {
+                return static_cast<KeyId>(id);
+            }
+        }
+        names[count] = name;
+        return static_cast<KeyId>(count++);
+    }
+};
+
+} // namespace
+
+// Build() replayed at compile time over kDefaultMappings: same interning order, string
+// pool layout, hash slots and candidate ordering. Arrays are sized for the worst case;
+// the counts say how much of each one the table views.
+struct CompiledTable::DefaultImage {
+    std::array<char, DefaultStringCapacity()> strings{};
+    std::size_t string_count{0};
+    std::array<NameRef, kMaxDefaultKeys> key_names{};
+    std::size_t key_count{0};
+    std::array<KeyId, SlotCountFor(kMaxDefaultKeys)> key_slots{};
+    std::size_t key_slot_count{0};
+    std::array<NameRef, kMaxDefaultApps> app_names{};
+    std::size_t app_count{0};
+    std::array<KeyId, SlotCountFor(kMaxDefaultApps)> app_slots{};
+    std::size_t app_slot_count{0};
+    std::array<NameRef, kDefaultRowCount> actions{};
+    std::array<NameRef, kDefaultModifierCount> modifier_names{};
+    std::array<ModifierMask, kMaxDefaultKeys> modifier_bits{};
+    std::array<KeyId, kDefaultModifierCount> modifier_keys{};
+    std::array<SlotRange, kMaxDefaultApps * kMaxDefaultKeys> slots{};
+    std::array<Candidate, kMaxDefaultApps * kDefaultRowCount> candidates{};
+    std::size_t candidate_count{0};
+    std::array<Row, kDefaultRowCount> rows{};
+    std::array<KeyId, kDefaultRowCount * kMaxDefaultModifiers> row_mods{};
+    std::size_t row_mod_count{0};
+    std::array<ProgramRef, kDefaultRowCount> programs{};
+    std::array<ActionOp, DefaultProgramOps()> program_ops{};
+
+    static constexpr DefaultImage Make() {
+        DefaultImage image;
+        NameList<kMaxDefaultKeys> keys;
+        NameList<kMaxDefaultApps> apps;
+        apps.Intern("*");
+        for (std::size_t bit = 0; bit < kDefaultModifierCount; ++bit) {
+            image.modifier_keys[bit] = keys.Intern(kDefaultModifiers[bit]);
+        }
+        for (std::size_t i = 0; i < kDefaultRowCount; ++i) {
+            const DefaultMapping& def = kDefaultMappings[i];
+            Row& row = image.rows[i];
+            row.app = apps.Intern(def.app);
+            row.source = keys.Intern(def.source);
+            row.action = static_cast<std::uint32_t>(i);
+            row.mods_begin = static_cast<std::uint32_t>(image.row_mod_count);
+            for (const std::string_view& mod : def.required_mods) {
+                if (!mod.empty()) {
+                    image.row_mods[image.row_mod_count++] = keys.Intern(mod);
+                }
+            }
+            row.mods_count = static_cast<std::uint32_t>(image.row_mod_count - row.mods_begin);
+        }
+        image.key_count = keys.count;
+        image.app_count = apps.count;
+
+        // One pool: key names, app names, then actions and modifier spellings.
+        for (std::size_t id = 0; id < keys.count; ++id) {
+            image.key_names[id] = image.Append(keys.names[id]);
+        }
+        for (std::size_t id = 0; id < apps.count; ++id) {
+            image.app_names[id] = image.Append(apps.names[id]);
+        }
+        std::size_t op_count = 0;
+        for (std::size_t i = 0; i < kDefaultRowCount; ++i) {
+            image.actions[i] = image.Append(kDefaultMappings[i].target);
+            const std::size_t begin = op_count;
+            CompileAction(kDefaultMappings[i].target, [&](ActionOp op) { image.program_ops[op_count++] = op; });
+            image.programs[i] = ProgramRef{static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(op_count - begin)};
+        }
+        for (std::size_t bit = 0; bit < kDefaultModifierCount; ++bit) {
+            image.modifier_names[bit] = image.Append(kDefaultModifiers[bit]);
+            image.modifier_bits[image.modifier_keys[bit]] = ModifierMask{1} << bit;
+        }
+
+        image.key_slot_count = SlotCountFor(keys.count);
+        FillSlots(image.key_slots, image.key_slot_count, keys);
+        image.app_slot_count = SlotCountFor(apps.count);
+        FillSlots(image.app_slots, image.app_slot_count, apps);
+
+        // Each slot: the app's rows then the "*" rows in config order, stably sorted by
+        // specificity (insertion sort keeps equal elements in arrival order).
+        for (std::size_t app = 0; app < apps.count; ++app) {
+            for (std::size_t key = 0; key < keys.count; ++key) {
+                const std::size_t begin = image.candidate_count;
+                image.AddCandidates(static_cast<AppId>(app), static_cast<KeyId>(key), begin);
+                if (app != kFallbackAppId) {
+                    image.AddCandidates(kFallbackAppId, static_cast<KeyId>(key), begin);
+                }
+                image.slots[app * keys.count + key] = SlotRange{static_cast<std::uint32_t>(begin),
+                                                                static_cast<std::uint32_t>(image.candidate_count - begin)};
+            }
+        }
+        return image;
+    }
+
+    constexpr NameRef Append(std::string_view name) {
+        const NameRef ref{static_cast<std::uint32_t>(string_count), static_cast<std::uint32_t>(name.size())};
+        for (char ch : name) {
+            strings[string_count++] = ch;
+        }
+        return ref;
+    }
+
+    template <std::size_t SlotCapacity, std::size_t NameCapacity>
+    static constexpr void FillSlots(std::array<KeyId, SlotCapacity>& slots, std::size_t slot_count,
+                                    const NameList<NameCapacity>& names) {
+        for (std::size_t slot = 0; slot < slot_count; ++slot) {
+            slots[slot] = kInvalidKeyId;
+        }
+        const std::size_t mask = slot_count - 1;
+        for (std::size_t id = 0; id < names.count; ++id) {
+            std::size_t slot = HashName(names.names[id]) & mask;
+            while (slots[slot] != kInvalidKeyId) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = static_cast<KeyId>(id);
+        }
+    }
+
+    constexpr void AddCandidates(AppId app, KeyId key, std::size_t slot_begin) {
+        for (const Row& row : rows) {
+            if (row.app != app || row.source != key) {
+                continue;
+            }
+            Candidate candidate;
+            candidate.app = row.app;
+            candidate.action = row.action;
+            bool reachable = true;
+            for (std::uint32_t m = 0; m < row.mods_count; ++m) {
+                const ModifierMask bit = modifier_bits[row_mods[row.mods_begin + m]];
+                reachable = reachable && bit != 0;
+                candidate.required_mask |= bit;
+            }
+            if (!reachable) {
+                continue;
+            }
+            candidate.specificity = static_cast<std::uint16_t>(CountModifiers(candidate.required_mask));
+
+            std::size_t pos = candidate_count++;
+            while (pos > slot_begin && candidates[pos - 1].specificity < candidate.specificity) {
+                candidates[pos] = candidates[pos - 1];
+                --pos;
+            }
+            candidates[pos] = candidate;
+        }
+    }
+};
+
+CompiledTable::CompiledTable(const DefaultImage& image) {
+    const auto view = [](const auto& array, std::size_t count) {
+        using T = typename std::decay_t<decltype(array)>::value_type;
+        return Range<T>{array.data(), array.data() + count};
+    };
+    strings_ = view(image.strings, image.string_count);
+    keys_ = SymbolIndex{image.strings.data(), image.key_names.data(), static_cast<std::uint32_t>(image.key_count),
+                        image.key_slots.data(), static_cast<std::uint32_t>(image.key_slot_count)};
+    apps_ = SymbolIndex{image.strings.data(), image.app_names.data(), static_cast<std::uint32_t>(image.app_count),
+                        image.app_slots.data(), static_cast<std::uint32_t>(image.app_slot_count)};
+    actions_ = view(image.actions, image.actions.size());
+    modifier_names_ = view(image.modifier_names, image.modifier_names.size());
+    modifier_bits_ = view(image.modifier_bits, image.key_count);
+    modifier_keys_ = view(image.modifier_keys, image.modifier_keys.size());
+    slots_ = view(image.slots, image.app_count * image.key_count);
+    candidates_ = view(image.candidates, image.candidate_count);
+    rows_ = view(image.rows, image.rows.size());
+    row_mods_ = view(image.row_mods, image.row_mod_count);
+    programs_ = view(image.programs, image.programs.size());
+    program_ops_ = view(image.program_ops, image.program_ops.size());
+    IndexInterest();
+}
+
+// The image is a constant and the table is a function-local static, so handing it out
+// costs no allocation; the returned pointer shares no ownership.
+std::shared_ptr<const CompiledTable> CompiledTable::Defaults() {
+    static constexpr DefaultImage kImage = DefaultImage::Make();
+    static const CompiledTable table(kImage);
+    return std::shared_ptr<const CompiledTable>(std::shared_ptr<const CompiledTable>(), &table);
+}
+
+} // namespace caps::core
@@ -0,0 +1,528 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace caps::core {
+
+// Canonical key: the USB HID keyboard-page usage id, so core data means the same thing on
+// every platform. Native codes only appear at the adapter edges, through the tables below.
+enum class KeyCode : std::uint16_t {
+    kNone = 0x00,
+    kA = 0x04, kB, kC, kD, kE, kF, kG, kH, kI, kJ, kK, kL, kM,
+    kN, kO, kP, kQ, kR, kS, kT, kU, kV, kW, kX, kY, kZ,
+    k1 = 0x1E, k2, k3, k4, k5, k6, k7, k8, k9, k0,
+    kEnter = 0x28,
+    kEscape = 0x29,
+    kBackspace = 0x2A,
+    kTab = 0x2B,
+    kSpace = 0x2C,
+    kMinus = 0x2D,
+    kEqual = 0x2E,
+    kLeftBracket = 0x2F,
+    kRightBracket = 0x30,
+    kBackslash = 0x31,
+    kSemicolon = 0x33,
+    kQuote = 0x34,
+    kGrave = 0x35,
+    kComma = 0x36,
+    kPeriod = 0x37,
+    kSlash = 0x38,
+    kCapsLock = 0x39,
+    kF1 = 0x3A, kF2, kF3, kF4, kF5, kF6, kF7, kF8, kF9, kF10, kF11, kF12,
+    kInsert = 0x49,
+    kHome = 0x4A,
+    kPageUp = 0x4B,
+    kDelete = 0x4C, // forward delete
+    kEnd = 0x4D,
+    kPageDown = 0x4E,
+    kRight = 0x4F,
+    kLeft = 0x50,
+    kDown = 0x51,
+    kUp = 0x52,
+    kF13 = 0x68, kF14, kF15, kF16, kF17, kF18, kF19, kF20,
+    kLeftControl = 0xE0,
+    kLeftShift = 0xE1,
+    kLeftAlt = 0xE2,
+    kLeftGui = 0xE3,
+    kRightControl = 0xE4,
+    kRightShift = 0xE5,
+    kRightAlt = 0xE6,
+    kRightGui = 0xE7,
+};
+
+// Entries a table indexed by a canonical KeyCode needs.
+inline constexpr std::size_t kKeyCodeCount = 0x100;
+// Entries a table indexed by a native code needs; every platform's codes fit.
+inline constexpr std::size_t kNativeCodeCount = 0x100;
+// ToNative() for keys a platform has no code for.
+inline constexpr std::uint16_t kNoNativeCode = 0xFFFF;
+
+// "0x.." tokens name a platform key code directly. Codes the table knows are folded into
+// their canonical key; the rest reach the adapter unchanged, marked with this bit.
+inline constexpr std::uint16_t kNativeKeyFlag = 0x8000;
+
+constexpr bool IsNativeKey(KeyCode key) {
+    return (static_cast<std::uint16_t>(key) & kNativeKeyFlag) != 0;
+}
+
+constexpr std::uint16_t NativeKeyCode(KeyCode key) {
+    return static_cast<std::uint16_t>(static_cast<std::uint16_t>(key) & ~kNativeKeyFlag);
+}
+
+enum class Platform : std::uint8_t { kMac, kWindows, kLinux };
+inline constexpr std::size_t kPlatformCount = 3;
+
+#if defined(__APPLE__)
+inline constexpr Platform kCurrentPlatform = Platform::kMac;
+#elif defined(_WIN32)
+inline constexpr Platform kCurrentPlatform = Platform::kWindows;
+#else
+inline constexpr Platform kCurrentPlatform = Platform::kLinux;
+#endif
+
+// One physical key: its canonical token (what hooks report and configs normalize to) and
+// its code on each platform (kVK_* virtual key, VK_* code, evdev KEY_*).
+struct KeyInfo {
+    KeyCode key;
+    std::string_view name;
+    std::uint16_t native[kPlatformCount];
+};
+
+namespace detail {
+
+constexpr std::uint16_t kNo = kNoNativeCode;
+
+// clang-format off
+inline constexpr KeyInfo kKeys[] = {
+    //  key                    name         mac   win   linux
+    {KeyCode::kA,            "A",         {0x00, 0x41,  30}},
+    {KeyCode::kB,            "B",         {0x0B, 0x42,  48}},
+    {KeyCode::kC,            "C",         {0x08, 0x43,  46}},
+    {KeyCode::kD,            "D",         {0x02, 0x44,  32}},
+    {KeyCode::kE,            "E",         {0x0E, 0x45,  18}},
+    {KeyCode::kF,            "F",         {0x03, 0x46,  33}},
+    {KeyCode::kG,            "G",         {0x05, 0x47,  34}},
+    {KeyCode::kH,            "H",         {0x04, 0x48,  35}},
+    {KeyCode::kI,            "I",         {0x22, 0x49,  23}},
+    {KeyCode::kJ,            "J",         {0x26, 0x4A,  36}},
+    {KeyCode::kK,            "K",         {0x28, 0x4B,  37}},
+    {KeyCode::kL,            "L",         {0x25, 0x4C,  38}},
+    {KeyCode::kM,            "M",         {0x2E, 0x4D,  50}},
+    {KeyCode::kN,            "N",         {0x2D, 0x4E,  49}},
+    {KeyCode::kO,            "O",         {0x1F, 0x4F,  24}},
+    {KeyCode::kP,            "P",         {0x23, 0x50,  25}},
+    {KeyCode::kQ,            "Q",         {0x0C, 0x51,  16}},
+    {KeyCode::kR,            "R",         {0x0F, 0x52,  19}},
+    {KeyCode::kS,            "S",         {0x01, 0x53,  31}},
+    {KeyCode::kT,            "T",         {0x11, 0x54,  20}},
+    {KeyCode::kU,            "U",         {0x20, 0x55,  22}},
+    {KeyCode::kV,            "V",         {0x09, 0x56,  47}},
+    {KeyCode::kW,            "W",         {0x0D, 0x57,  17}},
+    {KeyCode::kX,            "X",         {0x07, 0x58,  45}},
+    {KeyCode::kY,            "Y",         {0x10, 0x59,  21}},
+    {KeyCode::kZ,            "Z",         {0x06, 0x5A,  44}},
+    {KeyCode::k1,            "1",         {0x12, 0x31,   2}},
+    {KeyCode::k2,            "2",         {0x13, 0x32,   3}},
+    {KeyCode::k3,            "3",         {0x14, 0x33,   4}},
+    {KeyCode::k4,            "4",         {0x15, 0x34,   5}},
+    {KeyCode::k5,            "5",         {0x17, 0x35,   6}},
+    {KeyCode::k6,            "6",         {0x16, 0x36,   7}},
+    {KeyCode::k7,            "7",         {0x1A, 0x37,   8}},
+    {KeyCode::k8,            "8",         {0x1C, 0x38,   9}},
+    {KeyCode::k9,            "9",         {0x19, 0x39,  10}},
+    {KeyCode::k0,            "0",         {0x1D, 0x30,  11}},
+    {KeyCode::kEnter,        "ENTER",     {0x24, 0x0D,  28}},
+    {KeyCode::kEscape,       "ESC",       {0x35, 0x1B,   1}},
+    {KeyCode::kBackspace,    "BACKSPACE", {0x33, 0x08,  14}},
+    {KeyCode::kTab,          "TAB",       {0x30, 0x09,  15}},
+    {KeyCode::kSpace,        "SPACE",     {0x31, 0x20,  57}},
+    {KeyCode::kMinus,        "MINUS",     {0x1B, 0xBD,  12}},
+    {KeyCode::kEqual,        "EQUAL",     {0x18, 0xBB,  13}},
+    {KeyCode::kLeftBracket,  "LBRACKET",  {0x21, 0xDB,  26}},
+    {KeyCode::kRightBracket, "RBRACKET",  {0x1E, 0xDD,  27}},
+    {KeyCode::kBackslash,    "BACKSLASH", {0x2A, 0xDC,  43}},
+    {KeyCode::kSemicolon,    "SEMICOLON", {0x29, 0xBA,  39}},
+    {KeyCode::kQuote,        "QUOTE",     {0x27, 0xDE,  40}},
+    {KeyCode::kGrave,        "GRAVE",     {0x32, 0xC0,  41}},
+    {KeyCode::kComma,        "COMMA",     {0x2B, 0xBC,  51}},
+    {KeyCode::kPeriod,       "PERIOD",    {0x2F, 0xBE,  52}},
+    {KeyCode::kSlash,        "SLASH",     {0x2C, 0xBF,  53}},
+    {KeyCode::kCapsLock,     "CAPSLOCK",  {0x39, 0x14,  58}},
+    {KeyCode::kF1,           "F1",        {0x7A, 0x70,  59}},
+    {KeyCode::kF2,           "F2",        {0x78, 0x71,  60}},
+    {KeyCode::kF3,           "F3",        {0x63, 0x72,  61}},
+    {KeyCode::kF4,           "F4",        {0x76, 0x73,  62}},
+    {KeyCode::kF5,           "F5",        {0x60, 0x74,  63}},
+    {KeyCode::kF6,           "F6",        {0x61, 0x75,  64}},
+    {KeyCode::kF7,           "F7",        {0x62, 0x76,  65}},
+    {KeyCode::kF8,           "F8",        {0x64, 0x77,  66}},
+    {KeyCode::kF9,           "F9",        {0x65, 0x78,  67}},
+    {KeyCode::kF10,          "F10",       {0x6D, 0x79,  68}},
+    {KeyCode::kF11,          "F11",       {0x67, 0x7A,  87}},
+    {KeyCode::kF12,          "F12",       {0x6F, 0x7B,  88}},
+    {KeyCode::kF13,          "F13",       {0x69, 0x7C, 183}},
+    {KeyCode::kF14,          "F14",       {0x6B, 0x7D, 184}},
+    {KeyCode::kF15,          "F15",       {0x71, 0x7E, 185}},
+    {KeyCode::kF16,          "F16",       {0x6A, 0x7F, 186}},
+    {KeyCode::kF17,          "F17",       {0x40, 0x80, 187}},
+    {KeyCode::kF18,          "F18",       {0x4F, 0x81, 188}},
+    {KeyCode::kF19,          "F19",       {0x50, 0x82, 189}},
+    {KeyCode::kF20,          "F20",       {0x5A, 0x83, 190}},
+    {KeyCode::kInsert,       "INSERT",    {0x72, 0x2D, 110}}, // kVK_Help sits where Insert is
+    {KeyCode::kHome,         "HOME",      {0x73, 0x24, 102}},
+    {KeyCode::kPageUp,       "PAGEUP",    {0x74, 0x21, 104}},
+    {KeyCode::kDelete,       "DELETE",    {0x75, 0x2E, 111}},
+    {KeyCode::kEnd,          "END",       {0x77, 0x23, 107}},
+    {KeyCode::kPageDown,     "PAGEDOWN",  {0x79, 0x22, 109}},
+    {KeyCode::kRight,        "RIGHT",     {0x7C, 0x27, 106}},
+    {KeyCode::kLeft,         "LEFT",      {0x7B, 0x25, 105}},
+    {KeyCode::kDown,         "DOWN",      {0x7D, 0x28, 108}},
+    {KeyCode::kUp,           "UP",        {0x7E, 0x26, 103}},
+    {KeyCode::kLeftControl,  "LCTRL",     {0x3B, 0xA2,  29}},
+    {KeyCode::kLeftShift,    "LSHIFT",    {0x38, 0xA0,  42}},
+    {KeyCode::kLeftAlt,      "LALT",      {0x3A, 0xA4,  56}},
+    {KeyCode::kLeftGui,      "LCMD",      {0x37, 0x5B, 125}},
+    {KeyCode::kRightControl, "RCTRL",     {0x3E, 0xA3,  97}},
+    {KeyCode::kRightShift,   "RSHIFT",    {0x3C, 0xA1,  54}},
+    {KeyCode::kRightAlt,     "RALT",      {0x3D, 0xA5, 100}},
+    {KeyCode::kRightGui,     "RCMD",      {0x36, 0x5C, 126}},
+};
+
+struct KeyAlias {
+    std::string_view name;
+    KeyCode key;
+};
+
+// Other spellings configs may use; they normalize to the canonical name.
+inline constexpr KeyAlias kAliases[] = {
+    {"ESCAPE", KeyCode::kEscape},   {"RETURN", KeyCode::kEnter},
+    {"DEL", KeyCode::kDelete},      {"INS", KeyCode::kInsert},
+    {"PGUP", KeyCode::kPageUp},     {"PGDN", KeyCode::kPageDown},
+    {"-", KeyCode::kMinus},         {"=", KeyCode::kEqual},
+    {"\\", KeyCode::kBackslash},    {";", KeyCode::kSemicolon},
+    {"'", KeyCode::kQuote},         {"`", KeyCode::kGrave},
+    {",", KeyCode::kComma},         {".", KeyCode::kPeriod},
+    {"/", KeyCode::kSlash},
+    {"SHIFT", KeyCode::kLeftShift}, {"CTRL", KeyCode::kLeftControl},
+    {"CONTROL", KeyCode::kLeftControl}, {"LCONTROL", KeyCode::kLeftControl},
+    {"RCONTROL", KeyCode::kRightControl}, {"ALT", KeyCode::kLeftAlt},
+    {"OPTION", KeyCode::kLeftAlt},  {"LOPTION", KeyCode::kLeftAlt},
+    {"ROPTION", KeyCode::kRightAlt}, {"CMD", KeyCode::kLeftGui},
+    {"COMMAND", KeyCode::kLeftGui}, {"META", KeyCode::kLeftGui},
+    {"SUPER", KeyCode::kLeftGui},   {"WIN", KeyCode::kLeftGui},
+    {"LWIN", KeyCode::kLeftGui},    {"RWIN", KeyCode::kRightGui},
+};
+
+// Extra native codes that fold into a key the main table already names: Windows reports
+// the side-less VK_SHIFT/VK_CONTROL/VK_MENU from some sources.
+struct NativeAlias {
+    Platform platform;
+    std::uint16_t code;
+    KeyCode key;
+};
+inline constexpr NativeAlias kNativeAliases[] = {
+    {Platform::kWindows, 0x10, KeyCode::kLeftShift},
+    {Platform::kWindows, 0x11, KeyCode::kLeftControl},
+    {Platform::kWindows, 0x12, KeyCode::kLeftAlt},
+};
+// clang-format on
+
+inline constexpr std::size_t kKeyCount = std::size(kKeys);
+inline constexpr std::size_t kNameCount = kKeyCount + std::size(kAliases);
+
+// Name lookup is a two-level perfect hash ("hash and displace"): a first hash picks a
+// bucket, the bucket's displacement picks the slot, and the slot is checked with a single
+// compare. Every name gets a slot of its own, found at compile time.
+inline constexpr std::size_t kNameBuckets = 64;
+inline constexpr std::size_t kNameSlots = 256;
+static_assert(kNameSlots >= kNameCount);
+
+constexpr std::uint32_t HashName(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (const char& ch : name) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+constexpr std::string_view NameAt(std::size_t index) {
+    return index < kKeyCount ? kKeys[index].name : kAliases[index - kKeyCount].name;
+}
+
+constexpr KeyCode KeyAt(std::size_t index) {
+    return index < kKeyCount ? kKeys[index].key : kAliases[index - kKeyCount].key;
+}
+
+struct NameIndex {
+    std::array<std::uint16_t, kNameBuckets> displacement{};
+    std::array<std::string_view, kNameSlots> names{};
+    std::array<KeyCode, kNameSlots> keys{};
+    bool ok{false};
+};
+
+constexpr NameIndex BuildNameIndex() {
+    NameIndex index;
+    std::array<std::size_t, kNameCount> bucket_of{};
+    std::array<std::size_t, kNameBuckets> bucket_size{};
+    for (std::size_t i = 0; i < kNameCount; ++i) {
+        bucket_of[i] = HashName(NameAt(i), 0) % kNameBuckets;
+        ++bucket_size[bucket_of[i]];
+    }
+    std::array<bool, kNameSlots> used{};
+
+    // Place the fullest buckets first, while the table is emptiest.
+    for (std::size_t size = kNameCount; size > 0; --size) {
+        for (std::size_t bucket = 0; bucket < kNameBuckets; ++bucket) {
+            if (bucket_size[bucket] != size) {
+                continue;
+            }
+            bool placed = false;
+            for (std::uint32_t d = 1; d < 0x10000 && !placed; ++d) {
+                std::array<std::size_t, kNameCount> slots{};
+                std::size_t count = 0;
+                bool fits = true;
+                for (std::size_t i = 0; i < kNameCount && fits; ++i) {
+                    if (bucket_of[i] != bucket) {
+                        continue;
+                    }
+                    const std::size_t slot = HashName(NameAt(i), d) % kNameSlots;
+                    fits = !used[slot];
+                    for (std::size_t j = 0; j < count && fits; ++j) {
+                        fits = slots[j] != slot;
+                    }
+                    slots[count++] = slot;
+                }
+                if (!fits) {
+                    continue;
+                }
+                count = 0;
+                for (std::size_t i = 0; i < kNameCount; ++i) {
+                    if (bucket_of[i] == bucket) {
+                        const std::size_t slot = slots[count++];
+                        used[slot] = true;
+                        index.names[slot] = NameAt(i);
+                        index.keys[slot] = KeyAt(i);
+                    }
+                }
+                index.displacement[bucket] = static_cast<std::uint16_t>(d);
+                placed = true;
+            }
+            if (!placed) {
+                return index;
+            }
+        }
+    }
+    index.ok = true;
+    return index;
+}
+
+inline constexpr NameIndex kNameIndex = BuildNameIndex();
+static_assert(kNameIndex.ok, "no displacement seats every key name; grow kNameSlots");
+
+// Dense tables for the code paths: canonical -> name and native code per platform, and
+// native code -> canonical per platform.
+struct CodeTables {
+    std::array<std::string_view, kKeyCodeCount> names{};
+    std::array<std::array<std::uint16_t, kKeyCodeCount>, kPlatformCount> to_native{};
+    std::array<std::array<KeyCode, kNativeCodeCount>, kPlatformCount> from_native{};
+    bool ok{true};
+};
+
+constexpr CodeTables BuildCodeTables() {
+    CodeTables tables;
+    for (auto& platform : tables.to_native) {
+        for (std::uint16_t& code : platform) {
+            code = kNoNativeCode;
+        }
+    }
+    for (const KeyInfo& info : kKeys) {
+        const auto key = static_cast<std::size_t>(info.key);
+        tables.ok = tables.ok && key < kKeyCodeCount && tables.names[key].empty();
+        tables.names[key] = info.name;
+        for (std::size_t p = 0; p < kPlatformCount; ++p) {
+            const std::uint16_t code = info.native[p];
+            tables.to_native[p][key] = code;
+            if (code != kNoNativeCode) {
+                tables.ok = tables.ok && code < kNativeCodeCount && tables.from_native[p][code] == KeyCode::kNone;
+                tables.from_native[p][code] = info.key;
+            }
+        }
+    }
+    for (const NativeAlias& alias : kNativeAliases) {
+        auto& slot = tables.from_native[static_cast<std::size_t>(alias.platform)][alias.code];
+        tables.ok = tables.ok && slot == KeyCode::kNone;
+        slot = alias.key;
+    }
+    return tables;
+}
+
+inline constexpr CodeTables kCodeTables = BuildCodeTables();
+static_assert(kCodeTables.ok, "key table has a duplicate key or native code");
+
+// "0X1F"-style spellings for every native code, matching what the hooks used to build
+// with an ostringstream, so unnamed keys still have a stable token.
+struct HexTokens {
+    std::array<std::array<char, 4>, kNativeCodeCount> text{};
+    std::array<std::uint8_t, kNativeCodeCount> size{};
+};
+
+constexpr HexTokens BuildHexTokens() {
+    constexpr char kDigits[] = "0123456789ABCDEF";
+    HexTokens tokens;
+    for (std::size_t code = 0; code < kNativeCodeCount; ++code) {
+        auto& text = tokens.text[code];
+        text[0] = '0';
+        text[1] = 'X';
+        std::uint8_t size = 2;
+        if (code >= 16) {
+            text[size++] = kDigits[code >> 4];
+        }
+        text[size++] = kDigits[code & 0xF];
+        tokens.size[code] = size;
+    }
+    return tokens;
+}
+
+inline constexpr HexTokens kHexTokens = BuildHexTokens();
+
+constexpr int HexDigit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+} // namespace detail
+
+// Canonical key for one normalized (uppercase) token, aliases included; kNone when the
+// token names no key. "0X1F"-style tokens come back as flagged native codes.
+constexpr KeyCode LookupKeyName(std::string_view name) {
+    if (name.size() > 2 && name[0] == '0' && name[1] == 'X') {
+        std::uint32_t value = 0;
+        for (std::size_t i = 2; i < name.size(); ++i) {
+            const int digit = detail::HexDigit(name[i]);
+            if (digit < 0) {
+                return KeyCode::kNone;
+            }
+            value = value * 16 + static_cast<std::uint32_t>(digit);
+            if (value >= kNativeKeyFlag) {
+                return KeyCode::kNone;
+            }
+        }
+        return static_cast<KeyCode>(kNativeKeyFlag | value);
+    }
+    const std::uint32_t bucket = detail::HashName(name, 0) % detail::kNameBuckets;
+    const std::uint32_t slot = detail::HashName(name, detail::kNameIndex.displacement[bucket]) % detail::kNameSlots;
+    return detail::kNameIndex.names[slot] == name ? detail::kNameIndex.keys[slot] : KeyCode::kNone;
+}
+
+namespace detail {
+
+constexpr std::uint64_t FingerprintBytes(std::uint64_t hash, std::string_view bytes) {
+    for (const char ch : bytes) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ 0xFF; // terminator, so adjacent names cannot run together
+}
+
+constexpr std::uint64_t FingerprintValue(std::uint64_t hash, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t KeyTableFingerprint() {
+    std::uint64_t hash = 14695981039346656037ull;
+    hash = FingerprintValue(hash, kKeyCodeCount);
+    hash = FingerprintValue(hash, kNativeCodeCount);
+    hash = FingerprintValue(hash, kNativeKeyFlag);
+    for (const KeyInfo& info : kKeys) {
+        hash = FingerprintValue(hash, static_cast<std::uint64_t>(info.key));
+        hash = FingerprintBytes(hash, info.name);
+        for (const std::uint16_t code : info.native) {
+            hash = FingerprintValue(hash, code);
+        }
+    }
+    for (const KeyAlias& alias : kAliases) {
+        hash = FingerprintBytes(hash, alias.name);
+        hash = FingerprintValue(hash, static_cast<std::uint64_t>(alias.key));
+    }
+    for (const NativeAlias& alias : kNativeAliases) {
+        hash = FingerprintValue(hash, static_cast<std::uint64_t>(alias.platform));
+        hash = FingerprintValue(hash, alias.code);
+        hash = FingerprintValue(hash, static_cast<std::uint64_t>(alias.key));
+    }
+    return hash;
+}
+
+} // namespace detail
+
+// Changes with any edit to the tables above: codes, names, aliases, native codes.
+// Compiled tables persisted to disk hold KeyCodes and name lookups resolved against
+// this file, so they record it and are rebuilt when it no longer matches.
+inline constexpr std::uint64_t kKeyTableFingerprint = detail::KeyTableFingerprint();
+
+// Canonical spelling of `key`; empty for codes the table does not name.
+constexpr std::string_view KeyName(KeyCode key) {
+    const auto index = static_cast<std::size_t>(key);
+    return index < kKeyCodeCount ? detail::kCodeTables.names[index] : std::string_view();
+}
+
+// Native code for `key` on `platform`; flagged native keys pass through. kNoNativeCode when
+// the platform has no such key.
+constexpr std::uint16_t ToNative(KeyCode key, Platform platform = kCurrentPlatform) {
+    if (IsNativeKey(key)) {
+        return NativeKeyCode(key);
+    }
+    const auto index = static_cast<std::size_t>(key);
+    return index < kKeyCodeCount ? detail::kCodeTables.to_native[static_cast<std::size_t>(platform)][index]
+                                 : kNoNativeCode;
+}
+
+// Canonical key for a native code on `platform`; kNone when the table has no entry.
+constexpr KeyCode FromNative(std::uint32_t code, Platform platform = kCurrentPlatform) {
+    return code < kNativeCodeCount ? detail::kCodeTables.from_native[static_cast<std::size_t>(platform)][code]
+                                   : KeyCode::kNone;
+}
+
+// Folds a flagged native key into its canonical key when `platform` knows the code.
+constexpr KeyCode ResolveNative(KeyCode key, Platform platform = kCurrentPlatform) {
+    if (!IsNativeKey(key)) {
+        return key;
+    }
+    const KeyCode canonical = FromNative(NativeKeyCode(key), platform);
+    return canonical == KeyCode::kNone ? key : canonical;
+}
+
+// What a hook reports for a native code: the canonical name, or "0X.." for keys the table
+// does not name. Empty only for codes past kNativeCodeCount.
+constexpr std::string_view NativeKeyToken(std::uint32_t code, Platform platform = kCurrentPlatform) {
+    if (code >= kNativeCodeCount) {
+        return {};
+    }
+    const std::string_view name = KeyName(detail::kCodeTables.from_native[static_cast<std::size_t>(platform)][code]);
+    if (!name.empty()) {
+        return name;
+    }
+    return std::string_view(detail::kHexTokens.text[code].data(), detail::kHexTokens.size[code]);
+}
+
+// The token a normalized config key should be stored under so it matches NativeKeyToken():
+// aliases become the canonical name and hex codes the platform knows become that key's
+// name. Tokens the table cannot place come back unchanged (empty view).
+constexpr std::string_view CanonicalKeyToken(std::string_view normalized, Platform platform = kCurrentPlatform) {
+    const KeyCode key = ResolveNative(LookupKeyName(normalized), platform);
+    if (IsNativeKey(key)) {
+        const std::uint16_t code = NativeKeyCode(key);
+        return code < kNativeCodeCount ? NativeKeyToken(code, platform) : std::string_view();
+    }
+    return KeyName(key);
+}
+
+} // namespace caps::core
@@ -0,0 +1,153 @@
+#include "key_symbols.h"
+
+#include <cctype>
+#include <stdexcept>
+
+namespace caps::core {
+
+namespace {
+
+constexpr std::size_t kInitialSlots = 64;
+
+bool IsSpace(char ch) {
+    return std::isspace(static_cast<unsigned char>(ch)) != 0;
+}
+
+char Upper(char ch) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+}
+
+// FNV-1a over the normalized spelling, computed without materializing it. The value is
+// persisted inside compiled images, so it must stay stable across builds.
+std::uint32_t HashNormalized(std::string_view token) {
+    std::uint32_t hash = 2166136261u;
+    for (char ch : token) {
+        if (IsSpace(ch)) {
+            continue;
+        }
+        hash ^= static_cast<unsigned char>(Upper(ch));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Compares a raw token against an already-normalized name.
+bool EqualsNormalized(std::string_view raw, std::string_view normalized) {
+    std::size_t pos = 0;
+    for (char ch : raw) {
+        if (IsSpace(ch)) {
+            continue;
+        }
+        if (pos >= normalized.size() || normalized[pos] != Upper(ch)) {
+            return false;
+        }
+        ++pos;
+    }
+    return pos == normalized.size();
+}
+
+// Linear probe until we hit the matching name or an empty slot.
+std::uint32_t ProbeSlot(const SymbolIndex& index, std::string_view token, std::uint32_t hash) {
+    const std::uint32_t mask = index.slot_count - 1;
+    std::uint32_t slot = hash & mask;
+    while (index.slots[slot] != kInvalidKeyId && !EqualsNormalized(token, index.Name(index.slots[slot]))) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+} // namespace
+
+KeyId SymbolIndex::Find(std::string_view token) const {
+    if (slot_count == 0) {
+        return kInvalidKeyId;
+    }
+    return slots[ProbeSlot(*this, token, HashNormalized(token))];
+}
+
+std::string_view SymbolIndex::Name(KeyId id) const {
+    if (id >= count) {
+        throw std::out_of_range("KeyId out of range");
+    }
+    return std::string_view(pool + names[id].offset, names[id].size);
+}
+
+KeyId KeySymbolTable::Intern(std::string_view token) {
+    const KeyId existing = Find(token);
+    if (existing != kInvalidKeyId) {
+        return existing;
+    }
+
+    NameRef name;
+    name.offset = static_cast<std::uint32_t>(pool_.size());
+    for (char ch : token) {
+        if (!IsSpace(ch)) {
+            pool_.push_back(Upper(ch));
+        }
+    }
+    name.size = static_cast<std::uint32_t>(pool_.size() - name.offset);
+    if (name.size == 0) {
+        return kInvalidKeyId;
+    }
+    if (names_.size() >= kInvalidKeyId) {
+        pool_.resize(name.offset);
+        throw std::runtime_error("Too many distinct key tokens in config");
+    }
+
+    const auto id = static_cast<KeyId>(names_.size());
+    names_.push_back(name);
+    // Keep the load factor at or below one half so probe chains stay short.
+    if (names_.size() * 2 > slots_.size()) {
+        Rehash(slots_.empty() ? kInitialSlots : slots_.size() * 2);
+    } else {
+        const std::string_view normalized(pool_.data() + name.offset, name.size);
+        slots_[ProbeSlot(View(), normalized, HashNormalized(normalized))] = id;
+    }
+    return id;
+}
+
+KeyId KeySymbolTable::Find(std::string_view token) const {
+    return View().Find(token);
+}
+
+std::string_view KeySymbolTable::Name(KeyId id) const {
+    return View().Name(id);
+}
+
+std::size_t KeySymbolTable::Size() const {
+    return names_.size();
+}
+
+void KeySymbolTable::Clear() {
+    pool_.clear();
+    names_.clear();
+    slots_.clear();
+}
+
+const std::string& KeySymbolTable::Pool() const {
+    return pool_;
+}
+
+const std::vector<NameRef>& KeySymbolTable::Names() const {
+    return names_;
+}
+
+const std::vector<KeyId>& KeySymbolTable::Slots() const {
+    return slots_;
+}
+
+SymbolIndex KeySymbolTable::View() const {
+    return SymbolIndex{pool_.data(), names_.data(), static_cast<std::uint32_t>(names_.size()),
+                       slots_.data(), static_cast<std::uint32_t>(slots_.size())};
+}
+
+void KeySymbolTable::Rehash(std::size_t slot_count) {
+    slots_.assign(slot_count, kInvalidKeyId);
+    const SymbolIndex index = View();
+    for (std::size_t id = 0; id < names_.size(); ++id) {
+        const std::string_view name = index.Name(static_cast<KeyId>(id));
+        slots_[ProbeSlot(index, name, HashNormalized(name))] = static_cast<KeyId>(id);
+    }
+}
+
+} // namespace caps::core
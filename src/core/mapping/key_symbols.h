@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace caps::core {
+
+// Dense integer handle for a normalized key token. Ids are handed out when the config
+// is compiled so the per-keystroke path compares integers instead of strings.
+using KeyId = std::uint16_t;
+inline constexpr KeyId kInvalidKeyId = 0xFFFF;
+
+// Layer modifiers are compiled into bit positions so "all required modifiers held"
+// is a single mask test. The width caps how many modifiers a config may declare.
+using ModifierMask = std::uint64_t;
+inline constexpr std::size_t kMaxModifiers = 64;
+
+// Number of modifiers set in `mask`; only used off the hot path (table builds, logging).
+constexpr int CountModifiers(ModifierMask mask) {
+    int count = 0;
+    while (mask != 0) {
+        mask &= mask - 1;
+        ++count;
+    }
+    return count;
+}
+
+// Location of a name inside a shared character pool.
+struct NameRef {
+    std::uint32_t offset{0};
+    std::uint32_t size{0};
+};
+
+// Read-only, open-addressed hash index over normalized names. It only holds pointers,
+// so it can sit on top of a KeySymbolTable or directly on a compiled config image.
+// Lookups normalize the probe token on the fly (whitespace stripped, ASCII uppercased)
+// so hooks can pass raw tokens without allocating a normalized copy.
+struct SymbolIndex {
+    const char* pool{nullptr};
+    const NameRef* names{nullptr};
+    std::uint32_t count{0};
+    const KeyId* slots{nullptr};
+    std::uint32_t slot_count{0}; // power of two, always larger than `count` when non-zero
+
+    [[nodiscard]] KeyId Find(std::string_view token) const;
+    [[nodiscard]] std::string_view Name(KeyId id) const;
+};
+
+// Builds a SymbolIndex by interning tokens into dense KeyIds, normalized the same way
+// the mapping engine always has.
+class KeySymbolTable {
+public:
+    // Returns the id for `token`, assigning the next dense id if it is new.
+    // Returns kInvalidKeyId for tokens that normalize to nothing.
+    KeyId Intern(std::string_view token);
+    // Looks up an existing token without inserting. Never allocates.
+    [[nodiscard]] KeyId Find(std::string_view token) const;
+    // Normalized spelling of an interned id.
+    [[nodiscard]] std::string_view Name(KeyId id) const;
+    [[nodiscard]] std::size_t Size() const;
+    void Clear();
+
+    // Raw pieces, exposed so compiled tables can copy them into a flat image.
+    [[nodiscard]] const std::string& Pool() const;
+    [[nodiscard]] const std::vector<NameRef>& Names() const;
+    [[nodiscard]] const std::vector<KeyId>& Slots() const;
+    [[nodiscard]] SymbolIndex View() const;
+
+private:
+    void Rehash(std::size_t slot_count);
+
+    std::string pool_;            // normalized names, back to back
+    std::vector<NameRef> names_;  // KeyId -> pool_ range
+    std::vector<KeyId> slots_;    // open-addressed hash index into names_
+};
+
+} // namespace caps::core
@@ -2,11 +2,19 @@
 
 #include <algorithm>
 #include <cctype>
+#include <stdexcept>
 #include <utility>
 
 namespace caps::core {
 
-MappingEngine::MappingEngine(const ConfigLoader& config) : config_(config) {}
+MappingEngine::MappingEngine(const ConfigLoader& config)
+    : config_(config) {
+    Publish(CompiledTable::Build({}, {}));
+}
+
+// Readers must be gone by now, so the live table can go with owner_. Tables retired by
+// earlier reloads stay with the epoch domain until it frees them.
+MappingEngine::~MappingEngine() = default;
 
 // Builds the initial lookup table. No-op if called more than once.
 void MappingEngine::Initialize() {
@@ -18,99 +26,165 @@ void MappingEngine::UpdateFromConfig() {
     RebuildTable();
 }
 
+MappingEngine::Snapshot MappingEngine::Acquire() const {
+    auto guard = EpochDomain::Global().Pin();
+    return Snapshot(std::move(guard), table_.load(std::memory_order_seq_cst));
+}
+
+KeyId MappingEngine::LookupKey(std::string_view key) const {
+    return Acquire()->FindKey(key);
+}
+
+std::string MappingEngine::KeyName(KeyId key) const {
+    return std::string(Acquire()->KeyName(key));
+}
+
 // Returns the mapped action if the layer defines one for the given app (with fallback). Otherwise std::nullopt.
 // When multiple mappings exist for the same source key, the one with the most matching modifiers wins.
+// The compiled slot already lists app and "*" candidates most specific first, so this is a
+// single short scan over the candidates for this key.
 std::optional<MappingEngine::ResolvedMapping> MappingEngine::ResolveMapping(
-    const std::string& key,
+    KeyId key,
     const std::string& app,
-    const std::set<std::string>& active_mods) const {
-    if (key.empty()) {
+    ModifierMask active_mods) const {
+    return ResolveMapping(Acquire(), key, app, active_mods);
+}
+
+std::optional<MappingEngine::ResolvedMapping> MappingEngine::ResolveMapping(
+    const Snapshot& snapshot,
+    KeyId key,
+    const std::string& app,
+    ModifierMask active_mods) {
+    if (key == kInvalidKeyId) {
         return std::nullopt;
     }
+    return ResolveMapping(snapshot, key, snapshot->FindApp(app), active_mods);
+}
 
-    const std::string normalized = NormalizeToken(key);
-    const std::string normalized_app = NormalizeAppToken(app);
-
-    // Helper to find best matching mapping from a definitions list
-    auto find_best_match = [&](const std::vector<MappingDefinition>& definitions)
-        -> std::optional<std::pair<const MappingDefinition*, size_t>> {
-        const MappingDefinition* best = nullptr;
-        size_t best_mod_count = 0;
-
-        for (const auto& def : definitions) {
-            if (def.source != normalized) {
-                continue;
-            }
-
-            // Check if all required modifiers are active
-            bool all_mods_active = true;
-            for (const auto& mod : def.required_mods) {
-                if (active_mods.count(mod) == 0) {
-                    all_mods_active = false;
-                    break;
-                }
-            }
-
-            if (!all_mods_active) {
-                continue;
-            }
-
-            // Prefer mappings with more modifiers (more specific).
-            // When counts are equal, keep the first match found (config file order determines priority).
-            if (best == nullptr || def.required_mods.size() > best_mod_count) {
-                best = &def;
-                best_mod_count = def.required_mods.size();
-            }
-        }
+std::optional<MappingEngine::MappingRef> MappingEngine::ResolveRef(
+    const Snapshot& snapshot,
+    KeyId key,
+    AppId app,
+    ModifierMask active_mods) {
+    const Candidate* winner = snapshot->Resolve(app, key, active_mods);
+    if (!winner) {
+        return std::nullopt;
+    }
+    return MappingRef{winner->action, winner->app, winner->required_mask};
+}
+
+std::optional<MappingEngine::MappingRef> MappingEngine::ResolveRef(
+    const Snapshot& snapshot,
+    KeyId key,
+    ActiveApp& active,
+    const AppResolver& resolve_app,
+    ModifierMask active_mods) {
+    AppId app = kFallbackAppId;
+    if (resolve_app && snapshot->HasAppCandidates(key)) {
+        app = active.Id(snapshot, resolve_app());
+    }
+    return ResolveRef(snapshot, key, app, active_mods);
+}
 
-        if (best) {
-            return std::make_pair(best, best_mod_count);
+MappingEngine::ResolvedMapping MappingEngine::Materialize(const Snapshot& snapshot, const MappingRef& ref) {
+    const CompiledTable& table = snapshot.Table();
+    std::vector<std::string> required_mods;
+    for (std::size_t bit = 0; bit < kMaxModifiers; ++bit) {
+        if ((ref.required_mods >> bit) & 1) {
+            required_mods.emplace_back(table.KeyName(table.ModifierKey(bit)));
         }
-        return std::nullopt;
-    };
+    }
+    return ResolvedMapping{std::string(table.Action(ref.action)), std::string(table.AppName(ref.app)),
+                           std::move(required_mods), ref.action};
+}
 
-    // Prefer the most specific mapping across app-specific and "*" fallbacks.
-    const auto by_app = resolved_.find(normalized_app);
-    const auto fallback = resolved_.find("*");
+std::optional<MappingEngine::ResolvedMapping> MappingEngine::ResolveMapping(
+    const Snapshot& snapshot,
+    KeyId key,
+    AppId app,
+    ModifierMask active_mods) {
+    const auto ref = ResolveRef(snapshot, key, app, active_mods);
+    if (!ref) {
+        return std::nullopt;
+    }
+    return Materialize(snapshot, *ref);
+}
 
-    auto best_app = (by_app != resolved_.end()) ? find_best_match(by_app->second) : std::nullopt;
-    auto best_fallback = (fallback != resolved_.end()) ? find_best_match(fallback->second) : std::nullopt;
+std::optional<MappingEngine::ResolvedMapping> MappingEngine::ResolveMapping(
+    const Snapshot& snapshot,
+    KeyId key,
+    ActiveApp& active,
+    const AppResolver& resolve_app,
+    ModifierMask active_mods) {
+    const auto ref = ResolveRef(snapshot, key, active, resolve_app, active_mods);
+    if (!ref) {
+        return std::nullopt;
+    }
+    return Materialize(snapshot, *ref);
+}
 
-    const MappingDefinition* winner = nullptr;
-    std::string winner_app;
+AppId MappingEngine::ActiveApp::Id(const Snapshot& snapshot, const FocusedApp& focused) {
+    if (focused.generation != generation_ || snapshot->Serial() != table_serial_) {
+        id_ = snapshot->FindApp(focused.name);
+        generation_ = focused.generation;
+        table_serial_ = snapshot->Serial();
+        ++lookups_;
+    }
+    return id_;
+}
 
-    if (best_app && (!best_fallback || best_app->second >= best_fallback->second)) {
-        winner = best_app->first;
-        winner_app = normalized_app;
-    } else if (best_fallback) {
-        winner = best_fallback->first;
-        winner_app = "*";
+// Thin wrapper for callers that still speak in strings (tests, tooling).
+std::optional<MappingEngine::ResolvedMapping> MappingEngine::ResolveMapping(
+    const std::string& key,
+    const std::string& app,
+    const std::set<std::string>& active_mods) const {
+    if (key.empty()) {
+        return std::nullopt;
     }
 
-    if (winner) {
-        return ResolvedMapping{winner->target, winner_app, winner->required_mods};
+    const Snapshot snapshot = Acquire();
+    ModifierMask active_mask = 0;
+    for (const auto& mod : active_mods) {
+        active_mask |= snapshot->ModifierBit(snapshot->FindKey(mod));
     }
+    return ResolveMapping(snapshot, snapshot->FindKey(key), app, active_mask);
+}
+
+ModifierMask MappingEngine::ModifierBit(KeyId key) const {
+    return Acquire()->ModifierBit(key);
+}
 
-    return std::nullopt;
+KeyId MappingEngine::ModifierKey(std::size_t index) const {
+    return Acquire()->ModifierKey(index);
 }
 
 // Check if a key is registered as a modifier
+bool MappingEngine::IsModifier(KeyId key) const {
+    return ModifierBit(key) != 0;
+}
+
 bool MappingEngine::IsModifier(const std::string& key) const {
-    return modifiers_.count(NormalizeToken(key)) > 0;
+    const Snapshot snapshot = Acquire();
+    return snapshot->ModifierBit(snapshot->FindKey(key)) != 0;
 }
 
 // Get all registered modifiers
-const std::set<std::string>& MappingEngine::GetModifiers() const {
-    return modifiers_;
+std::set<std::string> MappingEngine::GetModifiers() const {
+    return Acquire()->Modifiers();
 }
 
 // Exposes ordered rows for logging or debugging tooling.
 std::vector<MappingEngine::MappingEntry> MappingEngine::EnumerateMappings() const {
+    const Snapshot snapshot = Acquire();
+    const CompiledTable& table = snapshot.Table();
     std::vector<MappingEntry> ordered;
-    for (const auto& [app, definitions] : resolved_) {
-        for (const auto& def : definitions) {
-            ordered.push_back(MappingEntry{app, def.source, def.target, def.required_mods});
+    for (const auto& row : table.Rows()) {
+        std::vector<std::string> required_mods;
+        for (KeyId mod : table.RowModifiers(row)) {
+            required_mods.emplace_back(table.KeyName(mod));
         }
+        ordered.push_back(MappingEntry{std::string(table.AppName(row.app)), std::string(table.KeyName(row.source)),
+                                       std::string(table.Action(row.action)), std::move(required_mods)});
     }
     std::sort(ordered.begin(), ordered.end(),
               [](const auto& lhs, const auto& rhs) {
@@ -126,35 +200,31 @@ std::vector<MappingEngine::MappingEntry> MappingEngine::EnumerateMappings() cons
     return ordered;
 }
 
-// Normalizes every key in the config into a hash table for O(1) lookups.
+// Adopts the table the loader already compiled (or mapped from its cache).
 void MappingEngine::RebuildTable() {
-    resolved_.clear();
-    modifiers_ = config_.Modifiers();
-    
-    for (const auto& [app, definitions] : config_.Mappings()) {
-        auto& app_mappings = resolved_[NormalizeAppToken(app)];
-        for (const auto& def : definitions) {
-            MappingDefinition normalized_def;
-            normalized_def.source = NormalizeToken(def.source);
-            normalized_def.target = def.target;
-            normalized_def.required_mods = def.required_mods;
-            app_mappings.push_back(std::move(normalized_def));
-        }
+    auto table = config_.Compiled();
+    if (!table) {
+        table = CompiledTable::Build(config_.Mappings(), config_.Modifiers());
     }
+    Publish(std::move(table));
 }
 
-// Normalizes arbitrary key tokens so config entries can be matched case-insensitively.
-std::string MappingEngine::NormalizeToken(const std::string& key) {
-    std::string normalized;
-    normalized.reserve(key.size());
-    for (char ch : key) {
-        if (std::isspace(static_cast<unsigned char>(ch))) {
-            // Trim all whitespace so config entries like "h = left" still work.
-            continue;
-        }
-        normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+// Single atomic swap; the previous owner is handed to the epoch domain instead of being
+// released here, because a hook thread may still be resolving against it.
+void MappingEngine::Publish(std::shared_ptr<const CompiledTable> table) {
+    if (!table) {
+        throw std::invalid_argument("MappingEngine::Publish requires a table");
+    }
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    if (table == owner_) {
+        return; // reload changed nothing the table depends on
+    }
+    table_.store(table.get(), std::memory_order_seq_cst);
+    auto retired = std::make_unique<std::shared_ptr<const CompiledTable>>(std::move(owner_));
+    owner_ = std::move(table);
+    if (*retired) {
+        EpochDomain::Global().Retire(retired.release());
     }
-    return normalized;
 }
 
 std::string MappingEngine::NormalizeAppToken(const std::string& app) {
@@ -1,46 +1,174 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "core/config/config_loader.h"
+#include "core/mapping/compiled_table.h"
+#include "core/mapping/key_symbols.h"
+#include "core/sync/epoch.h"
 
 namespace caps::core {
 
 // Lightweight view over ConfigLoader that exposes fast lookups and cached rows
 // without re-reading the INI file.
+//
+// The compiled table is an immutable snapshot published through one atomic pointer.
+// Reloads build the next table off the hook thread and swap it in; readers never lock,
+// and the old table is freed once no reader can still be using it.
 class MappingEngine {
 public:
     explicit MappingEngine(const ConfigLoader& config);
+    ~MappingEngine();
+
+    MappingEngine(const MappingEngine&) = delete;
+    MappingEngine& operator=(const MappingEngine&) = delete;
+
+    // Pins the current table. Everything read through one Snapshot (KeyIds, modifier bits,
+    // names) comes from the same config, even if a reload publishes meanwhile. Keep it
+    // scoped to a single event: a held snapshot delays freeing replaced tables.
+    class Snapshot {
+    public:
+        [[nodiscard]] const CompiledTable& Table() const { return *table_; }
+        [[nodiscard]] const CompiledTable* operator->() const { return table_; }
+
+    private:
+        friend class MappingEngine;
+        Snapshot(EpochDomain::Guard guard, const CompiledTable* table)
+            : guard_(std::move(guard)), table_(table) {}
+
+        EpochDomain::Guard guard_;
+        const CompiledTable* table_;
+    };
+    [[nodiscard]] Snapshot Acquire() const;
 
     // Initializes internal caches. Split so callers can create the object before
     // the config path is known.
     void Initialize();
     // Rebuilds the lookup table after ConfigLoader reloads.
     void UpdateFromConfig();
+    // Publishes `table` as the live snapshot. Safe to call from any thread while others
+    // resolve; the previous table is retired rather than destroyed in place.
+    void Publish(std::shared_ptr<const CompiledTable> table);
 
     struct ResolvedMapping {
         std::string action;
         std::string app; // normalized app token that provided this mapping ("*" for fallback).
         std::vector<std::string> required_mods; // modifiers that must be held for this mapping
+        std::uint32_t action_index{0}; // CompiledTable::Action()/Program() index in the resolving snapshot
     };
 
-    // Resolves a mapping considering currently active modifiers.
+    // Maps a raw key token onto the id interned at config load. Never allocates.
+    // Returns kInvalidKeyId for keys the config never mentions.
+    [[nodiscard]] KeyId LookupKey(std::string_view key) const;
+    // Normalized spelling for an interned id (for logging/introspection).
+    [[nodiscard]] std::string KeyName(KeyId key) const;
+
+    // Resolves a mapping for an interned key considering currently active modifiers.
+    // active_mods: ModifierBit() of every currently pressed modifier key, OR'd together
+    [[nodiscard]] std::optional<ResolvedMapping> ResolveMapping(
+        KeyId key,
+        const std::string& app,
+        ModifierMask active_mods) const;
+    // Same, against a snapshot the caller already pinned (and took `key` from).
+    [[nodiscard]] static std::optional<ResolvedMapping> ResolveMapping(
+        const Snapshot& snapshot,
+        KeyId key,
+        const std::string& app,
+        ModifierMask active_mods);
+
+    // The focused app as a resolver reports it. `generation` must change whenever `name`
+    // does, so an ActiveApp can tell a focus change from the same app again without
+    // comparing names. `name` only needs to stay valid until the resolver is next called.
+    struct FocusedApp {
+        std::string_view name;
+        std::uint64_t generation{0};
+    };
+    // Produces the focused app on demand (backed by an OS query on most platforms).
+    using AppResolver = std::function<FocusedApp()>;
+
+    // The focused app's dispatch row, looked up once per focus change (or reload) instead
+    // of hashing the app name on every key. Owned by the thread that resolves keys.
+    class ActiveApp {
+    public:
+        // Row of `focused` in the snapshot's table; only a new generation or table looks
+        // the name up again.
+        [[nodiscard]] AppId Id(const Snapshot& snapshot, const FocusedApp& focused);
+        [[nodiscard]] std::uint64_t Lookups() const { return lookups_; }
+
+    private:
+        std::uint64_t generation_{0};
+        std::uint64_t table_serial_{0}; // 0: never resolved
+        AppId id_{kFallbackAppId};
+        std::uint64_t lookups_{0};
+    };
+
+    // A resolution as ids into the resolving snapshot's table; nothing is copied, so
+    // the hook thread can resolve without allocating. Read the strings back through
+    // Action(action), AppName(app) and ModifierKey() for each bit of required_mods.
+    struct MappingRef {
+        std::uint32_t action{0};
+        AppId app{kFallbackAppId};
+        ModifierMask required_mods{0};
+    };
+    [[nodiscard]] static std::optional<MappingRef> ResolveRef(
+        const Snapshot& snapshot,
+        KeyId key,
+        AppId app,
+        ModifierMask active_mods);
+    // Same as the ActiveApp overload of ResolveMapping() below.
+    [[nodiscard]] static std::optional<MappingRef> ResolveRef(
+        const Snapshot& snapshot,
+        KeyId key,
+        ActiveApp& active,
+        const AppResolver& resolve_app,
+        ModifierMask active_mods);
+    // Copies a reference out into owned strings (tests, tooling, logging).
+    [[nodiscard]] static ResolvedMapping Materialize(const Snapshot& snapshot, const MappingRef& ref);
+
+    // Resolves against an app row already looked up in the snapshot's table.
+    [[nodiscard]] static std::optional<ResolvedMapping> ResolveMapping(
+        const Snapshot& snapshot,
+        KeyId key,
+        AppId app,
+        ModifierMask active_mods);
+    // Same, but only asks `resolve_app` for the focused app when the snapshot has
+    // app-specific candidates for `key`; keys mapped only under "*" resolve without a
+    // focus query, and `active` keeps the app's row between focus changes.
+    [[nodiscard]] static std::optional<ResolvedMapping> ResolveMapping(
+        const Snapshot& snapshot,
+        KeyId key,
+        ActiveApp& active,
+        const AppResolver& resolve_app,
+        ModifierMask active_mods);
+
+    // String compatibility wrapper around the KeyId overload.
     // active_mods: set of currently pressed modifier keys (normalized)
     [[nodiscard]] std::optional<ResolvedMapping> ResolveMapping(
         const std::string& key,
         const std::string& app,
         const std::set<std::string>& active_mods = {}) const;
         
+    // Bit assigned to a declared modifier key, or 0 when `key` is not a modifier.
+    [[nodiscard]] ModifierMask ModifierBit(KeyId key) const;
+    // Key that owns bit `index` of a ModifierMask.
+    [[nodiscard]] KeyId ModifierKey(std::size_t index) const;
+
     // Check if a key is registered as a modifier
+    [[nodiscard]] bool IsModifier(KeyId key) const;
     [[nodiscard]] bool IsModifier(const std::string& key) const;
     
     // Get all registered modifiers
-    [[nodiscard]] const std::set<std::string>& GetModifiers() const;
+    [[nodiscard]] std::set<std::string> GetModifiers() const;
     
     struct MappingEntry {
         std::string app;
@@ -53,12 +181,14 @@ public:
 
 private:
     void RebuildTable();
-    static std::string NormalizeToken(const std::string& key);
 
     const ConfigLoader& config_;
-    // app -> list of mapping definitions (ordered by specificity: more modifiers first)
-    std::unordered_map<std::string, std::vector<MappingDefinition>> resolved_;
-    std::set<std::string> modifiers_;
+    // (app, key) dispatch grid with the "*" fallback merged into every app row. This is the
+    // only thing the key path reads; owner_ keeps it alive on the writer side.
+    std::atomic<const CompiledTable*> table_{nullptr};
+    std::mutex publish_mutex_;
+    // Shared with ConfigLoader, which may have mapped it straight from the compiled cache.
+    std::shared_ptr<const CompiledTable> owner_;
 };
 
 } // namespace caps::core
@@ -0,0 +1,162 @@
+#include "replayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+namespace caps::core {
+
+namespace {
+
+// Nearest-rank percentile of an ascending sample.
+std::uint64_t Percentile(const std::vector<std::uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+std::string DescribeKey(const KeyEvent& event) {
+    std::string text = event.key + (event.pressed ? " down" : " up");
+    if (!event.app.empty()) {
+        text += " in " + event.app;
+    }
+    return text;
+}
+
+} // namespace
+
+Replayer::Replayer(LayerController& controller, const std::vector<TraceRecord>& records)
+    : controller_(controller) {
+    steps_.reserve(records.size());
+    for (const TraceRecord& record : records) {
+        Step step;
+        step.kind = record.kind;
+        step.arrival_us = record.arrival_us;
+        step.event = KeyEvent{record.key, record.app, record.pressed, record.time};
+        step.consumed = record.consumed;
+        step.emitted = record.emitted;
+        if (record.kind == TraceRecord::Kind::kKey) {
+            ++key_steps_;
+            if (record.emitted) {
+                step.action = record.action;
+                step.compiled = CompileAction(record.action, [&step](ActionOp op) { step.ops.push_back(op); }) ==
+                                ActionError::kNone;
+                max_ops_ = std::max(max_ops_, step.ops.size());
+            }
+        }
+        steps_.push_back(std::move(step));
+    }
+    // Room for anything a mapping could emit, so the sink never allocates mid-replay.
+    sink_ops_.reserve(std::max<std::size_t>(max_ops_ * 2, 64));
+
+    controller_.SetAppResolver([this] { return MappingEngine::FocusedApp{focus_, focus_generation_}; });
+}
+
+Replayer::~Replayer() {
+    controller_.SetAppResolver({});
+}
+
+ReplayReport Replayer::Run(const ReplayOptions& options) {
+    ReplayReport report;
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(key_steps_ * options.passes);
+
+    const auto sink = [this](const ActionProgram& program, bool) {
+        sink_called_ = true;
+        sink_ops_.assign(program.begin(), program.end());
+    };
+
+    const auto started = std::chrono::steady_clock::now();
+    for (std::size_t pass = 0; pass < options.passes; ++pass) {
+        controller_.OnCapsLockReleased();
+        focus_.clear();
+        ++focus_generation_;
+
+        const auto pass_start = std::chrono::steady_clock::now();
+        const std::uint64_t first_arrival = steps_.empty() ? 0 : steps_.front().arrival_us;
+        for (std::size_t i = 0; i < steps_.size(); ++i) {
+            const Step& step = steps_[i];
+            if (options.real_time) {
+                std::this_thread::sleep_until(pass_start +
+                                              std::chrono::microseconds(step.arrival_us - first_arrival));
+            }
+            switch (step.kind) {
+            case TraceRecord::Kind::kCapsLock:
+                if (step.event.pressed) {
+                    controller_.OnCapsLockPressed();
+                } else {
+                    controller_.OnCapsLockReleased();
+                }
+                ++report.caps_transitions;
+                break;
+            case TraceRecord::Kind::kFocus:
+                focus_ = step.event.app;
+                ++focus_generation_;
+                ++report.focus_changes;
+                break;
+            case TraceRecord::Kind::kKey: {
+                sink_called_ = false;
+                const auto before = std::chrono::steady_clock::now();
+                const bool consumed = controller_.OnKeyEvent(step.event, sink);
+                const auto after = std::chrono::steady_clock::now();
+                latencies.push_back(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+                ++report.keys;
+                Check(step, i, consumed, report);
+                break;
+            }
+            }
+        }
+    }
+    report.elapsed = std::chrono::steady_clock::now() - started;
+
+    std::uint64_t busy_ns = 0;
+    for (const std::uint64_t ns : latencies) {
+        busy_ns += ns;
+    }
+    if (busy_ns > 0) {
+        report.keys_per_second = static_cast<double>(report.keys) * 1e9 / static_cast<double>(busy_ns);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    report.p50_ns = Percentile(latencies, 0.50);
+    report.p90_ns = Percentile(latencies, 0.90);
+    report.p99_ns = Percentile(latencies, 0.99);
+    report.p999_ns = Percentile(latencies, 0.999);
+    report.max_ns = latencies.empty() ? 0 : latencies.back();
+    return report;
+}
+
+void Replayer::Check(const Step& step, std::size_t index, bool consumed, ReplayReport& report) const {
+    const bool same_ops = sink_called_ == step.emitted &&
+                          (!step.emitted || (step.compiled && std::equal(sink_ops_.begin(), sink_ops_.end(),
+                                                                         step.ops.begin(), step.ops.end(),
+                                                                         [](const ActionOp& a, const ActionOp& b) {
+                                                                             return a.key == b.key && a.down == b.down;
+                                                                         })));
+    if (consumed == step.consumed && same_ops) {
+        return;
+    }
+    ++report.mismatches;
+    if (report.first_mismatches.size() >= ReplayReport::kMaxReportedMismatches) {
+        return;
+    }
+    std::ostringstream msg;
+    msg << "record " << index << " (" << DescribeKey(step.event) << "): recorded "
+        << (step.consumed ? "consumed" : "passed through");
+    if (step.emitted) {
+        msg << ", emitted " << step.action;
+    }
+    msg << "; replay " << (consumed ? "consumed" : "passed through");
+    if (sink_called_) {
+        msg << ", emitted " << sink_ops_.size() << " op(s)";
+        if (step.emitted && !same_ops) {
+            msg << " that differ";
+        }
+    }
+    report.first_mismatches.push_back(msg.str());
+}
+
+} // namespace caps::core
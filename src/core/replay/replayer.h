@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/layer/layer_controller.h"
+#include "core/mapping/action_program.h"
+#include "core/replay/trace.h"
+
+namespace caps::core {
+
+struct ReplayOptions {
+    // Sleep until each record's recorded arrival time instead of replaying back to back.
+    bool real_time{false};
+    std::size_t passes{1};
+};
+
+struct ReplayReport {
+    static constexpr std::size_t kMaxReportedMismatches = 10;
+
+    std::size_t keys{0};             // key events replayed, over all passes
+    std::size_t caps_transitions{0};
+    std::size_t focus_changes{0};
+    std::size_t mismatches{0};       // keys routed differently from the recording
+    std::vector<std::string> first_mismatches;
+    std::chrono::nanoseconds elapsed{0}; // wall time of all passes, pacing included
+    double keys_per_second{0};           // keys over the time spent inside OnKeyEvent()
+    // Per-key OnKeyEvent() latency in nanoseconds, as measured around the call.
+    std::uint64_t p50_ns{0};
+    std::uint64_t p90_ns{0};
+    std::uint64_t p99_ns{0};
+    std::uint64_t p999_ns{0};
+    std::uint64_t max_ns{0};
+};
+
+// Feeds a recorded trace back through a LayerController, the way a hook would (the
+// emit stage is the static sink overload of OnKeyEvent()), and checks that every key is
+// consumed and emits the same key ops as when it was recorded. Transitions are applied
+// directly in their recorded order, which already has any reordering in it, and
+// recorded focus changes are reported through the controller's app resolver, which the
+// replayer takes over for its lifetime and clears again when destroyed.
+//
+// The controller must be configured like the recording one: same config, no reorder
+// window, no trace writer.
+class Replayer {
+public:
+    Replayer(LayerController& controller, const std::vector<TraceRecord>& records);
+    ~Replayer();
+
+    // The controller's resolver points at this instance.
+    Replayer(const Replayer&) = delete;
+    Replayer& operator=(const Replayer&) = delete;
+
+    // Each pass starts with CapsLock released and no focused app.
+    ReplayReport Run(const ReplayOptions& options = {});
+
+private:
+    struct Step {
+        TraceRecord::Kind kind{TraceRecord::Kind::kKey};
+        std::uint64_t arrival_us{0};
+        KeyEvent event;
+        bool consumed{false};
+        bool emitted{false};
+        bool compiled{true}; // false: the recorded action does not compile here
+        std::vector<ActionOp> ops;
+        std::string action; // for mismatch reports
+    };
+
+    void Check(const Step& step, std::size_t index, bool consumed, ReplayReport& report) const;
+
+    LayerController& controller_;
+    std::vector<Step> steps_;
+    std::size_t key_steps_{0};
+    std::size_t max_ops_{0};
+    std::string focus_;
+    std::uint64_t focus_generation_{0};
+    // What the sink saw for the key being replayed.
+    bool sink_called_{false};
+    std::vector<ActionOp> sink_ops_;
+};
+
+} // namespace caps::core
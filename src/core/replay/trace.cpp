@@ -0,0 +1,218 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "core/layer/layer_controller.h"
+
+namespace caps::core {
+
+namespace {
+
+constexpr std::uint8_t kKindMask = 0x07;
+constexpr std::uint8_t kPressedBit = 0x08;
+constexpr std::uint8_t kConsumedBit = 0x10;
+constexpr std::uint8_t kEmittedBit = 0x20;
+constexpr std::uint8_t kAppBit = 0x40;
+
+std::uint64_t SteadyMicros() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+// Stamps from different sources need not be monotonic (unstamped keys are 0), so time
+// deltas are signed.
+std::uint64_t ZigZag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t UnZigZag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+class TraceReader {
+public:
+    explicit TraceReader(std::istream& in) : in_(in) {}
+
+    std::vector<TraceRecord> ReadAll() {
+        char magic[sizeof(TraceWriter::kMagic)];
+        in_.read(magic, sizeof(magic));
+        if (in_.gcount() != static_cast<std::streamsize>(sizeof(magic)) ||
+            std::memcmp(magic, TraceWriter::kMagic, sizeof(magic)) != 0) {
+            throw std::runtime_error("Not a CapsUnlocked trace (bad header)");
+        }
+        const std::uint8_t version = Byte();
+        if (version != TraceWriter::kVersion) {
+            throw std::runtime_error("Unsupported trace version " + std::to_string(version));
+        }
+
+        std::vector<TraceRecord> records;
+        std::uint64_t arrival = 0;
+        InputTime time = 0;
+        int next;
+        while ((next = in_.get()) != std::char_traits<char>::eof()) {
+            const auto tag = static_cast<std::uint8_t>(next);
+            TraceRecord record;
+            record.kind = static_cast<TraceRecord::Kind>(tag & kKindMask);
+            record.pressed = (tag & kPressedBit) != 0;
+            record.consumed = (tag & kConsumedBit) != 0;
+            record.emitted = (tag & kEmittedBit) != 0;
+            arrival += Varint();
+            record.arrival_us = arrival;
+            switch (record.kind) {
+            case TraceRecord::Kind::kCapsLock:
+                time += static_cast<InputTime>(UnZigZag(Varint()));
+                record.time = time;
+                break;
+            case TraceRecord::Kind::kKey:
+                time += static_cast<InputTime>(UnZigZag(Varint()));
+                record.time = time;
+                record.key = Ref();
+                if (tag & kAppBit) {
+                    record.app = Ref();
+                }
+                if (record.emitted) {
+                    record.action = Ref();
+                }
+                break;
+            case TraceRecord::Kind::kFocus:
+                record.app = Ref();
+                break;
+            default:
+                throw std::runtime_error("Unknown trace record kind " + std::to_string(tag & kKindMask) +
+                                         " at record " + std::to_string(records.size()));
+            }
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+
+private:
+    std::uint8_t Byte() {
+        const int value = in_.get();
+        if (value == std::char_traits<char>::eof()) {
+            throw std::runtime_error("Trace is truncated");
+        }
+        return static_cast<std::uint8_t>(value);
+    }
+
+    std::uint64_t Varint() {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t byte = Byte();
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Trace has an overlong varint");
+    }
+
+    const std::string& Ref() {
+        const std::uint64_t ref = Varint();
+        if (ref == 0) {
+            const std::uint64_t length = Varint();
+            if (length > TraceWriter::kMaxString) {
+                throw std::runtime_error("Trace defines a " + std::to_string(length) + "-byte string (limit " +
+                                         std::to_string(TraceWriter::kMaxString) + ")");
+            }
+            std::string text(static_cast<std::size_t>(length), '\0');
+            in_.read(text.data(), static_cast<std::streamsize>(text.size()));
+            if (in_.gcount() != static_cast<std::streamsize>(text.size())) {
+                throw std::runtime_error("Trace is truncated");
+            }
+            strings_.push_back(std::move(text));
+            return strings_.back();
+        }
+        if (ref > strings_.size()) {
+            throw std::runtime_error("Trace refers to undefined string " + std::to_string(ref - 1));
+        }
+        return strings_[static_cast<std::size_t>(ref - 1)];
+    }
+
+    std::istream& in_;
+    std::vector<std::string> strings_;
+};
+
+} // namespace
+
+TraceWriter::TraceWriter(std::ostream& out) : out_(out) {
+    out_.write(kMagic, sizeof(kMagic));
+    out_.put(static_cast<char>(kVersion));
+}
+
+void TraceWriter::CapsLock(bool pressed, InputTime time) {
+    Tag(TraceRecord::Kind::kCapsLock, pressed, false, false, false);
+    Time(time);
+}
+
+void TraceWriter::Key(const KeyEvent& event, bool consumed, bool emitted, std::string_view action) {
+    Tag(TraceRecord::Kind::kKey, event.pressed, consumed, emitted, !event.app.empty());
+    Time(event.time);
+    Ref(event.key);
+    if (!event.app.empty()) {
+        Ref(event.app);
+    }
+    if (emitted) {
+        Ref(action);
+    }
+}
+
+void TraceWriter::Focus(std::string_view app) {
+    Tag(TraceRecord::Kind::kFocus, false, false, false, true);
+    Ref(app);
+}
+
+void TraceWriter::Flush() {
+    out_.flush();
+}
+
+void TraceWriter::Tag(TraceRecord::Kind kind, bool pressed, bool consumed, bool emitted, bool has_app) {
+    std::uint8_t tag = static_cast<std::uint8_t>(kind);
+    if (pressed) tag |= kPressedBit;
+    if (consumed) tag |= kConsumedBit;
+    if (emitted) tag |= kEmittedBit;
+    if (has_app) tag |= kAppBit;
+    out_.put(static_cast<char>(tag));
+
+    const std::uint64_t now = SteadyMicros();
+    // The first record's delta is its absolute arrival; replay only uses differences.
+    Varint(now > last_arrival_us_ ? now - last_arrival_us_ : 0);
+    if (now > last_arrival_us_) {
+        last_arrival_us_ = now;
+    }
+    ++records_;
+}
+
+void TraceWriter::Time(InputTime time) {
+    Varint(ZigZag(static_cast<std::int64_t>(time - last_time_)));
+    last_time_ = time;
+}
+
+void TraceWriter::Ref(std::string_view text) {
+    text = text.substr(0, kMaxString);
+    const auto [it, inserted] = strings_.try_emplace(std::string(text), static_cast<std::uint32_t>(strings_.size()));
+    if (!inserted) {
+        Varint(static_cast<std::uint64_t>(it->second) + 1);
+        return;
+    }
+    Varint(0);
+    Varint(text.size());
+    out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void TraceWriter::Varint(std::uint64_t value) {
+    while (value >= 0x80) {
+        out_.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out_.put(static_cast<char>(value));
+}
+
+std::vector<TraceRecord> ReadTrace(std::istream& in) {
+    return TraceReader(in).ReadAll();
+}
+
+} // namespace caps::core
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/layer/reorder_buffer.h"
+
+namespace caps::core {
+
+struct KeyEvent;
+
+// One entry of a recorded layer trace: what LayerController saw, in the order it saw it,
+// and what it decided for each key.
+struct TraceRecord {
+    enum class Kind : std::uint8_t {
+        kCapsLock = 1, // a CapsLock transition was applied
+        kKey = 2,      // a key went through OnKeyEvent()
+        kFocus = 3,    // the app resolver reported a new focused app
+    };
+
+    Kind kind{Kind::kKey};
+    std::uint64_t arrival_us{0}; // steady clock when the controller saw it; paces real-time replay
+    InputTime time{0};           // the hook's hardware stamp (0: none)
+    bool pressed{false};
+    bool consumed{false};        // kKey: OnKeyEvent() returned true
+    bool emitted{false};         // kKey: `action` was emitted
+    std::string key;             // kKey
+    std::string app;             // kKey: KeyEvent::app; kFocus: the focused app's name
+    std::string action;          // kKey: the mapping's normalized target when emitted
+};
+
+// Streams a trace in the compact binary format ReadTrace() reads back:
+//
+//   header  "CAPSTRC" + version byte
+//   record  tag byte: kind in bits 0-2, then pressed (bit 3), consumed (bit 4),
+//           emitted (bit 5), has app (bit 6)
+//           varint arrival delta from the previous record
+//           kCapsLock: zigzag varint time delta
+//           kKey:      zigzag varint time delta, key ref, [app ref], [action ref]
+//           kFocus:    app ref
+//   ref     varint 0 followed by varint length + bytes defines the next string id;
+//           n > 0 refers to string id n - 1
+//
+// Key names, apps and actions repeat constantly in typing, so a record is usually 4-6
+// bytes. Owner thread only, like the LayerController that feeds it. Recording is a
+// diagnostic: interning new strings allocates, unlike the rest of the key path.
+class TraceWriter {
+public:
+    static constexpr char kMagic[7] = {'C', 'A', 'P', 'S', 'T', 'R', 'C'};
+    static constexpr std::uint8_t kVersion = 1;
+    // Longest string a trace may define; key names, apps and targets are far shorter.
+    static constexpr std::size_t kMaxString = 4096;
+
+    // Writes the header. `out` must outlive the writer; nothing is flushed until Flush().
+    explicit TraceWriter(std::ostream& out);
+
+    void CapsLock(bool pressed, InputTime time);
+    void Key(const KeyEvent& event, bool consumed, bool emitted, std::string_view action);
+    void Focus(std::string_view app);
+    void Flush();
+
+    [[nodiscard]] std::uint64_t Records() const { return records_; }
+
+private:
+    void Tag(TraceRecord::Kind kind, bool pressed, bool consumed, bool emitted, bool has_app);
+    void Time(InputTime time);
+    void Ref(std::string_view text);
+    void Varint(std::uint64_t value);
+
+    std::ostream& out_;
+    std::unordered_map<std::string, std::uint32_t> strings_;
+    std::uint64_t last_arrival_us_{0};
+    InputTime last_time_{0};
+    std::uint64_t records_{0};
+};
+
+// Reads a whole trace. Throws std::runtime_error on a bad header, an unknown record or
+// a truncated stream.
+std::vector<TraceRecord> ReadTrace(std::istream& in);
+
+} // namespace caps::core
@@ -0,0 +1,129 @@
+#include "epoch.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace caps::core {
+
+// Per-thread registration with the global domain. The slot is claimed on the first
+// Pin() and handed back when the thread exits.
+struct EpochThreadRecord {
+    EpochDomain::ReaderSlot* slot{nullptr};
+    unsigned depth{0};
+
+    ~EpochThreadRecord() {
+        if (slot) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->claimed.store(false, std::memory_order_release);
+        }
+    }
+};
+
+namespace {
+
+thread_local EpochThreadRecord t_record;
+
+} // namespace
+
+EpochDomain& EpochDomain::Global() {
+    static EpochDomain domain;
+    return domain;
+}
+
+EpochDomain::~EpochDomain() {
+    for (const Retired& entry : retired_) {
+        entry.deleter(entry.object);
+    }
+}
+
+EpochDomain::Guard::Guard(EpochDomain* domain) : domain_(domain) {
+    domain_->Enter();
+}
+
+EpochDomain::Guard::Guard(Guard&& other) noexcept : domain_(other.domain_) {
+    other.domain_ = nullptr;
+}
+
+EpochDomain::Guard::~Guard() {
+    if (domain_) {
+        domain_->Exit();
+    }
+}
+
+EpochDomain::Guard EpochDomain::Pin() {
+    return Guard(this);
+}
+
+EpochDomain::ReaderSlot& EpochDomain::ThreadSlot() {
+    if (!t_record.slot) {
+        for (ReaderSlot& slot : slots_) {
+            bool expected = false;
+            if (slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                t_record.slot = &slot;
+                break;
+            }
+        }
+        if (!t_record.slot) {
+            throw std::runtime_error("Too many threads reading config snapshots");
+        }
+    }
+    return *t_record.slot;
+}
+
+// Publishing the epoch and the writer's scan are both sequentially consistent: either the
+// writer sees this reader as pinned, or the reader's later pointer load sees the swap.
+void EpochDomain::Enter() {
+    if (t_record.depth++ == 0) {
+        ThreadSlot().epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+}
+
+void EpochDomain::Exit() {
+    if (--t_record.depth == 0) {
+        t_record.slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+void EpochDomain::Retire(void* object, void (*deleter)(void*)) {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    retired_.push_back(Retired{object, deleter, epoch_.fetch_add(1, std::memory_order_seq_cst)});
+    ReclaimLocked();
+}
+
+std::size_t EpochDomain::Reclaim() {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    return ReclaimLocked();
+}
+
+// An object retired at epoch r is unreachable once every pinned reader entered after r.
+std::size_t EpochDomain::ReclaimLocked() {
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (const ReaderSlot& slot : slots_) {
+        const std::uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    const auto reachable = std::stable_partition(retired_.begin(), retired_.end(),
+                                                 [&](const Retired& entry) { return entry.epoch >= oldest; });
+    for (auto it = reachable; it != retired_.end(); ++it) {
+        it->deleter(it->object);
+    }
+    retired_.erase(reachable, retired_.end());
+    return retired_.size();
+}
+
+void EpochDomain::Synchronize() {
+    while (Reclaim() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+std::size_t EpochDomain::PendingCount() const {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    return retired_.size();
+}
+
+} // namespace caps::core
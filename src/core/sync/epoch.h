@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace caps::core {
+
+// Epoch-based reclamation for read-mostly data that is swapped by a single atomic
+// pointer store (config snapshots). Readers pin the current epoch for the duration of
+// one short critical section without taking locks; writers retire the objects they
+// unpublished and they are destroyed only once no pinned reader can still see them.
+class EpochDomain {
+public:
+    // Upper bound on threads that pin concurrently (hook, watcher, emitter, tests).
+    static constexpr std::size_t kMaxReaders = 128;
+
+    // Process-wide domain. Reader registration is per thread, so sharing one domain
+    // keeps that bookkeeping trivial.
+    static EpochDomain& Global();
+
+    // RAII reader critical section. Nested guards on one thread are cheap and only the
+    // outermost one publishes the epoch.
+    class Guard {
+    public:
+        Guard(Guard&& other) noexcept;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+        ~Guard();
+
+    private:
+        friend class EpochDomain;
+        explicit Guard(EpochDomain* domain);
+        EpochDomain* domain_;
+    };
+
+    [[nodiscard]] Guard Pin();
+
+    // Schedules `deleter(object)` for after every reader that may have observed `object`
+    // has unpinned. The caller must already have unpublished it.
+    void Retire(void* object, void (*deleter)(void*));
+    template <typename T>
+    void Retire(T* object) {
+        Retire(const_cast<void*>(static_cast<const void*>(object)),
+               [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+
+    // Frees every retired object no pinned reader can reach. Returns how many remain.
+    std::size_t Reclaim();
+    // Blocks until every retired object has been freed. Must not be called while the
+    // calling thread holds a Guard.
+    void Synchronize();
+    [[nodiscard]] std::size_t PendingCount() const;
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+private:
+    friend struct EpochThreadRecord;
+
+    EpochDomain() = default;
+    ~EpochDomain();
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch{0}; // 0 while the thread is outside a guard
+        std::atomic<bool> claimed{false};
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    ReaderSlot& ThreadSlot();
+    void Enter();
+    void Exit();
+    std::size_t ReclaimLocked();
+
+    std::atomic<std::uint64_t> epoch_{1};
+    ReaderSlot slots_[kMaxReaders];
+    mutable std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+};
+
+} // namespace caps::core
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace caps::core {
+
+// Bounded multi-producer/single-consumer queue (Vyukov's sequenced ring). Producers
+// claim a slot with one CAS and publish it with a release store, so pushes never block
+// and a stalled producer only holds back the slots behind its own. Pops are consumer-
+// only and wait-free. The order of successful pushes is the order of pops.
+template <typename T, std::size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr std::size_t kCapacity = Capacity;
+
+    MpscQueue() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread. Returns false when the queue is full.
+    bool TryPush(const T& value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[tail & (Capacity - 1)];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence - tail);
+            if (lag == 0) {
+                // The slot is free for this lap; claim it (a failed CAS reloads `tail`).
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false; // still holds last lap's value: full
+            } else {
+                tail = tail_.load(std::memory_order_relaxed); // another producer got there first
+            }
+        }
+    }
+
+    // Consumer only. Returns false when nothing is ready, including when the next slot
+    // is claimed but its producer has not finished writing it yet.
+    bool TryPop(T& out) {
+        Slot& slot = slots_[head_ & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        out = slot.value;
+        slot.sequence.store(head_ + Capacity, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    struct alignas(kCacheLine) Slot {
+        std::atomic<std::size_t> sequence{0}; // == index: free; index + 1: holds a value
+        T value{};
+    };
+
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; // shared by producers
+    alignas(kCacheLine) std::size_t head_{0};              // consumer only
+    std::array<Slot, Capacity> slots_;
+};
+
+} // namespace caps::core
@@ -0,0 +1,108 @@
+#include "semaphore.h"
+
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <climits>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <ctime>
+#endif
+
+namespace caps::core {
+
+#if defined(_WIN32)
+
+Semaphore::Semaphore() : handle_(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {
+    if (!handle_) {
+        throw std::runtime_error("Could not create a semaphore (error " + std::to_string(GetLastError()) + ")");
+    }
+}
+
+Semaphore::~Semaphore() {
+    CloseHandle(static_cast<HANDLE>(handle_));
+}
+
+void Semaphore::Signal() {
+    ReleaseSemaphore(static_cast<HANDLE>(handle_), 1, nullptr);
+}
+
+bool Semaphore::WaitFor(std::chrono::microseconds timeout) {
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+    return WaitForSingleObject(static_cast<HANDLE>(handle_), static_cast<DWORD>(ms)) == WAIT_OBJECT_0;
+}
+
+#elif defined(__APPLE__)
+
+// Unnamed POSIX semaphores are not implemented on macOS; dispatch semaphores only enter
+// the kernel when a thread actually has to sleep or be woken.
+Semaphore::Semaphore() : handle_(dispatch_semaphore_create(0)) {
+    if (!handle_) {
+        throw std::runtime_error("Could not create a semaphore");
+    }
+}
+
+Semaphore::~Semaphore() {
+    dispatch_release(static_cast<dispatch_semaphore_t>(handle_));
+}
+
+void Semaphore::Signal() {
+    dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(handle_));
+}
+
+bool Semaphore::WaitFor(std::chrono::microseconds timeout) {
+    const dispatch_time_t deadline =
+        dispatch_time(DISPATCH_TIME_NOW, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count());
+    return dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(handle_), deadline) == 0;
+}
+
+#else
+
+// sem_post() is a futex increment that only enters the kernel when someone is waiting.
+Semaphore::Semaphore() {
+    if (sem_init(&semaphore_, 0, 0) != 0) {
+        throw std::runtime_error("Could not create a semaphore");
+    }
+}
+
+Semaphore::~Semaphore() {
+    sem_destroy(&semaphore_);
+}
+
+void Semaphore::Signal() {
+    sem_post(&semaphore_);
+}
+
+bool Semaphore::WaitFor(std::chrono::microseconds timeout) {
+    // sem_timedwait() takes an absolute CLOCK_REALTIME deadline.
+    timespec deadline{};
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    deadline.tv_sec += static_cast<time_t>(ns / 1000000000);
+    deadline.tv_nsec += static_cast<long>(ns % 1000000000);
+    if (deadline.tv_nsec >= 1000000000) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
+    }
+    while (sem_timedwait(&semaphore_, &deadline) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+} // namespace caps::core
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <semaphore.h>
+#endif
+
+namespace caps::core {
+
+// Counting semaphore for waking a worker thread from a latency-sensitive one. Signal()
+// never blocks on a lock the waiter holds, and a signal made before the waiter sleeps
+// is kept in the count rather than lost, so a worker that checks its queue, finds it
+// empty and then waits cannot miss a post that landed in between.
+class Semaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    // Any thread.
+    void Signal();
+    // Takes one signal, waiting up to `timeout` for it. Returns false on timeout.
+    bool WaitFor(std::chrono::microseconds timeout);
+
+private:
+#if defined(_WIN32) || defined(__APPLE__)
+    void* handle_{nullptr}; // HANDLE on Windows, dispatch_semaphore_t on macOS
+#else
+    sem_t semaphore_;
+#endif
+};
+
+} // namespace caps::core
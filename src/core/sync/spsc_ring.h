@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace caps::core {
+
+// Bounded single-producer/single-consumer queue. Both sides are wait-free: a push or pop
+// is a few loads and one release store, and a full or empty ring fails instead of
+// blocking. Exactly one thread may push and exactly one (other) thread may pop.
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr std::size_t kCapacity = Capacity;
+
+    // Producer only. Returns false (and leaves the ring unchanged) when it is full.
+    bool TryPush(const T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity) {
+                return false;
+            }
+        }
+        slots_[tail & (Capacity - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Slots a run of pushes is guaranteed to find free.
+    [[nodiscard]] std::size_t FreeSlots() {
+        head_cache_ = head_.load(std::memory_order_acquire);
+        return Capacity - (tail_.load(std::memory_order_relaxed) - head_cache_);
+    }
+
+    // Consumer only. Returns false when the ring is empty.
+    bool TryPop(T& out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        out = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; a snapshot that may be stale by the time the caller acts on it.
+    [[nodiscard]] bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Each side's index and its cached copy of the other side's sit on their own cache
+    // line, so the producer and consumer only share a line when the cache is refreshed.
+    static constexpr std::size_t kCacheLine = 64;
+
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; // next slot to fill
+    std::size_t head_cache_{0};                             // producer's view of head_
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0};  // next slot to drain
+    std::size_t tail_cache_{0};                             // consumer's view of tail_
+    alignas(kCacheLine) std::array<T, Capacity> slots_{};
+};
+
+} // namespace caps::core
@@ -1,10 +1,15 @@
 // CapsUnlocked macOS executable entry point: wires the core app context to the
 // macOS platform adapter and drives the skeleton lifecycle.
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
 #include <string>
 #include <string_view>
 
 #include "core/app_context.h"
 #include "core/logging.h"
+#include "core/replay/trace.h"
 #include "platform/macos/platform_app.h"
 
 int main(int argc, char* argv[]) {
@@ -12,19 +17,43 @@ int main(int argc, char* argv[]) {
 
     // Default to the adjacent config, mirroring how the Windows build behaves.
     std::string config_path = "capsunlocked.ini";
+    // How long a key may wait for a late IOHID CapsLock report, which is the worst-case
+    // latency reordering adds to a key; a key normally waits only until IOHID reports
+    // it too, well under the window. --reorder-window-us=0 applies transitions in
+    // posting order instead.
+    long reorder_window_us = 4000;
+    // Where to record the layer's input and decisions for caps_replay (empty: off).
+    std::string record_path;
     for (int i = 1; i < argc; ++i) {
         std::string_view arg = argv[i];
         if (arg.rfind("--log-level=", 0) == 0) {
-            const auto level_name = arg.substr(std::string_view("--log-level=").size());
-            if (const auto parsed = caps::core::logging::ParseLevel(level_name)) {
-                caps::core::logging::SetLevel(*parsed);
-                caps::core::logging::Info("[macOS::Main] Log level set to " + std::string(level_name));
+            // Repeatable: --log-level=info --log-level=layer=debug
+            const auto spec = arg.substr(std::string_view("--log-level=").size());
+            if (caps::core::logging::ApplyLevelSpec(spec)) {
+                caps::core::logging::Info("[macOS::Main] Log level set to " + std::string(spec));
             } else {
-                caps::core::logging::Warn("[macOS::Main] Unknown log level '" + std::string(level_name) +
-                                          "' (valid: debug, info, warn, error)");
+                caps::core::logging::Warn("[macOS::Main] Unknown log level '" + std::string(spec) +
+                                          "' (valid: [subsystem=]trace|debug|info|warn|error; subsystems: "
+                                          "layer, output, keyboardhook, focus, config)");
             }
             continue;
         }
+        if (arg.rfind("--reorder-window-us=", 0) == 0) {
+            const std::string value(arg.substr(std::string_view("--reorder-window-us=").size()));
+            char* end = nullptr;
+            const long parsed = std::strtol(value.c_str(), &end, 10);
+            if (!value.empty() && *end == '\0' && parsed >= 0) {
+                reorder_window_us = parsed;
+            } else {
+                caps::core::logging::Warn("[macOS::Main] Invalid reorder window '" + value +
+                                          "' (expected microseconds >= 0)");
+            }
+            continue;
+        }
+        if (arg.rfind("--record=", 0) == 0) {
+            record_path = arg.substr(std::string_view("--record=").size());
+            continue;
+        }
 
         // First non-flag argument is treated as config path override.
         config_path = arg;
@@ -34,12 +63,31 @@ int main(int argc, char* argv[]) {
     // The AppContext owns all core subsystems (config, mapping, controller).
     caps::core::AppContext context;
     context.Initialize(config_path);
+    context.Layer().SetReorderWindow(std::chrono::microseconds(reorder_window_us));
+
+    std::ofstream record_file;
+    std::unique_ptr<caps::core::TraceWriter> trace;
+    if (!record_path.empty()) {
+        record_file.open(record_path, std::ios::binary | std::ios::trunc);
+        if (record_file) {
+            trace = std::make_unique<caps::core::TraceWriter>(record_file);
+            context.Layer().SetTraceWriter(trace.get());
+            caps::core::logging::Info("[macOS::Main] Recording layer trace to " + record_path);
+        } else {
+            caps::core::logging::Warn("[macOS::Main] Could not open " + record_path + " for recording");
+        }
+    }
 
     // PlatformApp wires macOS-specific hooks/output onto the shared core.
     caps::platform::macos::PlatformApp platform_app(context);
     platform_app.Initialize();
     platform_app.Run();       // Blocks inside CFRunLoopRun() until Shutdown() is called.
     platform_app.Shutdown();  // Ensures hooks are torn down before exit.
+    if (trace) {
+        context.Layer().SetTraceWriter(nullptr);
+        trace->Flush();
+        caps::core::logging::Info("[macOS::Main] Recorded " + std::to_string(trace->Records()) + " trace records");
+    }
 
     caps::core::logging::Info("[macOS::Main] Exiting skeleton");
     return 0;
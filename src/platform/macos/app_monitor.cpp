@@ -44,16 +44,20 @@ std::string CFStringToStd(CFStringRef str) {
 
 } // namespace
 
-std::string AppMonitor::CurrentAppName() const {
-    auto psn = FrontmostProcess();
-    pid_t pid = -1;
-    if (psn) {
-        pid = PidFromProcessSerial(*psn);
+core::ProcessId AppMonitor::FocusedProcess() const {
+    const auto psn = FrontmostProcess();
+    if (!psn) {
+        return core::kNoProcess;
     }
+    const pid_t pid = PidFromProcessSerial(*psn);
+    return pid > 0 ? pid : core::kNoProcess;
+}
 
-    if (psn) {
-        CFDictionaryRef info =
-            ProcessInformationCopyDictionary(&*psn, kProcessDictionaryIncludeAllInformationMask);
+std::string AppMonitor::AppName(core::ProcessId process) const {
+    const auto pid = static_cast<pid_t>(process);
+    ProcessSerialNumber psn;
+    if (pid > 0 && GetProcessForPID(pid, &psn) == noErr) {
+        CFDictionaryRef info = ProcessInformationCopyDictionary(&psn, kProcessDictionaryIncludeAllInformationMask);
         if (info) {
             CFStringRef bundle_id =
                 static_cast<CFStringRef>(CFDictionaryGetValue(info, CFSTR("BundleIdentifier")));
@@ -2,14 +2,16 @@
 
 #include <string>
 
+#include "core/focus/focus_cache.h"
+
 namespace caps::platform::macos {
 
-// Small utility that reports the currently focused application name.
-// Preference order: bundle identifier -> .app folder name -> executable name.
-class AppMonitor {
+// Reports the frontmost process and derives app names for core::FocusCache.
+// Name preference order: bundle identifier -> .app folder name -> executable name.
+class AppMonitor : public core::FocusProvider {
 public:
-    std::string CurrentAppName() const;
+    [[nodiscard]] core::ProcessId FocusedProcess() const override;
+    [[nodiscard]] std::string AppName(core::ProcessId pid) const override;
 };
 
 } // namespace caps::platform::macos
-
@@ -4,28 +4,64 @@
 #include <IOKit/hid/IOHIDKeys.h>
 #include <IOKit/hid/IOHIDLib.h>
 #include <IOKit/hid/IOHIDUsageTables.h>
+#include <mach/mach_time.h>
 
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <iomanip>
 #include <sstream>
 #include <string>
 #include <ApplicationServices/ApplicationServices.h>
 
+#include "core/layer/emitter.h"
 #include "core/layer/layer_controller.h"
 #include "core/logging.h"
+#include "core/mapping/key_codes.h"
 #include "platform/macos/event_tag.h"
 
 namespace caps::platform::macos {
 
-KeyboardHook::KeyboardHook(AppMonitor* app_monitor) : app_monitor_(app_monitor) {}
+namespace {
+
+// How long a focused app is trusted before the frontmost pid is checked again.
+constexpr auto kFocusTtl = std::chrono::milliseconds(250);
+
+// Longest the IOHID thread's loop runs before rechecking whether to stop, in seconds.
+constexpr CFTimeInterval kHidLoopSlice = 0.25;
+
+// IOHIDValueGetTimeStamp and CGEventGetTimestamp both report mach_absolute_time ticks
+// (nanoseconds on Intel, 41.67ns ticks on Apple silicon); the core orders in microseconds.
+core::InputTime MachTicksToMicros(std::uint64_t ticks) {
+    static const mach_timebase_info_data_t timebase = [] {
+        mach_timebase_info_data_t info{};
+        mach_timebase_info(&info);
+        return info;
+    }();
+    if (ticks == 0 || timebase.denom == 0) {
+        return 0;
+    }
+    return static_cast<core::InputTime>(static_cast<unsigned __int128>(ticks) * timebase.numer /
+                                        timebase.denom / 1000);
+}
+
+} // namespace
+
+KeyboardHook::KeyboardHook(AppMonitor* app_monitor) : app_monitor_(app_monitor) {
+    if (app_monitor_) {
+        focus_cache_ = std::make_unique<core::FocusCache>(*app_monitor_, kFocusTtl);
+    }
+}
 
 KeyboardHook::~KeyboardHook() {
     StopListening();
 }
 
 // Builds the event tap + IOHID monitor so the platform app can start listening.
-bool KeyboardHook::Install(core::LayerController& controller) {
+bool KeyboardHook::Install(core::LayerController& controller, core::Emitter& emitter) {
     controller_ = &controller;
+    emitter_ = &emitter;
+    controller.SetAppResolver([this] { return ResolveAppForEvent(); });
 
     if (!EnsureAccessibilityPrivileges()) {
         core::logging::Error("[macOS::KeyboardHook] Accessibility permission is required. "
@@ -95,20 +131,12 @@ void KeyboardHook::StartListening() {
     CFRunLoopAddSource(scheduled_run_loop_, run_loop_source_, kCFRunLoopCommonModes);
     CGEventTapEnable(event_tap_, true);
 
-    if (hid_manager_) {
-        // IOHID callbacks run on whichever loop we schedule them on; keep it aligned with CGEvents.
-        IOHIDManagerScheduleWithRunLoop(hid_manager_, scheduled_run_loop_, kCFRunLoopDefaultMode);
-        hid_scheduled_ = true;
-
-        const IOReturn open_result = IOHIDManagerOpen(hid_manager_, kIOHIDOptionsTypeNone);
-        if (open_result != kIOReturnSuccess) {
-            std::ostringstream msg;
-            msg << "[macOS::KeyboardHook] Warning: IOHIDManagerOpen failed (0x" << std::hex << open_result
-                << std::dec << "); CapsLock detection may be inconsistent.";
-            core::logging::Warn(msg.str());
-        } else {
-            hid_open_ = true;
-        }
+    if (hid_manager_ && !hid_thread_.joinable()) {
+        // IOHID callbacks run on whichever loop the manager is scheduled on. Not the tap's:
+        // a key waiting in the reorder window blocks that loop, and with it the very report
+        // it is waiting for.
+        hid_stopping_.store(false);
+        hid_thread_ = std::thread([this] { RunHidLoop(); });
     }
 }
 
@@ -196,7 +224,7 @@ bool KeyboardHook::HandleCapsLock(CGEventRef event) {
     }
 
     const bool pressed = (CGEventGetFlags(event) & kCGEventFlagMaskAlphaShift) != 0;
-    UpdateCapsLockState(pressed);
+    UpdateCapsLockState(pressed, MachTicksToMicros(CGEventGetTimestamp(event)));
     return true;
 }
 
@@ -204,8 +232,25 @@ bool KeyboardHook::HandleCapsLock(CGEventRef event) {
 bool KeyboardHook::HandleKey(CGEventRef event, bool pressed) {
     const CGKeyCode keycode =
         static_cast<CGKeyCode>(CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode));
+    const core::InputTime time = MachTicksToMicros(CGEventGetTimestamp(event));
     if (keycode == kVK_CapsLock) {
-        UpdateCapsLockState(pressed);
+        UpdateCapsLockState(pressed, time);
+        return true;
+    }
+
+    // Apply CapsLock transitions that happened before this key, waiting up to the reorder
+    // window for the IOHID callback if it has not reported that far yet.
+    controller_->DrainInbox(time);
+    // Ordinary typing with CapsLock up stops here, before any token or process-name work.
+    if (!controller_->IsLayerActive()) {
+        return false;
+    }
+    // The layer swallows keys the config never mentions; no need to resolve them. Keys in
+    // the character block may type a letter or digit under the active layout (AZERTY puts
+    // M where QWERTY has ';'), so they always take the full path.
+    const core::KeyCode key = core::FromNative(keycode, core::Platform::kMac);
+    const bool layout_named = key >= core::KeyCode::kA && key <= core::KeyCode::kSlash;
+    if (!layout_named && !controller_->IsKeyOfInterest(key)) {
         return true;
     }
 
@@ -215,69 +260,63 @@ bool KeyboardHook::HandleKey(CGEventRef event, bool pressed) {
         return false;
     }
 
-    // Forward into the shared controller so it can decide whether to emit a mapping.
-    core::KeyEvent key_event{token, ResolveAppForEvent(event), pressed};
-    return controller_->OnKeyEvent(key_event);
+    // Forward into the shared controller so it can decide whether to emit a mapping. The
+    // app is left empty: the controller asks ResolveAppForEvent() only if the key needs it.
+    core::KeyEvent key_event{token, "", pressed, time};
+    // The emit stage is bound statically, so posting to the emitter inlines into this hook.
+    // Output::Emit() plays the whole program on press and ignores releases, so releases are
+    // not queued at all.
+    return controller_->OnKeyEvent(key_event, [this](const core::ActionProgram& program, bool down) {
+        if (down) {
+            emitter_->Post(program, down);
+        }
+    });
 }
 
 std::string KeyboardHook::ExtractKeyToken(CGEventRef event) {
     UniChar buffer[4];
     UniCharCount length = 0;
     CGEventKeyboardGetUnicodeString(event, std::size(buffer), &length, buffer);
-    if (length > 0) {
-        const UniChar code_point = buffer[0];
-        if (code_point < 128) {
-            char ascii = static_cast<char>(code_point);
-            if (std::isalpha(static_cast<unsigned char>(ascii))) {
-                ascii = static_cast<char>(std::toupper(static_cast<unsigned char>(ascii)));
-            }
-            // Printable ASCII keys can be expressed directly (e.g., "H").
-            return std::string(1, ascii);
-        }
+    if (length > 0 && buffer[0] < 128 && std::isalnum(static_cast<int>(buffer[0]))) {
+        // Letters and digits follow the active layout, so "H" is whatever types an h.
+        return std::string(1, static_cast<char>(std::toupper(static_cast<int>(buffer[0]))));
     }
 
-    const auto keycode =
-        static_cast<unsigned int>(CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode));
-
-    std::ostringstream token;
-    // For non-printable keys, expose the raw keycode so configs can reference it via hex.
-    token << "0X" << std::uppercase << std::hex << keycode;
-    return token.str();
+    // Everything else is named from the shared key table ("LEFT", "SEMICOLON"), falling
+    // back to the raw keycode in hex so configs can still reference it.
+    const auto keycode = static_cast<std::uint32_t>(CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode));
+    return std::string(core::NativeKeyToken(keycode, core::Platform::kMac));
 }
 
-// Derives a normalized application identifier using the shared AppMonitor.
-std::string KeyboardHook::ResolveAppForEvent(CGEventRef event) {
-    if (!app_monitor_) {
-        return "";
+// Reports the focused app through the focus cache; the generation lets the controller
+// keep the app's mapping row until focus actually changes.
+core::MappingEngine::FocusedApp KeyboardHook::ResolveAppForEvent() {
+    if (!focus_cache_) {
+        return {};
     }
-    (void)event;
-    return app_monitor_->CurrentAppName();
+    const std::string& name = focus_cache_->Current();
+    return {name, focus_cache_->Generation()};
 }
 
-void KeyboardHook::UpdateCapsLockState(bool pressed) {
-    if (pressed == capslock_down_) {
+// Runs on both the event tap and the IOHID callback, so it only touches atomics and
+// posts to the controller's inbox; the tap thread applies the transition.
+void KeyboardHook::UpdateCapsLockState(bool pressed, core::InputTime time) {
+    if (capslock_down_.exchange(pressed) == pressed) {
         return;
     }
 
     // Transition edge detected; forward state change into the shared controller.
-    capslock_down_ = pressed;
-    std::ostringstream msg;
-    msg << "[macOS::KeyboardHook] CapsLock " << (pressed ? "pressed" : "released");
-    if (app_monitor_) {
-        const std::string focus = app_monitor_->CurrentAppName();
-        if (!focus.empty()) {
-            msg << " (focus=" << focus << ")";
-        }
+    if (pressed && focus_cache_) {
+        // Focus often moves between uses of the layer; recheck it on the next lookup.
+        focus_cache_->Invalidate();
     }
-    core::logging::Debug(msg.str());
+    CAPS_LOG_DEBUG(KeyboardHook, "[macOS::KeyboardHook] CapsLock " << (pressed ? "pressed" : "released"));
     if (!controller_) {
         return;
     }
 
-    if (pressed) {
-        controller_->OnCapsLockPressed();
-    } else {
-        controller_->OnCapsLockReleased();
+    if (!controller_->PostCapsLock(pressed, time)) {
+        core::logging::Warn("[macOS::KeyboardHook] Layer inbox full; CapsLock transition lost");
     }
 }
 
@@ -310,18 +349,42 @@ void KeyboardHook::ShutdownHIDMonitor() {
         return;
     }
 
-    if (hid_scheduled_ && scheduled_run_loop_) {
-        // Remove the HID callbacks from whichever loop they were attached to.
-        IOHIDManagerUnscheduleFromRunLoop(hid_manager_, scheduled_run_loop_, kCFRunLoopDefaultMode);
+    if (hid_thread_.joinable()) {
+        // The thread unschedules and closes the manager itself on the way out; its loop
+        // also wakes on its own within kHidLoopSlice if the stop lands before it runs.
+        hid_stopping_.store(true);
+        if (CFRunLoopRef loop = hid_run_loop_.load()) {
+            CFRunLoopStop(loop);
+        }
+        hid_thread_.join();
     }
-    if (hid_open_) {
-        IOHIDManagerClose(hid_manager_, kIOHIDOptionsTypeNone);
+    if (CFRunLoopRef loop = hid_run_loop_.exchange(nullptr)) {
+        CFRelease(loop);
     }
 
     CFRelease(hid_manager_);
     hid_manager_ = nullptr;
-    hid_scheduled_ = false;
-    hid_open_ = false;
+}
+
+void KeyboardHook::RunHidLoop() {
+    CFRunLoopRef loop = CFRunLoopGetCurrent();
+    IOHIDManagerScheduleWithRunLoop(hid_manager_, loop, kCFRunLoopDefaultMode);
+    const IOReturn open_result = IOHIDManagerOpen(hid_manager_, kIOHIDOptionsTypeNone);
+    if (open_result != kIOReturnSuccess) {
+        std::ostringstream msg;
+        msg << "[macOS::KeyboardHook] Warning: IOHIDManagerOpen failed (0x" << std::hex << open_result
+            << std::dec << "); CapsLock detection may be inconsistent.";
+        core::logging::Warn(msg.str());
+    } else {
+        hid_run_loop_.store(static_cast<CFRunLoopRef>(const_cast<void*>(CFRetain(loop))));
+        while (!hid_stopping_.load()) {
+            if (CFRunLoopRunInMode(kCFRunLoopDefaultMode, kHidLoopSlice, false) == kCFRunLoopRunFinished) {
+                break; // every device went away with its sources
+            }
+        }
+        IOHIDManagerClose(hid_manager_, kIOHIDOptionsTypeNone);
+    }
+    IOHIDManagerUnscheduleFromRunLoop(hid_manager_, loop, kCFRunLoopDefaultMode);
 }
 
 void KeyboardHook::HidInputCallback(void* context, IOReturn result, void*, IOHIDValueRef value) {
@@ -333,7 +396,7 @@ void KeyboardHook::HidInputCallback(void* context, IOReturn result, void*, IOHID
     self->HandleHidValue(result, value);
 }
 
-// Invoked on the IOHID thread whenever any keyboard element changes; we filter for CapsLock.
+// Invoked on the IOHID thread (see RunHidLoop()) whenever any keyboard element changes; we filter for CapsLock.
 void KeyboardHook::HandleHidValue(IOReturn result, IOHIDValueRef value) {
     if (result != kIOReturnSuccess || !value) {
         return;
@@ -344,16 +407,16 @@ void KeyboardHook::HandleHidValue(IOReturn result, IOHIDValueRef value) {
         return;
     }
 
-    if (IOHIDElementGetUsagePage(element) != kHIDPage_KeyboardOrKeypad) {
-        return;
+    // Every keyboard value moves the watermark, not just CapsLock: it tells the tap
+    // thread that no CapsLock transition older than this one is still on its way.
+    const core::InputTime time = MachTicksToMicros(IOHIDValueGetTimeStamp(value));
+    if (IOHIDElementGetUsagePage(element) == kHIDPage_KeyboardOrKeypad &&
+        IOHIDElementGetUsage(element) == kHIDUsage_KeyboardCapsLock) {
+        UpdateCapsLockState(IOHIDValueGetIntegerValue(value) != 0, time);
     }
-
-    if (IOHIDElementGetUsage(element) != kHIDUsage_KeyboardCapsLock) {
-        return;
+    if (controller_ && time != 0) {
+        controller_->AdvanceCapsSource(time);
     }
-
-    const bool pressed = IOHIDValueGetIntegerValue(value) != 0;
-    UpdateCapsLockState(pressed);
 }
 
 CFMutableDictionaryRef KeyboardHook::CreateDeviceMatchingDict(uint32_t usage_page, uint32_t usage) {
@@ -4,11 +4,18 @@
 #include <CoreFoundation/CoreFoundation.h>
 #include <IOKit/hid/IOHIDManager.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
 
+#include "core/focus/focus_cache.h"
+#include "core/layer/reorder_buffer.h"
+#include "core/mapping/mapping_engine.h"
 #include "platform/macos/app_monitor.h"
 
 namespace caps::core {
+class Emitter;
 class LayerController;
 struct KeyEvent;
 } // namespace caps::core
@@ -24,7 +31,7 @@ public:
 
     // Configures the event tap and IOHID monitor. Returns false if the caller needs to
     // prompt the user for accessibility/input monitoring permissions.
-    bool Install(core::LayerController& controller);
+    bool Install(core::LayerController& controller, core::Emitter& emitter);
     // Registers the tap with the current CFRunLoop and begins listening for events.
     void StartListening();
     // Removes the tap, unschedules IOHID callbacks, and releases all CF resources.
@@ -37,28 +44,37 @@ private:
     bool HandleCapsLock(CGEventRef event);
     bool HandleKey(CGEventRef event, bool pressed);
     static std::string ExtractKeyToken(CGEventRef event);
-    std::string ResolveAppForEvent(CGEventRef event);
+    core::MappingEngine::FocusedApp ResolveAppForEvent();
     bool EnsureAccessibilityPrivileges() const;
     bool EnsureInputMonitoringPrivileges() const;
     // Normalizes CapsLock transitions to a single place so both CGEvent and IOHID paths reuse it.
-    void UpdateCapsLockState(bool pressed);
+    // `time` is the transition's hardware timestamp in microseconds (0 if unknown).
+    void UpdateCapsLockState(bool pressed, core::InputTime time);
     // IOHID plumbing that mirrors the standalone capslock-vim experiment.
     bool InitializeHIDMonitor();
     void ShutdownHIDMonitor();
+    // Body of the IOHID thread: schedules the manager on that thread's own run loop, so
+    // CapsLock reports keep arriving while the tap thread waits for them.
+    void RunHidLoop();
     static void HidInputCallback(void* context, IOReturn result, void* sender, IOHIDValueRef value);
     void HandleHidValue(IOReturn result, IOHIDValueRef value);
     // Small helper for building device matching dictionaries (usage page + usage).
     static CFMutableDictionaryRef CreateDeviceMatchingDict(uint32_t usage_page, uint32_t usage);
 
     core::LayerController* controller_{nullptr}; // Not owned; lives in AppContext.
+    core::Emitter* emitter_{nullptr}; // Not owned; lives in PlatformApp.
     CFMachPortRef event_tap_{nullptr};
     CFRunLoopSourceRef run_loop_source_{nullptr};
     IOHIDManagerRef hid_manager_{nullptr};
     CFRunLoopRef scheduled_run_loop_{nullptr};
-    bool hid_scheduled_{false};
-    bool hid_open_{false};
-    bool capslock_down_{false};
+    std::thread hid_thread_;
+    std::atomic<CFRunLoopRef> hid_run_loop_{nullptr}; // retained by the IOHID thread
+    std::atomic<bool> hid_stopping_{false};
+    std::atomic<bool> capslock_down_{false}; // written by the tap and IOHID callbacks
     AppMonitor* app_monitor_{nullptr}; // Not owned.
+    // Memoized focus, read on the run loop thread only. macOS has no focus-change
+    // callback without AppKit, so it expires on a short TTL and on each CapsLock press.
+    std::unique_ptr<core::FocusCache> focus_cache_;
 };
 
 } // namespace caps::platform::macos
@@ -3,13 +3,8 @@
 #include <ApplicationServices/ApplicationServices.h>
 #include <Carbon/Carbon.h>
 
-#include <cctype>
-#include <optional>
+#include <cstdint>
 #include <sstream>
-#include <string>
-#include <unordered_map>
-#include <vector>
-#include <algorithm>
 
 #include "core/logging.h"
 #include "platform/macos/event_tag.h"
@@ -18,128 +13,43 @@ namespace caps::platform::macos {
 
 namespace {
 
-// Lightweight helpers that convert human-friendly config tokens into the CGKeyCode
-// values expected by CGEventCreateKeyboardEvent.
-
-std::string NormalizeToken(const std::string& token) {
-    std::string normalized;
-    normalized.reserve(token.size());
-    for (char ch : token) {
-        if (std::isspace(static_cast<unsigned char>(ch))) {
-            continue;
-        }
-        normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
-    }
-    return normalized;
+CGKeyCode NativeCode(core::KeyCode key) {
+    return core::ToNative(key, core::Platform::kMac);
 }
 
-// Maps ASCII letters to CGKeyCode constants.
-std::optional<CGKeyCode> LookupLetter(char letter) {
-    static const std::unordered_map<char, CGKeyCode> kLetterMap = {
-        {'A', kVK_ANSI_A}, {'B', kVK_ANSI_B}, {'C', kVK_ANSI_C}, {'D', kVK_ANSI_D}, {'E', kVK_ANSI_E},
-        {'F', kVK_ANSI_F}, {'G', kVK_ANSI_G}, {'H', kVK_ANSI_H}, {'I', kVK_ANSI_I}, {'J', kVK_ANSI_J},
-        {'K', kVK_ANSI_K}, {'L', kVK_ANSI_L}, {'M', kVK_ANSI_M}, {'N', kVK_ANSI_N}, {'O', kVK_ANSI_O},
-        {'P', kVK_ANSI_P}, {'Q', kVK_ANSI_Q}, {'R', kVK_ANSI_R}, {'S', kVK_ANSI_S}, {'T', kVK_ANSI_T},
-        {'U', kVK_ANSI_U}, {'V', kVK_ANSI_V}, {'W', kVK_ANSI_W}, {'X', kVK_ANSI_X}, {'Y', kVK_ANSI_Y},
-        {'Z', kVK_ANSI_Z},
-    };
-
-    const auto it = kLetterMap.find(letter);
-    if (it != kLetterMap.end()) {
-        return it->second;
-    }
-    return std::nullopt;
-}
-
-// Handles named keys such as arrow/home/end plus single characters.
-std::optional<CGKeyCode> LookupNamedKey(const std::string& token) {
-    static const std::unordered_map<std::string, CGKeyCode> kNamedKeys = {
-        {"LEFT", kVK_LeftArrow},       {"RIGHT", kVK_RightArrow},   {"UP", kVK_UpArrow},
-        {"DOWN", kVK_DownArrow},       {"ESC", kVK_Escape},         {"ESCAPE", kVK_Escape},
-        {"ENTER", kVK_Return},         {"RETURN", kVK_Return},      {"TAB", kVK_Tab},
-        {"SPACE", kVK_Space},          {"BACKSPACE", kVK_Delete},   {"DELETE", kVK_ForwardDelete},
-        {"HOME", kVK_Home},            {"END", kVK_End},            {"PAGEUP", kVK_PageUp},
-        {"PAGEDOWN", kVK_PageDown},    {"SHIFT", kVK_Shift},        {"LSHIFT", kVK_Shift},
-        {"RSHIFT", kVK_RightShift},    {"CTRL", kVK_Control},       {"CONTROL", kVK_Control},
-        {"ALT", kVK_Option},           {"OPTION", kVK_Option},      {"CMD", kVK_Command},
-        {"COMMAND", kVK_Command},      {"LCMD", kVK_Command},       {"RCMD", kVK_RightCommand},
-        {"META", kVK_Command},         {"SUPER", kVK_Command},      {"F1", kVK_F1},
-        {"F2", kVK_F2},                {"F3", kVK_F3},              {"F4", kVK_F4},
-        {"F5", kVK_F5},                {"F6", kVK_F6},              {"F7", kVK_F7},
-        {"F8", kVK_F8},                {"F9", kVK_F9},              {"F10", kVK_F10},
-        {"F11", kVK_F11},              {"F12", kVK_F12},
-    };
-
-    if (token.size() == 1 && std::isalpha(static_cast<unsigned char>(token.front()))) {
-        return LookupLetter(token.front());
-    }
-
-    const auto it = kNamedKeys.find(token);
-    if (it != kNamedKeys.end()) {
-        return it->second;
-    }
-    return std::nullopt;
-}
-
-// Normalizes any supported token (letters, names, or hex key codes).
-std::optional<CGKeyCode> LookupKeyCode(const std::string& action) {
-    const std::string normalized = NormalizeToken(action);
-
-    if (normalized.rfind("0X", 0) == 0) {
-        std::istringstream stream(normalized.substr(2));
-        unsigned int value = 0;
-        stream >> std::hex >> value;
-        if (!stream.fail()) {
-            return static_cast<CGKeyCode>(value);
-        }
-    }
-
-    return LookupNamedKey(normalized);
-}
-
-struct ActionToken {
-    std::string key;
-    bool hold{false};
+// Modifier keys a sequence can hold, one bit each, so the flags on every event reflect
+// exactly what is down at that point.
+enum HeldModifier : std::uint8_t {
+    kHeldShift = 1u << 0,
+    kHeldRightShift = 1u << 1,
+    kHeldControl = 1u << 2,
+    kHeldRightControl = 1u << 3,
+    kHeldOption = 1u << 4,
+    kHeldRightOption = 1u << 5,
+    kHeldCommand = 1u << 6,
+    kHeldRightCommand = 1u << 7,
 };
 
-std::vector<ActionToken> SplitTokens(const std::string& action) {
-    std::istringstream stream(action);
-    std::vector<ActionToken> tokens;
-    std::string token;
-    while (stream >> token) {
-        ActionToken parsed;
-        parsed.hold = !token.empty() && token.back() == '!';
-        if (parsed.hold) {
-            token.pop_back();
-        }
-        parsed.key = token;
-        tokens.push_back(std::move(parsed));
+std::uint8_t HeldBit(CGKeyCode code) {
+    switch (code) {
+        case kVK_Shift: return kHeldShift;
+        case kVK_RightShift: return kHeldRightShift;
+        case kVK_Control: return kHeldControl;
+        case kVK_RightControl: return kHeldRightControl;
+        case kVK_Option: return kHeldOption;
+        case kVK_RightOption: return kHeldRightOption;
+        case kVK_Command: return kHeldCommand;
+        case kVK_RightCommand: return kHeldRightCommand;
+        default: return 0;
     }
-    return tokens;
 }
 
-CGEventFlags FlagsForHeld(const std::vector<CGKeyCode>& held) {
+CGEventFlags FlagsForHeld(std::uint8_t held) {
     CGEventFlags flags = 0;
-    for (CGKeyCode code : held) {
-        switch (code) {
-            case kVK_Shift:
-            case kVK_RightShift:
-                flags |= kCGEventFlagMaskShift;
-                break;
-            case kVK_Control:
-                flags |= kCGEventFlagMaskControl;
-                break;
-            case kVK_Option:
-                flags |= kCGEventFlagMaskAlternate;
-                break;
-            case kVK_Command:
-            case kVK_RightCommand:
-                flags |= kCGEventFlagMaskCommand;
-                break;
-            default:
-                break;
-        }
-    }
+    if (held & (kHeldShift | kHeldRightShift)) flags |= kCGEventFlagMaskShift;
+    if (held & (kHeldControl | kHeldRightControl)) flags |= kCGEventFlagMaskControl;
+    if (held & (kHeldOption | kHeldRightOption)) flags |= kCGEventFlagMaskAlternate;
+    if (held & (kHeldCommand | kHeldRightCommand)) flags |= kCGEventFlagMaskCommand;
     return flags;
 }
 
@@ -159,70 +69,29 @@ void EmitSingle(CGKeyCode key_code, bool pressed, CGEventFlags flags) {
 
 } // namespace
 
-// Emits a synthetic key press/release corresponding to the mapped action string.
-void Output::Emit(const std::string& action, bool pressed) {
-    const auto tokens = SplitTokens(action);
-    if (tokens.empty()) {
-        core::logging::Warn("[macOS::Output] Empty action");
-        return;
+// Replays the precompiled key ops as CGEvents. Tokens were resolved at config load, so
+// this only indexes the code table.
+void Output::Emit(const core::ActionProgram& program, bool pressed) {
+    if (!pressed) {
+        return; // Macro completes on press; releases are ignored for synthetic sequences.
     }
 
-    std::vector<std::pair<CGKeyCode, bool>> sequence;
-    sequence.reserve(tokens.size() * 2);
-
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const auto& tok = tokens[i];
-        const auto key_code = LookupKeyCode(tok.key);
-        if (!key_code) {
-            core::logging::Warn("[macOS::Output] Unknown action token '" + tok.key + "' in '" + action + "'");
-            return;
+    std::uint8_t held = 0;
+    for (const core::ActionOp& op : program) {
+        const CGKeyCode code = NativeCode(op.key);
+        if (code == core::kNoNativeCode) {
+            continue; // canonical key with no macOS equivalent
         }
+        const bool down = op.down != 0;
+        const std::uint8_t bit = HeldBit(code);
+        held = down ? static_cast<std::uint8_t>(held | bit) : static_cast<std::uint8_t>(held & ~bit);
+        const CGEventFlags flags = FlagsForHeld(held);
 
-        if (tok.hold) {
-            if (i + 1 >= tokens.size()) {
-                core::logging::Warn("[macOS::Output] Hold token '" + tok.key + "!' has no following key in '" + action + "'");
-                return;
-            }
-            const auto next_code = LookupKeyCode(tokens[i + 1].key);
-            if (!next_code) {
-                core::logging::Warn("[macOS::Output] Unknown action token '" + tokens[i + 1].key + "' in '" + action + "'");
-                return;
-            }
-            sequence.emplace_back(*key_code, true);   // hold down
-            sequence.emplace_back(*next_code, true);  // tap target
-            sequence.emplace_back(*next_code, false); // release target
-            sequence.emplace_back(*key_code, false);  // release hold
-            ++i; // skip the next token since it's consumed
-        } else {
-            sequence.emplace_back(*key_code, true);
-            sequence.emplace_back(*key_code, false);
-        }
-    }
+        CAPS_LOG_DEBUG(Output, "[macOS::Output] Emit " << (down ? "down" : "up") << " code=" << code << " flags=0x"
+                                                        << std::hex << flags);
 
-    if (pressed) {
-        CGEventFlags current_flags = 0;
-        std::vector<CGKeyCode> active_mods;
-
-        for (size_t idx = 0; idx < sequence.size(); ++idx) {
-            const auto [code, down] = sequence[idx];
-            if (down && (code == kVK_Shift || code == kVK_RightShift || code == kVK_Control ||
-                         code == kVK_Option || code == kVK_Command || code == kVK_RightCommand)) {
-                active_mods.push_back(code);
-                current_flags = FlagsForHeld(active_mods);
-            } else if (!down && !active_mods.empty()) {
-                active_mods.erase(std::remove(active_mods.begin(), active_mods.end(), code), active_mods.end());
-                current_flags = FlagsForHeld(active_mods);
-            }
-
-            std::ostringstream msg;
-            msg << "[macOS::Output] Emit " << (down ? "down" : "up")
-                << " code=" << code << " flags=0x" << std::hex << current_flags;
-            core::logging::Debug(msg.str());
-
-            EmitSingle(code, down, current_flags);
-        }
+        EmitSingle(code, down, flags);
     }
-    // Macro completes on press; releases are ignored for synthetic sequences.
 }
 
 } // namespace caps::platform::macos
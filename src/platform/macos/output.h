@@ -1,15 +1,16 @@
 #pragma once
 
-#include <string>
+#include "core/mapping/action_program.h"
 
 namespace caps::platform::macos {
 
-// Translates abstract actions (e.g., "LEFT") into CGEvents and posts them.
+// Translates precompiled action programs (e.g., "SHIFT! LEFT") into CGEvents and posts them.
 class Output {
 public:
-    // `action` matches whatever MappingEngine::ResolveMapping returns (names or hex keycodes).
-    // `pressed` mirrors the original key state so we emit down/up pairs.
-    void Emit(const std::string& action, bool pressed);
+    // `program` is the mapping's target as compiled at config load: canonical keys with
+    // holds already expanded. `pressed` mirrors the original key state; the whole
+    // sequence fires on press.
+    void Emit(const core::ActionProgram& program, bool pressed);
 };
 
 } // namespace caps::platform::macos
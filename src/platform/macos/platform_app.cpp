@@ -18,19 +18,21 @@ PlatformApp::PlatformApp(core::AppContext& context)
     : context_(context),
       app_monitor_(std::make_unique<AppMonitor>()),
       keyboard_hook_(std::make_unique<KeyboardHook>(app_monitor_.get())),
-      output_(std::make_unique<Output>()) {}
+      output_(std::make_unique<Output>()),
+      emitter_(std::make_unique<core::Emitter>(
+          [this](const core::ActionProgram& program, bool pressed) { output_->Emit(program, pressed); })) {}
 
 // Installs hooks and wires callbacks. Throws if the user has not granted permissions.
 void PlatformApp::Initialize() {
     core::logging::Info("[macOS::PlatformApp] Initializing platform app");
-    if (!keyboard_hook_->Install(context_.Layer())) {
+    if (!keyboard_hook_->Install(context_.Layer(), *emitter_)) {
         throw std::runtime_error(
             "CapsUnlocked needs Accessibility/Input Monitoring permission. Enable it in "
             "System Settings → Privacy & Security → Input Monitoring and restart the app.");
     }
-    // When the layer resolves a mapping, immediately emit the CGEvent via Output.
-    context_.Layer().SetActionCallback(
-        [this](const std::string& action, bool pressed) { output_->Emit(action, pressed); });
+    // The tap only queues resolved mappings; the emitter thread posts the CGEvents, so a
+    // slow CGEventPost cannot push the tap past its timeout.
+    emitter_->Start();
 }
 
 // Starts listening for events and blocks inside CFRunLoopRun() until Shutdown() is called.
@@ -51,6 +53,7 @@ void PlatformApp::Shutdown() {
     }
     // StopListening tears down the event tap and IOHID manager before exiting.
     keyboard_hook_->StopListening();
+    emitter_->Stop();
 }
 
 } // namespace caps::platform::macos
@@ -5,6 +5,7 @@
 #include <memory>
 #include <string>
 
+#include "core/layer/emitter.h"
 #include "platform/macos/app_monitor.h"
 #include "platform/macos/keyboard_hook.h"
 #include "platform/macos/output.h"
@@ -29,6 +30,7 @@ private:
     std::unique_ptr<AppMonitor> app_monitor_;     // Reports frontmost app.
     std::unique_ptr<KeyboardHook> keyboard_hook_; // Captures hardware events.
     std::unique_ptr<Output> output_;              // Emits mapped CGEvents.
+    std::unique_ptr<core::Emitter> emitter_;      // Runs output_ off the event tap thread.
     CFRunLoopRef run_loop_{nullptr};
 };
 
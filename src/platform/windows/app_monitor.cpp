@@ -27,13 +27,7 @@ std::string WideToUtf8(const std::wstring& wide) {
     return result;
 }
 
-std::string GetProcessName(HWND hwnd) {
-    DWORD process_id = 0;
-    GetWindowThreadProcessId(hwnd, &process_id);
-    if (process_id == 0) {
-        return "";
-    }
-
+std::string GetProcessName(DWORD process_id) {
     HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, process_id);
     if (!process) {
         return "";
@@ -65,21 +59,27 @@ std::string GetProcessName(HWND hwnd) {
 
 } // namespace
 
-std::string AppMonitor::CurrentAppName() const {
+core::ProcessId AppMonitor::FocusedProcess() const {
     HWND foreground = GetForegroundWindow();
     if (!foreground) {
-        return "";
+        return core::kNoProcess;
     }
+    DWORD process_id = 0;
+    GetWindowThreadProcessId(foreground, &process_id);
+    return process_id == 0 ? core::kNoProcess : static_cast<core::ProcessId>(process_id);
+}
 
+std::string AppMonitor::AppName(core::ProcessId pid) const {
     // Try to get the process name
-    std::string process_name = GetProcessName(foreground);
+    std::string process_name = GetProcessName(static_cast<DWORD>(pid));
     if (!process_name.empty()) {
         return process_name;
     }
 
-    // Fallback to window title if process name unavailable
+    // Fallback to window title if process name unavailable (e.g. elevated processes)
+    HWND foreground = GetForegroundWindow();
     wchar_t title[256] = {};
-    if (GetWindowTextW(foreground, title, 256) > 0) {
+    if (foreground && GetWindowTextW(foreground, title, 256) > 0) {
         return WideToUtf8(std::wstring(title));
     }
 
@@ -2,13 +2,16 @@
 
 #include <string>
 
+#include "core/focus/focus_cache.h"
+
 namespace caps::platform::windows {
 
-// Utility that reports the currently focused application name on Windows.
-// Uses GetForegroundWindow and GetWindowTextW to identify the active window.
-class AppMonitor {
+// Reports the foreground process and derives app names for core::FocusCache: the
+// executable name, or the foreground window's title when the process cannot be opened.
+class AppMonitor : public core::FocusProvider {
 public:
-    std::string CurrentAppName() const;
+    [[nodiscard]] core::ProcessId FocusedProcess() const override;
+    [[nodiscard]] std::string AppName(core::ProcessId pid) const override;
 };
 
 } // namespace caps::platform::windows
@@ -4,22 +4,34 @@
 // key events into the shared layer controller.
 
 #include <cctype>
+#include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <string>
 
+#include "core/layer/emitter.h"
 #include "core/layer/layer_controller.h"
 #include "core/logging.h"
+#include "core/mapping/key_codes.h"
 
 namespace caps::platform::windows {
 
+namespace {
+
+// Only used if the foreground event hook cannot be installed.
+constexpr auto kFocusFallbackTtl = std::chrono::milliseconds(250);
+
+} // namespace
+
 // Static instance pointer for the global hook callback
 KeyboardHook* KeyboardHook::instance_ = nullptr;
 
 KeyboardHook::KeyboardHook(AppMonitor* app_monitor) : app_monitor_(app_monitor) {}
 
-void KeyboardHook::Install(core::LayerController& controller) {
+void KeyboardHook::Install(core::LayerController& controller, core::Emitter& emitter) {
     controller_ = &controller;
+    emitter_ = &emitter;
+    controller.SetAppResolver([this] { return ResolveAppForEvent(); });
     instance_ = this;
     core::logging::Info("[Windows::KeyboardHook] Installing low-level keyboard hook");
     
@@ -34,6 +46,19 @@ void KeyboardHook::Install(core::LayerController& controller) {
     } else {
         core::logging::Info("[Windows::KeyboardHook] Keyboard hook installed successfully");
     }
+
+    if (app_monitor_) {
+        // Foreground changes arrive on this thread's message loop, like the keyboard hook,
+        // so the cached focus is only ever touched from one thread.
+        focus_hook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                      ForegroundChangedProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        if (!focus_hook_) {
+            core::logging::Warn("[Windows::KeyboardHook] Foreground event hook unavailable; "
+                                "rechecking the focused app on a timer");
+        }
+        focus_cache_ = std::make_unique<core::FocusCache>(
+            *app_monitor_, focus_hook_ ? core::FocusCache::Clock::duration::zero() : kFocusFallbackTtl);
+    }
 }
 
 void KeyboardHook::StartListening() {
@@ -48,6 +73,10 @@ void KeyboardHook::StopListening() {
         UnhookWindowsHookEx(hook_handle_);
         hook_handle_ = nullptr;
     }
+    if (focus_hook_) {
+        UnhookWinEvent(focus_hook_);
+        focus_hook_ = nullptr;
+    }
     instance_ = nullptr;
 }
 
@@ -59,6 +88,13 @@ LRESULT CALLBACK KeyboardHook::LowLevelKeyboardProc(int nCode, WPARAM wParam, LP
     return CallNextHookEx(nullptr, nCode, wParam, lParam);
 }
 
+// Foreground window changed: the next app lookup re-reads the focused process
+void CALLBACK KeyboardHook::ForegroundChangedProc(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD) {
+    if (instance_ && instance_->focus_cache_) {
+        instance_->focus_cache_->Invalidate();
+    }
+}
+
 // Process keyboard events and forward to the layer controller
 LRESULT KeyboardHook::HandleKeyboardEvent(int nCode, WPARAM wParam, LPARAM lParam) {
     // Only process if nCode is HC_ACTION
@@ -95,7 +131,10 @@ LRESULT KeyboardHook::HandleKeyboardEvent(int nCode, WPARAM wParam, LPARAM lPara
     }
 
     // Handle other keys
-    if (HandleKey(vkCode, scanCode, pressed)) {
+    // KBDLLHOOKSTRUCT::time is GetTickCount() milliseconds. CapsLock and keys arrive through
+    // this one hook in order, so no reorder window is set here; the stamp only rides along.
+    const core::InputTime time = static_cast<core::InputTime>(kbd->time) * 1000;
+    if (HandleKey(vkCode, scanCode, pressed, time)) {
         return 1; // Swallow the event
     }
 
@@ -114,46 +153,54 @@ bool KeyboardHook::HandleCapsLock(DWORD vkCode, bool pressed) {
 }
 
 // Forward key events to the layer controller
-bool KeyboardHook::HandleKey(DWORD vkCode, DWORD scanCode, bool pressed) {
+bool KeyboardHook::HandleKey(DWORD vkCode, DWORD scanCode, bool pressed, core::InputTime time) {
     if (!controller_) {
         return false;
     }
 
+    // Ordinary typing with CapsLock up stops here, before any token or process-name work.
+    if (!controller_->IsLayerActive()) {
+        return false;
+    }
+    // The layer swallows keys the config never mentions; no need to resolve them.
+    if (!controller_->IsKeyOfInterest(core::FromNative(vkCode, core::Platform::kWindows))) {
+        return true;
+    }
+
     const std::string token = ExtractKeyToken(vkCode, scanCode);
     if (token.empty()) {
         // Failed to derive a token; let the system handle it
         return false;
     }
 
-    // Forward into the shared controller with app context
-    core::KeyEvent key_event{token, ResolveAppForEvent(), pressed};
-    return controller_->OnKeyEvent(key_event);
+    // Forward into the shared controller; it asks ResolveAppForEvent() for the app only
+    // when the key has app-specific mappings
+    core::KeyEvent key_event{token, "", pressed, time};
+    // The emit stage is bound statically, so posting to the emitter inlines into this hook.
+    // Output::Emit() plays the whole program on press and ignores releases, so releases are
+    // not queued at all.
+    return controller_->OnKeyEvent(key_event, [this](const core::ActionProgram& program, bool down) {
+        if (down) {
+            emitter_->Post(program, down);
+        }
+    });
 }
 
-// Extract a normalized key token from virtual key code
+// Extract a normalized key token from virtual key code: the shared key table's name
+// ("A", "7", "LEFT"), or the code in hex for keys the table does not name
 std::string KeyboardHook::ExtractKeyToken(DWORD vkCode, DWORD scanCode) {
-    // For letter keys (A-Z), return uppercase letter
-    if (vkCode >= 'A' && vkCode <= 'Z') {
-        return std::string(1, static_cast<char>(vkCode));
-    }
-
-    // For digit keys (0-9), return the digit
-    if (vkCode >= '0' && vkCode <= '9') {
-        return std::string(1, static_cast<char>(vkCode));
-    }
-
-    // For non-printable keys, return hex code
-    std::ostringstream token;
-    token << "0X" << std::uppercase << std::hex << vkCode;
-    return token.str();
+    (void)scanCode;
+    return std::string(core::NativeKeyToken(vkCode, core::Platform::kWindows));
 }
 
-// Derives a normalized application identifier using the shared AppMonitor
-std::string KeyboardHook::ResolveAppForEvent() {
-    if (!app_monitor_) {
-        return "";
+// Reports the focused app through the focus cache; the generation lets the controller
+// keep the app's mapping row until focus actually changes.
+core::MappingEngine::FocusedApp KeyboardHook::ResolveAppForEvent() {
+    if (!focus_cache_) {
+        return {};
     }
-    return app_monitor_->CurrentAppName();
+    const std::string& name = focus_cache_->Current();
+    return {name, focus_cache_->Generation()};
 }
 
 // Update CapsLock state and notify the controller
@@ -164,15 +211,17 @@ void KeyboardHook::UpdateCapsLockState(bool pressed) {
 
     // Transition edge detected
     capslock_down_ = pressed;
-    std::ostringstream msg;
-    msg << "[Windows::KeyboardHook] CapsLock " << (pressed ? "pressed" : "released");
-    if (app_monitor_) {
-        const std::string focus = app_monitor_->CurrentAppName();
-        if (!focus.empty()) {
-            msg << " (focus=" << focus << ")";
+    if (CAPS_LOG_ENABLED(Debug, KeyboardHook)) {
+        std::ostringstream msg;
+        msg << "[Windows::KeyboardHook] CapsLock " << (pressed ? "pressed" : "released");
+        if (focus_cache_) {
+            const std::string& focus = focus_cache_->Current();
+            if (!focus.empty()) {
+                msg << " (focus=" << focus << ")";
+            }
         }
+        core::logging::Log(core::logging::Level::Debug, core::logging::Subsystem::KeyboardHook, msg.str());
     }
-    core::logging::Debug(msg.str());
 
     if (!controller_) {
         return;
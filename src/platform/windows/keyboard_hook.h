@@ -1,11 +1,16 @@
 #pragma once
 
 #include <windows.h>
+#include <memory>
 #include <string>
 
+#include "core/focus/focus_cache.h"
+#include "core/layer/reorder_buffer.h"
+#include "core/mapping/mapping_engine.h"
 #include "platform/windows/app_monitor.h"
 
 namespace caps::core {
+class Emitter;
 class LayerController;
 struct KeyEvent;
 }
@@ -17,22 +22,27 @@ class KeyboardHook {
 public:
     explicit KeyboardHook(AppMonitor* app_monitor);
     
-    void Install(core::LayerController& controller);
+    void Install(core::LayerController& controller, core::Emitter& emitter);
     void StartListening();
     void StopListening();
 
 private:
     static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
+    static void CALLBACK ForegroundChangedProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG id_object,
+                                               LONG id_child, DWORD thread_id, DWORD time);
     LRESULT HandleKeyboardEvent(int nCode, WPARAM wParam, LPARAM lParam);
     bool HandleCapsLock(DWORD vkCode, bool pressed);
-    bool HandleKey(DWORD vkCode, DWORD scanCode, bool pressed);
+    bool HandleKey(DWORD vkCode, DWORD scanCode, bool pressed, core::InputTime time);
     static std::string ExtractKeyToken(DWORD vkCode, DWORD scanCode);
-    std::string ResolveAppForEvent();
+    core::MappingEngine::FocusedApp ResolveAppForEvent();
     void UpdateCapsLockState(bool pressed);
 
     core::LayerController* controller_{nullptr};
+    core::Emitter* emitter_{nullptr}; // Not owned; lives in PlatformApp.
     AppMonitor* app_monitor_{nullptr};
     HHOOK hook_handle_{nullptr};
+    HWINEVENTHOOK focus_hook_{nullptr}; // EVENT_SYSTEM_FOREGROUND, invalidates focus_cache_
+    std::unique_ptr<core::FocusCache> focus_cache_;
     bool capslock_down_{false};
     
     static KeyboardHook* instance_;
@@ -20,15 +20,18 @@ PlatformApp::PlatformApp(core::AppContext& context)
     : context_(context),
       app_monitor_(std::make_unique<AppMonitor>()),
       keyboard_hook_(std::make_unique<KeyboardHook>(app_monitor_.get())),
-      output_(std::make_unique<Output>()) {}
+      output_(std::make_unique<Output>()),
+      emitter_(std::make_unique<core::Emitter>(
+          [this](const core::ActionProgram& program, bool pressed) { output_->Emit(program, pressed); })) {}
 
 // Establishes hooks and wiring so mapped actions get emitted via Output.
 void PlatformApp::Initialize() {
     core::logging::Info("[Windows::PlatformApp] Initializing platform app");
     main_thread_id_ = GetCurrentThreadId();
-    keyboard_hook_->Install(context_.Layer());
-    context_.Layer().SetActionCallback(
-        [this](const std::string& action, bool pressed) { output_->Emit(action, pressed); });
+    keyboard_hook_->Install(context_.Layer(), *emitter_);
+    // The hook only queues resolved mappings; SendInput runs on the emitter thread so the
+    // hook stays well inside LowLevelHooksTimeout.
+    emitter_->Start();
 }
 
 // Runs the Windows message loop to process keyboard hook events.
@@ -59,6 +62,7 @@ void PlatformApp::Run() {
 void PlatformApp::Shutdown() {
     core::logging::Info("[Windows::PlatformApp] Shutting down platform app");
     keyboard_hook_->StopListening();
+    emitter_->Stop();
     
     // Post WM_QUIT to exit the message loop if it's running
     if (main_thread_id_ != 0) {
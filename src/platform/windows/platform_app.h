@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 
+#include "core/layer/emitter.h"
 #include "platform/windows/app_monitor.h"
 #include "platform/windows/keyboard_hook.h"
 #include "platform/windows/output.h"
@@ -28,6 +29,7 @@ private:
     std::unique_ptr<AppMonitor> app_monitor_;
     std::unique_ptr<KeyboardHook> keyboard_hook_;
     std::unique_ptr<Output> output_;
+    std::unique_ptr<core::Emitter> emitter_; // runs output_ off the hook thread
     DWORD main_thread_id_{0};
 };
 
@@ -0,0 +1,95 @@
+// caps_replay: feeds a trace recorded with `CapsUnlocked --record=<file>` back through the
+// core (no OS hooks), checks every key against the recording and reports latency.
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "core/app_context.h"
+#include "core/logging.h"
+#include "core/replay/replayer.h"
+#include "core/replay/trace.h"
+
+namespace {
+
+void PrintUsage() {
+    std::cerr << "usage: caps_replay [--config=<ini>] [--passes=N] [--real-time] [--log-level=<spec>] <trace>\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string config_path = "capsunlocked.ini";
+    std::string trace_path;
+    caps::core::ReplayOptions options;
+    // Per-key debug logging would dominate the latencies; --log-level brings it back.
+    caps::core::logging::SetLevel(caps::core::logging::Level::Warning);
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg.rfind("--config=", 0) == 0) {
+            config_path = arg.substr(std::string_view("--config=").size());
+        } else if (arg.rfind("--passes=", 0) == 0) {
+            const std::string value(arg.substr(std::string_view("--passes=").size()));
+            char* end = nullptr;
+            const long parsed = std::strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || parsed < 1) {
+                std::cerr << "Invalid pass count '" << value << "' (expected N >= 1)\n";
+                return 2;
+            }
+            options.passes = static_cast<std::size_t>(parsed);
+        } else if (arg == "--real-time") {
+            options.real_time = true;
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            const auto spec = arg.substr(std::string_view("--log-level=").size());
+            if (!caps::core::logging::ApplyLevelSpec(spec)) {
+                std::cerr << "Unknown log level '" << spec << "'\n";
+                return 2;
+            }
+        } else if (arg.rfind("--", 0) == 0 || !trace_path.empty()) {
+            PrintUsage();
+            return 2;
+        } else {
+            trace_path = arg;
+        }
+    }
+    if (trace_path.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<caps::core::TraceRecord> records;
+    try {
+        std::ifstream in(trace_path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Could not open " << trace_path << "\n";
+            return 2;
+        }
+        records = caps::core::ReadTrace(in);
+    } catch (const std::exception& ex) {
+        std::cerr << trace_path << ": " << ex.what() << "\n";
+        return 2;
+    }
+
+    caps::core::AppContext context;
+    context.Initialize(config_path);
+    caps::core::Replayer replayer(context.Layer(), records);
+    const caps::core::ReplayReport report = replayer.Run(options);
+    caps::core::logging::Flush();
+
+    const double elapsed_ms = static_cast<double>(report.elapsed.count()) / 1e6;
+    std::cout << trace_path << ": " << records.size() << " records, " << options.passes << " pass(es)\n"
+              << "  keys " << report.keys << ", CapsLock transitions " << report.caps_transitions
+              << ", focus changes " << report.focus_changes << "\n"
+              << std::fixed << std::setprecision(1) << "  elapsed " << elapsed_ms << " ms, throughput "
+              << std::setprecision(0) << report.keys_per_second << " keys/s inside OnKeyEvent\n"
+              << "  latency ns: p50 " << report.p50_ns << ", p90 " << report.p90_ns << ", p99 " << report.p99_ns
+              << ", p99.9 " << report.p999_ns << ", max " << report.max_ns << "\n"
+              << "  mismatches " << report.mismatches << "\n";
+    for (const std::string& mismatch : report.first_mismatches) {
+        std::cout << "    " << mismatch << "\n";
+    }
+    return report.mismatches == 0 ? 0 : 1;
+}
@@ -1,5 +1,7 @@
 #ifdef _WIN32
 
+#include <fstream>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -8,12 +10,15 @@
 
 #include "core/app_context.h"
 #include "core/logging.h"
+#include "core/replay/trace.h"
 #include "platform/windows/platform_app.h"
 
 int wmain(int argc, wchar_t* argv[]) {
     caps::core::logging::Info("[Windows::Main] Bootstrapping CapsUnlocked skeleton");
 
     std::string config_path = "capsunlocked.ini";
+    // Where to record the layer's input and decisions for caps_replay (empty: off).
+    std::string record_path;
     for (int i = 1; i < argc; ++i) {
         if (!argv[i]) {
             continue;
@@ -24,16 +29,21 @@ int wmain(int argc, wchar_t* argv[]) {
         std::string_view view(arg);
 
         if (view.rfind("--log-level=", 0) == 0) {
-            const auto level_name = view.substr(std::string_view("--log-level=").size());
-            if (const auto parsed = caps::core::logging::ParseLevel(level_name)) {
-                caps::core::logging::SetLevel(*parsed);
-                caps::core::logging::Info("[Windows::Main] Log level set to " + std::string(level_name));
+            // Repeatable: --log-level=info --log-level=layer=debug
+            const auto spec = view.substr(std::string_view("--log-level=").size());
+            if (caps::core::logging::ApplyLevelSpec(spec)) {
+                caps::core::logging::Info("[Windows::Main] Log level set to " + std::string(spec));
             } else {
-                caps::core::logging::Warn("[Windows::Main] Unknown log level '" + std::string(level_name) +
-                                          "' (valid: debug, info, warn, error)");
+                caps::core::logging::Warn("[Windows::Main] Unknown log level '" + std::string(spec) +
+                                          "' (valid: [subsystem=]trace|debug|info|warn|error; subsystems: "
+                                          "layer, output, keyboardhook, focus, config)");
             }
             continue;
         }
+        if (view.rfind("--record=", 0) == 0) {
+            record_path = std::string(view.substr(std::string_view("--record=").size()));
+            continue;
+        }
 
         // First non-flag argument is treated as config path override.
         config_path = arg;
@@ -43,10 +53,28 @@ int wmain(int argc, wchar_t* argv[]) {
     caps::core::AppContext context;
     context.Initialize(config_path);
 
+    std::ofstream record_file;
+    std::unique_ptr<caps::core::TraceWriter> trace;
+    if (!record_path.empty()) {
+        record_file.open(record_path, std::ios::binary | std::ios::trunc);
+        if (record_file) {
+            trace = std::make_unique<caps::core::TraceWriter>(record_file);
+            context.Layer().SetTraceWriter(trace.get());
+            caps::core::logging::Info("[Windows::Main] Recording layer trace to " + record_path);
+        } else {
+            caps::core::logging::Warn("[Windows::Main] Could not open " + record_path + " for recording");
+        }
+    }
+
     caps::platform::windows::PlatformApp platform_app(context);
     platform_app.Initialize();
     platform_app.Run();
     platform_app.Shutdown();
+    if (trace) {
+        context.Layer().SetTraceWriter(nullptr);
+        trace->Flush();
+        caps::core::logging::Info("[Windows::Main] Recorded " + std::to_string(trace->Records()) + " trace records");
+    }
 
     caps::core::logging::Info("[Windows::Main] Exiting skeleton");
     return 0;
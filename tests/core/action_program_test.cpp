@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/mapping/action_program.h"
+#include "core/mapping/compiled_table.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+using caps::core::ActionError;
+using caps::core::ActionOp;
+using caps::core::ActionProgram;
+using caps::core::CompiledTable;
+using caps::core::ConfigLoader;
+using caps::core::KeyCode;
+using caps::core::MappingDefinition;
+
+namespace {
+
+// "+KEY"/"-KEY" per op, with native codes as hex, so expectations read like the target.
+std::string Describe(const std::vector<ActionOp>& ops) {
+    std::string out;
+    for (const ActionOp& op : ops) {
+        if (!out.empty()) out += ' ';
+        out += op.down ? '+' : '-';
+        char code[12];
+        std::snprintf(code, sizeof(code), "%s%X", caps::core::IsNativeKey(op.key) ? "n" : "",
+                      caps::core::IsNativeKey(op.key) ? caps::core::NativeKeyCode(op.key)
+                                                      : static_cast<unsigned>(op.key));
+        out += code;
+    }
+    return out;
+}
+
+std::vector<ActionOp> Compile(std::string_view target, ActionError expected = ActionError::kNone) {
+    std::vector<ActionOp> ops;
+    EXPECT_EQ(expected, caps::core::CompileAction(target, [&](ActionOp op) { ops.push_back(op); })) << target;
+    return ops;
+}
+
+std::vector<ActionOp> Ops(const ActionProgram& program) {
+    return std::vector<ActionOp>(program.begin(), program.end());
+}
+
+} // namespace
+
+TEST(ActionProgramTest, ExpandsTapsAndHolds) {
+    EXPECT_EQ("+50 -50", Describe(Compile("LEFT")));
+    EXPECT_EQ("+50 -50 +4F -4F", Describe(Compile("LEFT RIGHT")));
+    EXPECT_EQ("+E1 +50 -50 -E1", Describe(Compile("SHIFT! LEFT")));
+    // Holds nest around the next plain token, then the rest of the target taps normally.
+    EXPECT_EQ("+E0 +E1 +17 -17 -E1 -E0 +4 -4", Describe(Compile("CTRL! SHIFT! T A")));
+    EXPECT_EQ("+n1F0 +n1F1 -n1F1 -n1F0", Describe(Compile("0X1F0! 0X1F1")));
+    // Codes the platform's key table knows compile to the canonical key.
+    char left[8];
+    std::snprintf(left, sizeof(left), "0X%X", caps::core::ToNative(KeyCode::kLeft));
+    EXPECT_EQ("+50 -50", Describe(Compile(left)));
+}
+
+TEST(ActionProgramTest, RejectsTargetsThatCannotBeEmitted) {
+    std::string_view bad;
+    const auto ignore = [](ActionOp) {};
+    EXPECT_EQ(ActionError::kUnknownKey, caps::core::CompileAction("PAGE DOWN", ignore, &bad));
+    EXPECT_EQ("PAGE", bad);
+    EXPECT_EQ(ActionError::kUnknownKey, caps::core::CompileAction("SHIFT! NOPE", ignore, &bad));
+    EXPECT_EQ("NOPE", bad);
+    EXPECT_EQ(ActionError::kDanglingHold, caps::core::CompileAction("LEFT SHIFT!", ignore, &bad));
+    EXPECT_EQ("SHIFT!", bad);
+    EXPECT_EQ(ActionError::kEmpty, caps::core::CompileAction("", ignore, &bad));
+    // Deeper than any real chord: a valid key, but one hold too many.
+    EXPECT_EQ(ActionError::kTooManyHolds, caps::core::CompileAction("A! B! C! D! E! F! G! H! I! J", ignore, &bad));
+    EXPECT_EQ("I!", bad);
+    EXPECT_EQ(caps::core::kMaxActionHolds * 2 + 2, Compile("A! B! C! D! E! F! G! H! J").size());
+}
+
+TEST(ActionProgramTest, TablesCarryAProgramForEveryAction) {
+    const ConfigLoader::MappingTable mappings = {
+        {"*", {
+            MappingDefinition{"J", "SHIFT! LEFT", {}},
+            MappingDefinition{"K", "Two Mods", {}},
+        }},
+        {"CHROME", {MappingDefinition{"J", "HOME", {}}}},
+    };
+    const auto table = CompiledTable::Build(mappings, {});
+    const auto program_for = [&](const std::shared_ptr<const CompiledTable>& t, std::string_view app,
+                                 std::string_view key) {
+        const auto* winner = t->Resolve(t->FindApp(app), t->FindKey(key), 0);
+        EXPECT_NE(nullptr, winner);
+        return winner ? Describe(Ops(t->Program(winner->action))) : std::string();
+    };
+    EXPECT_EQ("+E1 +50 -50 -E1", program_for(table, "", "J"));
+    EXPECT_EQ("+4A -4A", program_for(table, "chrome", "J"));
+    // Targets that do not compile still resolve (and swallow the key) but emit nothing.
+    EXPECT_EQ("", program_for(table, "", "K"));
+    EXPECT_TRUE(table->Program(1000).empty());
+
+    // Patched rows get their programs compiled alongside the appended actions.
+    CompiledTable::Edit edit{"*", 1, 1, {MappingDefinition{"K", "CTRL! END", {}}}};
+    const auto patched = table->Patch({edit});
+    ASSERT_NE(nullptr, patched);
+    EXPECT_EQ("+E0 +4D -4D -E0", program_for(patched, "", "K"));
+    EXPECT_EQ("+E1 +50 -50 -E1", program_for(patched, "", "J"));
+
+    // Programs live in the image, so a cached table needs no recompiling.
+    const caps::test::TempDir dir;
+    const fs::path path = dir / "capsunlocked_action_program.cache";
+    ASSERT_TRUE(patched->WriteImage(path.string(), 7));
+    const auto cached = CompiledTable::LoadImage(path.string(), 7);
+    ASSERT_NE(nullptr, cached);
+    EXPECT_EQ("+E0 +4D -4D -E0", program_for(cached, "", "K"));
+    EXPECT_EQ("+4A -4A", program_for(cached, "chrome", "J"));
+
+    const auto defaults = CompiledTable::Defaults();
+    const auto d_bit = defaults->ModifierBit(defaults->FindKey("D"));
+    const auto s_bit = defaults->ModifierBit(defaults->FindKey("S"));
+    const auto* home = defaults->Resolve(caps::core::kFallbackAppId, defaults->FindKey("J"), d_bit);
+    const auto* select = defaults->Resolve(caps::core::kFallbackAppId, defaults->FindKey("K"), s_bit);
+    ASSERT_NE(nullptr, home);
+    ASSERT_NE(nullptr, select);
+    EXPECT_EQ("+4A -4A", Describe(Ops(defaults->Program(home->action))));
+    EXPECT_EQ("+E1 +51 -51 -E1", Describe(Ops(defaults->Program(select->action))));
+}
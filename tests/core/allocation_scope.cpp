@@ -0,0 +1,46 @@
+#include "allocation_scope.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local bool g_counting = false;
+thread_local std::size_t g_allocations = 0;
+
+} // namespace
+
+namespace caps::test {
+
+AllocationScope::AllocationScope() {
+    g_allocations = 0;
+    g_counting = true;
+}
+
+AllocationScope::~AllocationScope() {
+    g_counting = false;
+}
+
+std::size_t AllocationScope::Count() const {
+    return g_allocations;
+}
+
+} // namespace caps::test
+
+void* operator new(std::size_t size) {
+    if (g_counting) {
+        ++g_allocations;
+    }
+    if (void* block = std::malloc(size == 0 ? 1 : size)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
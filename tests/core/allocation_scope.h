@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+namespace caps::test {
+
+// Counts global operator new calls made by the current thread while a scope is open.
+// The counting operator new lives in allocation_scope.cpp and replaces the global one
+// for the whole test binary; other threads are never counted.
+class AllocationScope {
+public:
+    AllocationScope();
+    ~AllocationScope();
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    [[nodiscard]] std::size_t Count() const;
+};
+
+} // namespace caps::test
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/mapping/compiled_table.h"
+#include "core/mapping/key_codes.h"
+#include "temp_dir.h"
+
+using caps::core::CompiledTable;
+using caps::core::ConfigLoader;
+using caps::core::MappingDefinition;
+
+TEST(CompiledTableTest, MergesFallbackIntoAppSlotsBySpecificity) {
+    const ConfigLoader::MappingTable mappings = {
+        {"*", {
+            MappingDefinition{"J", "DOWN", {}},
+            MappingDefinition{"J", "PAGEDOWN", {"A"}},
+            MappingDefinition{"K", "UP", {}},
+        }},
+        {"CHROME", {
+            MappingDefinition{"J", "LEFT", {}},
+            MappingDefinition{"J", "HOME", {"A"}},
+            MappingDefinition{"J", "END", {"A"}},
+        }},
+    };
+    const auto table = CompiledTable::Build(mappings, {"A"});
+
+    const auto chrome = table->FindApp("chrome");
+    const auto j = table->FindKey("j");
+    ASSERT_NE(caps::core::kFallbackAppId, chrome);
+
+    // App rows beat "*" at equal specificity; within a row, config order wins.
+    std::vector<std::string> order;
+    for (const auto& candidate : table->Candidates(chrome, j)) {
+        order.emplace_back(table->Action(candidate.action));
+    }
+    EXPECT_EQ((std::vector<std::string>{"HOME", "END", "PAGEDOWN", "LEFT", "DOWN"}), order);
+
+    // Unknown apps fall back to the "*" row; keys only mapped in "*" are merged into every app.
+    EXPECT_EQ(caps::core::kFallbackAppId, table->FindApp("firefox"));
+    EXPECT_EQ(caps::core::kFallbackAppId, table->FindApp(""));
+    const auto* up = table->Resolve(chrome, table->FindKey("K"), 0);
+    ASSERT_NE(nullptr, up);
+    EXPECT_EQ("UP", table->Action(up->action));
+    EXPECT_EQ(caps::core::kFallbackAppId, up->app);
+
+    const auto a_bit = table->ModifierBit(table->FindKey("A"));
+    const auto* held = table->Resolve(caps::core::kFallbackAppId, j, a_bit);
+    ASSERT_NE(nullptr, held);
+    EXPECT_EQ("PAGEDOWN", table->Action(held->action));
+}
+
+TEST(CompiledTableTest, UndeclaredModifierRowsNeverMatch) {
+    const ConfigLoader::MappingTable mappings = {
+        {"*", {MappingDefinition{"J", "END", {"Q"}}}},
+    };
+    const auto table = CompiledTable::Build(mappings, {});
+
+    EXPECT_TRUE(table->Candidates(caps::core::kFallbackAppId, table->FindKey("J")).empty());
+    EXPECT_EQ(1u, table->Rows().size());
+}
+
+TEST(CompiledTableTest, ImageRoundTripsThroughDisk) {
+    const ConfigLoader::MappingTable mappings = {
+        {"*", {MappingDefinition{"J", "DOWN", {}}, MappingDefinition{"J", "PAGEDOWN", {"A"}}}},
+        {"CHROME", {MappingDefinition{"K", "SHIFT! UP", {"A"}}}},
+    };
+    const auto built = CompiledTable::Build(mappings, {"A"});
+    const caps::test::TempDir dir;
+    const auto path = (dir / "capsunlocked_table_image.cache").string();
+    ASSERT_TRUE(built->WriteImage(path, 42, 7));
+
+    std::uint32_t flags = 0;
+    const auto loaded = CompiledTable::LoadImage(path, 42, &flags);
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_EQ(7u, flags);
+    EXPECT_EQ(nullptr, CompiledTable::LoadImage(path, 43));
+
+    const auto chrome = loaded->FindApp("Chrome");
+    const auto a_bit = loaded->ModifierBit(loaded->FindKey("a"));
+    const auto* up = loaded->Resolve(chrome, loaded->FindKey("k"), a_bit);
+    ASSERT_NE(nullptr, up);
+    EXPECT_EQ("SHIFT! UP", loaded->Action(up->action));
+    const auto* down = loaded->Resolve(chrome, loaded->FindKey("j"), 0);
+    ASSERT_NE(nullptr, down);
+    EXPECT_EQ("DOWN", loaded->Action(down->action));
+    EXPECT_EQ(built->Modifiers(), loaded->Modifiers());
+    EXPECT_EQ(3u, loaded->Rows().size());
+
+    // An image compiled against another key table is stale even for the same INI.
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const std::uint64_t fingerprint = caps::core::kKeyTableFingerprint;
+    const auto at = bytes.find(std::string(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint)));
+    ASSERT_NE(std::string::npos, at);
+    bytes[at] ^= 1;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    EXPECT_EQ(nullptr, CompiledTable::LoadImage(path, 42));
+}
+
+TEST(CompiledTableTest, PatchResolvesLikeAFullBuild) {
+    ConfigLoader::MappingTable mappings = {
+        {"*", {
+            MappingDefinition{"J", "DOWN", {}},
+            MappingDefinition{"K", "UP", {}},
+            MappingDefinition{"L", "RIGHT", {}},
+        }},
+        {"CHROME", {
+            MappingDefinition{"J", "LEFT", {}},
+            MappingDefinition{"K", "HOME", {"A"}},
+        }},
+        {"CODE", {MappingDefinition{"L", "END", {}}}},
+    };
+    const ConfigLoader::ModifierSet modifiers = {"A"};
+    const auto base = CompiledTable::Build(mappings, modifiers);
+
+    // Replace "*" K (affects every app's K slot), drop "*" L, append a CHROME row for L, and
+    // replace CODE's first row, which sits right where the CHROME append goes.
+    std::vector<CompiledTable::Edit> edits(3);
+    edits[0].app = "*";
+    edits[0].index = 1;
+    edits[0].removed = 2;
+    edits[0].inserted = {MappingDefinition{"K", "PAGEUP", {"A"}}};
+    edits[1].app = "CODE";
+    edits[1].removed = 1;
+    edits[1].inserted = {MappingDefinition{"L", "HOME", {}}};
+    edits[2].app = "CHROME";
+    edits[2].index = 2;
+    edits[2].inserted = {MappingDefinition{"L", "END", {"A"}}};
+    const auto patched = base->Patch(edits);
+    ASSERT_NE(nullptr, patched);
+
+    mappings["*"] = {MappingDefinition{"J", "DOWN", {}}, MappingDefinition{"K", "PAGEUP", {"A"}}};
+    mappings["CHROME"].push_back(MappingDefinition{"L", "END", {"A"}});
+    mappings["CODE"] = {MappingDefinition{"L", "HOME", {}}};
+    const auto rebuilt = CompiledTable::Build(mappings, modifiers);
+
+    const auto a_bit = rebuilt->ModifierBit(rebuilt->FindKey("A"));
+    for (const char* app : {"*", "CHROME", "CODE", "OTHER"}) {
+        for (const char* key : {"J", "K", "L"}) {
+            for (const auto mask : {caps::core::ModifierMask{0}, a_bit}) {
+                const auto* want = rebuilt->Resolve(rebuilt->FindApp(app), rebuilt->FindKey(key), mask);
+                const auto* got = patched->Resolve(patched->FindApp(app), patched->FindKey(key), mask);
+                ASSERT_EQ(want == nullptr, got == nullptr) << app << " " << key << " " << mask;
+                if (want != nullptr) {
+                    EXPECT_EQ(rebuilt->Action(want->action), patched->Action(got->action)) << app << " " << key;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(rebuilt->Rows().size(), patched->Rows().size());
+
+    // Names the table never interned need a full Build().
+    std::vector<CompiledTable::Edit> unknown(1);
+    unknown[0].app = "*";
+    unknown[0].index = 0;
+    unknown[0].inserted = {MappingDefinition{"F13", "DOWN", {}}};
+    EXPECT_EQ(nullptr, base->Patch(unknown));
+}
+
+TEST(CompiledTableTest, FlagsKeysThatSomeAppMapsItself) {
+    const ConfigLoader::MappingTable mappings = {
+        {"*", {
+            MappingDefinition{"J", "DOWN", {}},
+            MappingDefinition{"K", "UP", {}},
+        }},
+        {"CHROME", {MappingDefinition{"J", "LEFT", {}}}},
+        {"CODE", {MappingDefinition{"L", "END", {"A"}}}},
+    };
+    const auto table = CompiledTable::Build(mappings, {"A"});
+
+    EXPECT_TRUE(table->HasAppCandidates(table->FindKey("J")));
+    EXPECT_TRUE(table->HasAppCandidates(table->FindKey("L")));
+    EXPECT_FALSE(table->HasAppCandidates(table->FindKey("K")));
+    EXPECT_FALSE(table->HasAppCandidates(table->FindKey("A")));
+    EXPECT_FALSE(table->HasAppCandidates(caps::core::kInvalidKeyId));
+
+    // Patched tables re-derive the flags: CHROME drops its J row, "*" K gains a CHROME twin.
+    std::vector<CompiledTable::Edit> edits(1);
+    edits[0].app = "CHROME";
+    edits[0].removed = 1;
+    edits[0].inserted = {MappingDefinition{"K", "HOME", {}}};
+    const auto patched = table->Patch(edits);
+    ASSERT_NE(nullptr, patched);
+    EXPECT_FALSE(patched->HasAppCandidates(patched->FindKey("J")));
+    EXPECT_TRUE(patched->HasAppCandidates(patched->FindKey("K")));
+    EXPECT_TRUE(patched->HasAppCandidates(patched->FindKey("L")));
+
+    // The compiled-in defaults are "*"-only.
+    const auto defaults = CompiledTable::Defaults();
+    EXPECT_FALSE(defaults->HasAppCandidates(defaults->FindKey("J")));
+}
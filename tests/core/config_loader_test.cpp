@@ -2,9 +2,15 @@
 
 #include <filesystem>
 #include <fstream>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "core/config/config_loader.h"
+#include "core/mapping/compiled_table.h"
+#include "temp_dir.h"
 
 namespace fs = std::filesystem;
 
@@ -12,17 +18,6 @@ namespace {
 
 class ConfigLoaderTest : public ::testing::Test {
 protected:
-    void SetUp() override {
-        static int counter = 0;
-        temp_dir_ = fs::temp_directory_path() /
-                    fs::path("capsunlocked_test_" + std::to_string(++counter));
-        fs::create_directories(temp_dir_);
-    }
-
-    void TearDown() override {
-        fs::remove_all(temp_dir_);
-    }
-
     fs::path WriteConfig(const std::string& name, const std::string& contents) {
         const fs::path path = temp_dir_ / name;
         std::ofstream stream(path);
@@ -43,7 +38,7 @@ protected:
         return nullptr;
     }
 
-    fs::path temp_dir_;
+    caps::test::TempDir temp_dir_;
 };
 
 } // namespace
@@ -289,3 +284,127 @@ s
     EXPECT_NE(std::string::npos, description.find("2 modifiers"));
     EXPECT_NE(std::string::npos, description.find("[A S]"));
 }
+
+TEST_F(ConfigLoaderTest, CompiledCacheIsReusedWhileConfigIsUnchanged) {
+    const fs::path path = WriteConfig("capsunlocked.ini", R"(
+[modifiers]
+a
+lshift
+
+[maps]
+[*] [j] [Left]
+[*] [a j] [Home]
+[chrome] [lshift k] [Page Down]
+)");
+
+    caps::core::ConfigLoader first;
+    first.SetCacheEnabled(true);
+    first.Load(path.string());
+    EXPECT_FALSE(first.LoadedFromCache());
+    ASSERT_TRUE(fs::exists(path.string() + ".cache"));
+
+    caps::core::ConfigLoader second;
+    second.SetCacheEnabled(true);
+    second.Load(path.string());
+    EXPECT_TRUE(second.LoadedFromCache());
+    EXPECT_TRUE(second.HasModifiersSection());
+    EXPECT_EQ(first.Modifiers(), second.Modifiers());
+    EXPECT_EQ(first.Describe(), second.Describe());
+
+    const auto* home = FindMapping(second.Mappings(), "*", "J");
+    ASSERT_NE(nullptr, home);
+    EXPECT_EQ("LEFT", home->target);
+    const auto* page = FindMapping(second.Mappings(), "CHROME", "K");
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::vector<std::string>{"LSHIFT"}, page->required_mods);
+}
+
+TEST_F(ConfigLoaderTest, CompiledCacheIsIgnoredWhenStaleOrCorrupt) {
+    const fs::path path = WriteConfig("capsunlocked.ini", "[*] [h] [Left]\n");
+    const std::string cache = path.string() + ".cache";
+
+    caps::core::ConfigLoader loader;
+    loader.SetCacheEnabled(true);
+    loader.Load(path.string());
+
+    // Edited config: the content hash no longer matches, so the INI wins.
+    WriteConfig("capsunlocked.ini", "[*] [h] [Home]\n");
+    loader.Load(path.string());
+    EXPECT_FALSE(loader.LoadedFromCache());
+    EXPECT_EQ("HOME", FindMapping(loader.Mappings(), "*", "H")->target);
+
+    // Truncated image: rejected by validation, parsed again and rewritten.
+    fs::resize_file(cache, fs::file_size(cache) / 2);
+    loader.Load(path.string());
+    EXPECT_FALSE(loader.LoadedFromCache());
+    loader.Load(path.string());
+    EXPECT_TRUE(loader.LoadedFromCache());
+    EXPECT_EQ("HOME", FindMapping(loader.Mappings(), "*", "H")->target);
+
+    // Garbage with the right size must not be trusted either.
+    const auto size = fs::file_size(cache);
+    {
+        std::ofstream stream(cache, std::ios::binary | std::ios::trunc);
+        stream << std::string(static_cast<std::size_t>(size), '\x7f');
+    }
+    loader.Load(path.string());
+    EXPECT_FALSE(loader.LoadedFromCache());
+}
+
+TEST_F(ConfigLoaderTest, ReloadReparsesOnlyEditedMappingLines) {
+    const std::string header = "[modifiers]\na\n\n[maps]\n";
+    const fs::path path = WriteConfig("capsunlocked.ini", header +
+        "[*] [j] [Left]\n[*] [k] [Down]\n[chrome] [a k] [Page Down]\n");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(path.string());
+    const auto original = loader.Compiled();
+
+    // Same bytes: nothing to do, the compiled table is kept as-is.
+    loader.Reload();
+    EXPECT_FALSE(loader.LastDelta().full_reload);
+    EXPECT_TRUE(loader.LastDelta().Empty());
+    EXPECT_EQ(original, loader.Compiled());
+
+    // One mapping line edited and one appended.
+    WriteConfig("capsunlocked.ini", header +
+        "[*] [j] [Left]\n[*] [k] [Up]\n[chrome] [a k] [Page Down]\n[chrome] [j] [Home]\n");
+    loader.Reload();
+    const auto& delta = loader.LastDelta();
+    EXPECT_FALSE(delta.full_reload);
+    const std::vector<std::pair<std::string, std::string>> expected = {{"*", "K"}, {"CHROME", "J"}};
+    EXPECT_EQ(expected, delta.changed_groups);
+    EXPECT_EQ("UP", FindMapping(loader.Mappings(), "*", "K")->target);
+    EXPECT_EQ("HOME", FindMapping(loader.Mappings(), "CHROME", "J")->target);
+    const auto table = loader.Compiled();
+    const auto* home = table->Resolve(table->FindApp("chrome"), table->FindKey("J"), 0);
+    ASSERT_NE(nullptr, home);
+    EXPECT_EQ("HOME", table->Action(home->action));
+
+    // Comment-only edits shift later lines but change no definitions.
+    WriteConfig("capsunlocked.ini", header +
+        "# arrows\n[*] [j] [Left]\n[*] [k] [Up]\n[chrome] [a k] [Page Down]\n[chrome] [j] [Home]\n");
+    loader.Reload();
+    EXPECT_FALSE(loader.LastDelta().full_reload);
+    EXPECT_TRUE(loader.LastDelta().Empty());
+
+    // Line numbers in errors still count from the top of the file.
+    WriteConfig("capsunlocked.ini", header +
+        "# arrows\n[*] [j] [Left]\n[*] [a] [Up]\n[chrome] [a k] [Page Down]\n[chrome] [j] [Home]\n");
+    try {
+        loader.Reload();
+        FAIL() << "expected the modifier-as-source line to be rejected";
+    } catch (const std::runtime_error& ex) {
+        EXPECT_NE(std::string::npos, std::string(ex.what()).find("line 7"));
+    }
+    EXPECT_EQ("UP", FindMapping(loader.Mappings(), "*", "K")->target);
+
+    // Touching [modifiers] needs the full parse.
+    WriteConfig("capsunlocked.ini", "[modifiers]\na\nf\n\n[maps]\n[*] [f j] [Home]\n[*] [k] [Up]\n");
+    loader.Reload();
+    EXPECT_TRUE(loader.LastDelta().full_reload);
+    EXPECT_EQ(std::set<std::string>{"F"}, loader.LastDelta().modifiers_added);
+    const std::vector<std::pair<std::string, std::string>> full = {{"*", "J"}, {"CHROME", "J"}, {"CHROME", "K"}};
+    EXPECT_EQ(full, loader.LastDelta().changed_groups);
+    EXPECT_EQ("3 groups changed ([*] J, [CHROME] J, [CHROME] K), modifiers +F", loader.LastDelta().Summary());
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "core/app_context.h"
+#include "core/config/config_watcher.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+using caps::core::ConfigWatcher;
+using caps::core::FileWatchBackend;
+
+namespace {
+
+// Scripted backend: tests queue notifications, waits time out in real time.
+class FakeWatchBackend final : public FileWatchBackend {
+public:
+    void Watch(const std::string& path) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        watched_ = path;
+    }
+
+    WaitResult WaitForChange(std::optional<std::chrono::milliseconds> timeout) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto ready = [&] { return stopped_ || pending_ > 0; };
+        if (timeout) {
+            cv_.wait_for(lock, *timeout, ready);
+        } else {
+            while (!cv_.wait_for(lock, std::chrono::seconds(1), ready)) {
+            }
+        }
+        if (stopped_) {
+            return WaitResult::Stopped;
+        }
+        if (pending_ == 0) {
+            return WaitResult::Timeout;
+        }
+        --pending_;
+        return WaitResult::Changed;
+    }
+
+    void Interrupt() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        cv_.notify_all();
+    }
+
+    void Notify(int count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ += count;
+        cv_.notify_all();
+    }
+
+    std::string Watched() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return watched_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int pending_{0};
+    bool stopped_{false};
+    std::string watched_;
+};
+
+class CallCounter {
+public:
+    void Hit() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++count_;
+        cv_.notify_all();
+    }
+
+    // Waits until at least `expected` calls arrived, then returns the count.
+    int WaitFor(int expected, std::chrono::milliseconds limit = std::chrono::seconds(5)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, limit, [&] { return count_ >= expected; });
+        return count_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_{0};
+};
+
+void WriteFile(const fs::path& path, const std::string& contents) {
+    std::ofstream stream(path);
+    stream << contents;
+}
+
+} // namespace
+
+TEST(ConfigWatcherTest, CoalescesBurstIntoSingleCallback) {
+    auto backend = std::make_unique<FakeWatchBackend>();
+    FakeWatchBackend* fake = backend.get();
+    CallCounter calls;
+
+    ConfigWatcher watcher(std::move(backend), std::chrono::milliseconds(30), [&] { calls.Hit(); });
+    watcher.Start("capsunlocked.ini");
+    EXPECT_EQ("capsunlocked.ini", fake->Watched());
+
+    fake->Notify(5);
+    EXPECT_EQ(1, calls.WaitFor(1));
+    // Nothing else arrives once the burst has been handled.
+    EXPECT_EQ(1, calls.WaitFor(2, std::chrono::milliseconds(100)));
+
+    fake->Notify(1);
+    EXPECT_EQ(2, calls.WaitFor(2));
+    watcher.Stop();
+}
+
+TEST(ConfigWatcherTest, StopDuringDebounceSkipsCallback) {
+    auto backend = std::make_unique<FakeWatchBackend>();
+    FakeWatchBackend* fake = backend.get();
+    CallCounter calls;
+
+    ConfigWatcher watcher(std::move(backend), std::chrono::seconds(10), [&] { calls.Hit(); });
+    watcher.Start("capsunlocked.ini");
+    fake->Notify(1);
+    watcher.Stop();
+    EXPECT_EQ(0, calls.WaitFor(1, std::chrono::milliseconds(0)));
+}
+
+#if defined(__linux__)
+
+TEST(ConfigWatcherTest, AppContextHotReloadsEditedConfig) {
+    const caps::test::TempDir dir;
+    const fs::path path = dir / "capsunlocked.ini";
+    WriteFile(path, "[*] [j] [Down]\n");
+
+    {
+        caps::core::AppContext context;
+        context.Initialize(path.string());
+        ASSERT_EQ("DOWN", context.Mapping().ResolveMapping("J", "")->action);
+
+        // Editor-style save: write a sibling file and rename it over the config.
+        WriteFile(dir / "capsunlocked.ini.swp", "[*] [j] [Home]\n");
+        fs::rename(dir / "capsunlocked.ini.swp", path);
+
+        std::string action;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            action = context.Mapping().ResolveMapping("J", "")->action;
+            if (action == "HOME") {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ("HOME", action);
+    }
+}
+
+#endif
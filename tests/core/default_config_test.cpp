@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "allocation_scope.h"
+#include "core/config/config_loader.h"
+#include "core/config/default_mappings.h"
+#include "core/mapping/compiled_table.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+using caps::core::CompiledTable;
+using caps::core::ConfigLoader;
+using caps::test::AllocationScope;
+
+namespace {
+
+std::string ReadBytes(const fs::path& path) {
+    std::ifstream stream(path, std::ios::binary);
+    std::ostringstream bytes;
+    bytes << stream.rdbuf();
+    return bytes.str();
+}
+
+} // namespace
+
+TEST(DefaultConfigTest, CompiledInTableMatchesRuntimeBuild) {
+    ConfigLoader::MappingTable mappings;
+    for (const auto& mapping : caps::core::kDefaultMappings) {
+        caps::core::MappingDefinition def{std::string(mapping.source), std::string(mapping.target), {}};
+        for (const auto& mod : mapping.required_mods) {
+            if (!mod.empty()) {
+                def.required_mods.emplace_back(mod);
+            }
+        }
+        mappings[std::string(mapping.app)].push_back(def);
+    }
+    const ConfigLoader::ModifierSet modifiers(std::begin(caps::core::kDefaultModifiers),
+                                              std::end(caps::core::kDefaultModifiers));
+
+    const caps::test::TempDir dir;
+    const fs::path built = dir / "capsunlocked_defaults_built.cache";
+    const fs::path compiled_in = dir / "capsunlocked_defaults_static.cache";
+    ASSERT_TRUE(CompiledTable::Build(mappings, modifiers)->WriteImage(built.string(), 1));
+    ASSERT_TRUE(CompiledTable::Defaults()->WriteImage(compiled_in.string(), 1));
+
+    // Byte-identical images: same interning, hash slots, pool layout and candidate order.
+    const std::string expected = ReadBytes(built);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, ReadBytes(compiled_in));
+}
+
+TEST(DefaultConfigTest, NoConfigPathDoesNotAllocate) {
+    const auto defaults = CompiledTable::Defaults();
+    std::size_t allocations = 0;
+    {
+        AllocationScope scope;
+        ConfigLoader loader;
+        const auto table = loader.Compiled();
+        const auto* home = table->Resolve(table->FindApp("notepad"), table->FindKey("j"),
+                                          table->ModifierBit(table->FindKey("d")));
+        ASSERT_NE(nullptr, home);
+        EXPECT_EQ("HOME", table->Action(home->action));
+        EXPECT_EQ(defaults.get(), table.get());
+        allocations = scope.Count();
+    }
+    EXPECT_EQ(0u, allocations);
+
+    // Falling back after a real config swaps the compiled-in table back in unchanged.
+    const caps::test::TempDir dir;
+    const fs::path path = dir / "capsunlocked.ini";
+    std::ofstream(path) << "[*] [h] [Left]\n";
+    ConfigLoader loader;
+    loader.Load(path.string());
+    EXPECT_NE(defaults.get(), loader.Compiled().get());
+    fs::remove(path);
+    loader.Load(path.string());
+    EXPECT_EQ(defaults.get(), loader.Compiled().get());
+
+    // Definitions are only materialized when someone asks for them.
+    EXPECT_EQ(12u, loader.Mappings().at("*").size());
+    EXPECT_EQ((ConfigLoader::ModifierSet{"D", "S"}), loader.Modifiers());
+    EXPECT_TRUE(loader.HasModifiersSection());
+}
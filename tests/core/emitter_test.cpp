@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/layer/emitter.h"
+#include "core/sync/spsc_ring.h"
+
+using caps::core::ActionOp;
+using caps::core::ActionProgram;
+using caps::core::Emitter;
+using caps::core::KeyCode;
+
+namespace {
+
+// Program `index` of a test stream: lengths cycle through 1..40 ops so some span
+// several ring entries, and every op encodes where it came from.
+std::vector<ActionOp> MakeProgram(std::size_t index) {
+    std::vector<ActionOp> ops(1 + index % 40);
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        ops[i] = ActionOp{static_cast<KeyCode>(index % 200), static_cast<std::uint16_t>(i)};
+    }
+    return ops;
+}
+
+ActionProgram View(const std::vector<ActionOp>& ops) {
+    return ActionProgram{ops.data(), ops.data() + ops.size()};
+}
+
+bool SameOps(const std::vector<ActionOp>& a, const std::vector<ActionOp>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].key != b[i].key || a[i].down != b[i].down) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(SpscRingTest, HandsValuesAcrossThreadsInOrder) {
+    caps::core::SpscRing<std::uint64_t, 64> ring;
+    constexpr std::uint64_t kCount = 200000;
+
+    std::thread consumer([&] {
+        std::uint64_t expected = 0;
+        std::uint64_t value = 0;
+        while (expected < kCount) {
+            if (ring.TryPop(value)) {
+                ASSERT_EQ(expected, value);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (std::uint64_t i = 0; i < kCount;) {
+        if (ring.TryPush(i)) {
+            ++i;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    EXPECT_TRUE(ring.Empty());
+
+    // A full ring refuses pushes instead of overwriting.
+    for (std::uint64_t i = 0; i < 64; ++i) {
+        ASSERT_TRUE(ring.TryPush(i));
+    }
+    EXPECT_FALSE(ring.TryPush(64));
+    EXPECT_EQ(0u, ring.FreeSlots());
+}
+
+TEST(EmitterTest, ReplaysProgramsWholeAndInOrderOffThePostingThread) {
+    std::vector<std::pair<std::vector<ActionOp>, bool>> received;
+    std::vector<std::thread::id> threads;
+    Emitter emitter([&](const ActionProgram& program, bool pressed) {
+        received.emplace_back(std::vector<ActionOp>(program.begin(), program.end()), pressed);
+        threads.push_back(std::this_thread::get_id());
+    });
+    emitter.Start();
+
+    constexpr std::size_t kPrograms = 2000;
+    std::size_t posted = 0;
+    for (std::size_t i = 0; i < kPrograms; ++i) {
+        const auto ops = MakeProgram(i);
+        // A full queue drops; back off the way a burst of real keys never needs to.
+        while (!emitter.Post(View(ops), i % 2 == 0)) {
+            std::this_thread::yield();
+        }
+        ++posted;
+    }
+    EXPECT_TRUE(emitter.Post(ActionProgram{}, true)); // nothing to emit, nothing queued
+    emitter.Flush();
+
+    ASSERT_EQ(posted, received.size());
+    for (std::size_t i = 0; i < kPrograms; ++i) {
+        ASSERT_TRUE(SameOps(MakeProgram(i), received[i].first)) << i;
+        EXPECT_EQ(i % 2 == 0, received[i].second);
+        EXPECT_NE(std::this_thread::get_id(), threads[i]);
+    }
+}
+
+TEST(EmitterTest, DropsProgramsThatDoNotFitAndDrainsOnStop) {
+    std::vector<std::vector<ActionOp>> received;
+    Emitter emitter([&](const ActionProgram& program, bool) {
+        received.emplace_back(program.begin(), program.end());
+    });
+
+    // Not started yet, so nothing drains: fill the queue with two-entry programs.
+    const std::vector<ActionOp> long_program = MakeProgram(Emitter::kOpsPerEntry); // kOpsPerEntry + 1 ops
+    std::size_t accepted = 0;
+    while (emitter.Post(View(long_program), true)) {
+        ++accepted;
+    }
+    EXPECT_EQ(Emitter::kQueueDepth / 2, accepted);
+    EXPECT_EQ(1u, emitter.Dropped());
+    EXPECT_FALSE(emitter.Post(View(long_program), true));
+    EXPECT_EQ(2u, emitter.Dropped());
+
+    emitter.Start();
+    emitter.Stop();
+    ASSERT_EQ(accepted, received.size());
+    for (const auto& ops : received) {
+        EXPECT_TRUE(SameOps(long_program, ops));
+    }
+}
+
+TEST(EmitterTest, WakesOnEveryPostWithoutWaitingOutTheIdleTimeout) {
+    // Posts land at varying points of the emitter thread going idle, including between
+    // its empty check and its wait; none may sit in the queue until the idle timeout.
+    constexpr std::size_t kPosts = 2000;
+    constexpr auto kIdleWait = std::chrono::milliseconds(100);
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> posted(kPosts), received(kPosts);
+    std::size_t count = 0;
+    Emitter emitter([&](const ActionProgram&, bool) { received[count++] = Clock::now(); });
+    emitter.Start();
+
+    const std::vector<ActionOp> ops = MakeProgram(0);
+    for (std::size_t i = 0; i < kPosts; ++i) {
+        const auto until = Clock::now() + std::chrono::microseconds(i % 50);
+        while (Clock::now() < until) {
+        }
+        posted[i] = Clock::now();
+        ASSERT_TRUE(emitter.Post(View(ops), true));
+    }
+    emitter.Flush();
+
+    ASSERT_EQ(kPosts, count);
+    Clock::duration worst{0};
+    for (std::size_t i = 0; i < kPosts; ++i) {
+        worst = std::max(worst, received[i] - posted[i]);
+    }
+    EXPECT_LT(worst, kIdleWait / 5);
+}
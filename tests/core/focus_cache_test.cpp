@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "core/focus/focus_cache.h"
+
+using caps::core::FocusCache;
+using caps::core::ProcessId;
+
+namespace {
+
+class FakeFocusProvider : public caps::core::FocusProvider {
+public:
+    ProcessId FocusedProcess() const override {
+        return focused;
+    }
+    std::string AppName(ProcessId pid) const override {
+        const auto it = names.find(pid);
+        return it == names.end() ? std::string() : it->second;
+    }
+
+    ProcessId focused{caps::core::kNoProcess};
+    std::map<ProcessId, std::string> names;
+};
+
+} // namespace
+
+TEST(FocusCacheTest, NotificationsEndTheCachedFocus) {
+    FakeFocusProvider provider;
+    provider.names = {{10, "CHROME"}, {20, "CODE"}};
+    provider.focused = 10;
+    FocusCache cache(provider, FocusCache::Clock::duration::zero());
+
+    EXPECT_EQ("CHROME", cache.Current());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ("CHROME", cache.Current());
+    }
+    EXPECT_EQ(1u, cache.ProcessQueries());
+    EXPECT_EQ(1u, cache.NameQueries());
+
+    // Without a notification the cache keeps answering for the old window.
+    provider.focused = 20;
+    EXPECT_EQ("CHROME", cache.Current());
+    cache.Invalidate();
+    EXPECT_EQ("CODE", cache.Current());
+
+    // Switching back finds CHROME's name memoized under its pid.
+    provider.focused = 10;
+    cache.Invalidate();
+    EXPECT_EQ("CHROME", cache.Current());
+    EXPECT_EQ(3u, cache.ProcessQueries());
+    EXPECT_EQ(2u, cache.NameQueries());
+}
+
+TEST(FocusCacheTest, TtlBoundsHowLongAFocusIsTrusted) {
+    using std::chrono::milliseconds;
+    FakeFocusProvider provider;
+    provider.names = {{10, "CHROME"}, {20, "CODE"}};
+    provider.focused = 10;
+    FocusCache cache(provider, milliseconds(100));
+
+    const FocusCache::Clock::time_point start{};
+    EXPECT_EQ("CHROME", cache.Current(start));
+    provider.focused = 20;
+    EXPECT_EQ("CHROME", cache.Current(start + milliseconds(99)));
+    EXPECT_EQ(1u, cache.ProcessQueries());
+    EXPECT_EQ("CODE", cache.Current(start + milliseconds(100)));
+    EXPECT_EQ(2u, cache.ProcessQueries());
+
+    // A lapsed TTL on the same window re-checks the pid but not the name.
+    EXPECT_EQ("CODE", cache.Current(start + milliseconds(250)));
+    EXPECT_EQ(3u, cache.ProcessQueries());
+    EXPECT_EQ(2u, cache.NameQueries());
+
+    // Memoized names expire too, since the pid may belong to a new process by then.
+    provider.names[20] = "TERMINAL";
+    EXPECT_EQ("TERMINAL", cache.Current(start + FocusCache::kNameLifetime + milliseconds(100)));
+    EXPECT_EQ(3u, cache.NameQueries());
+}
+
+TEST(FocusCacheTest, UnknownFocusIsNotMemoized) {
+    FakeFocusProvider provider;
+    FocusCache cache(provider, FocusCache::Clock::duration::zero());
+
+    EXPECT_EQ("", cache.Current());
+    EXPECT_EQ(0u, cache.NameQueries());
+
+    provider.focused = 30; // no name yet, e.g. the process is still launching
+    cache.Invalidate();
+    EXPECT_EQ("", cache.Current());
+    provider.names[30] = "SLACK";
+    cache.Invalidate();
+    EXPECT_EQ("SLACK", cache.Current());
+    EXPECT_EQ(2u, cache.NameQueries());
+
+    // More windows than the memo holds: the oldest names are recomputed.
+    for (ProcessId pid = 100; pid < 100 + static_cast<ProcessId>(FocusCache::kMemoSize); ++pid) {
+        provider.names[pid] = "APP" + std::to_string(pid);
+        provider.focused = pid;
+        cache.Invalidate();
+        EXPECT_EQ(provider.names[pid], cache.Current());
+    }
+    provider.focused = 30;
+    cache.Invalidate();
+    EXPECT_EQ("SLACK", cache.Current());
+    EXPECT_EQ(3u + FocusCache::kMemoSize, cache.NameQueries());
+}
+
+TEST(FocusCacheTest, GenerationOnlyMovesWhenTheAnswerChanges) {
+    FakeFocusProvider provider;
+    provider.names = {{10, "CHROME"}, {11, "CHROME"}, {20, "CODE"}};
+    provider.focused = 10;
+    FocusCache cache(provider, FocusCache::Clock::duration::zero());
+
+    EXPECT_EQ("CHROME", cache.Current());
+    const auto chrome = cache.Generation();
+    cache.Invalidate();
+    EXPECT_EQ("CHROME", cache.Current());
+    provider.focused = 11; // another window of the same app
+    cache.Invalidate();
+    EXPECT_EQ("CHROME", cache.Current());
+    EXPECT_EQ(chrome, cache.Generation());
+
+    provider.focused = 20;
+    cache.Invalidate();
+    EXPECT_EQ("CODE", cache.Current());
+    EXPECT_NE(chrome, cache.Generation());
+}
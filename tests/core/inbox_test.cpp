@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/layer/layer_controller.h"
+#include "core/mapping/mapping_engine.h"
+#include "core/sync/mpsc_queue.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Tagged {
+    std::uint32_t producer{0};
+    std::uint32_t sequence{0};
+};
+
+} // namespace
+
+TEST(MpscQueueTest, KeepsEachProducersOrderAndLosesNothing) {
+    caps::core::MpscQueue<Tagged, 128> queue;
+    constexpr std::uint32_t kProducers = 6;
+    constexpr std::uint32_t kPerProducer = 50000;
+
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+    for (std::uint32_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (std::uint32_t i = 0; i < kPerProducer;) {
+                if (queue.TryPush(Tagged{p, i})) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    go.store(true);
+
+    std::vector<std::uint32_t> next(kProducers, 0);
+    std::uint64_t received = 0;
+    Tagged item;
+    while (received < std::uint64_t{kProducers} * kPerProducer) {
+        if (!queue.TryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_LT(item.producer, kProducers);
+        ASSERT_EQ(next[item.producer], item.sequence) << "producer " << item.producer;
+        ++next[item.producer];
+        ++received;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_FALSE(queue.TryPop(item));
+
+    // Full means full: nothing is overwritten.
+    for (std::uint32_t i = 0; i < 128; ++i) {
+        ASSERT_TRUE(queue.TryPush(Tagged{0, i}));
+    }
+    EXPECT_FALSE(queue.TryPush(Tagged{0, 128}));
+    ASSERT_TRUE(queue.TryPop(item));
+    EXPECT_EQ(0u, item.sequence);
+    EXPECT_TRUE(queue.TryPush(Tagged{0, 128}));
+}
+
+TEST(LayerInboxTest, PostedTransitionsApplyBeforeTheNextKey) {
+    const caps::test::TempDir dir;
+    const fs::path path = dir / "capsunlocked.ini";
+    std::ofstream(path) << "[*] [h] [Left]\n";
+    caps::core::ConfigLoader loader;
+    loader.Load(path.string());
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+    caps::core::LayerController controller(mapping);
+
+    std::vector<std::string> emitted;
+    controller.SetActionCallback([&emitted](const std::string& action, bool pressed) {
+        if (pressed) emitted.push_back(action);
+    });
+
+    // Posted from another thread, nothing changes until the owner drains.
+    std::thread([&controller] { EXPECT_TRUE(controller.PostCapsLock(true)); }).join();
+    EXPECT_FALSE(controller.IsLayerActive());
+    EXPECT_TRUE(controller.OnKeyEvent({"h", "", true}));
+    EXPECT_TRUE(controller.IsLayerActive());
+
+    // Several threads racing press/release pairs: the owner sees them in push order and
+    // ends up with whatever was posted last.
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&controller] {
+            for (int i = 0; i < 8; ++i) {
+                EXPECT_TRUE(controller.PostCapsLock(true));
+                EXPECT_TRUE(controller.PostCapsLock(false));
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(controller.IsLayerActive());
+    EXPECT_FALSE(controller.OnKeyEvent({"h", "", true}));
+    EXPECT_FALSE(controller.IsLayerActive());
+
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/mapping/key_codes.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+using caps::core::KeyCode;
+using caps::core::Platform;
+
+TEST(KeyCodesTest, EveryNameAndAliasResolvesThroughThePerfectHash) {
+    using caps::core::detail::kAliases;
+    using caps::core::detail::kKeys;
+    for (const auto& info : kKeys) {
+        EXPECT_EQ(info.key, caps::core::LookupKeyName(info.name)) << info.name;
+        EXPECT_EQ(info.name, caps::core::KeyName(info.key));
+    }
+    for (const auto& alias : kAliases) {
+        EXPECT_EQ(alias.key, caps::core::LookupKeyName(alias.name)) << alias.name;
+    }
+    EXPECT_EQ("ESC", caps::core::KeyName(caps::core::LookupKeyName("ESCAPE")));
+    EXPECT_EQ("LSHIFT", caps::core::KeyName(caps::core::LookupKeyName("SHIFT")));
+
+    for (const char* unknown : {"", "a", "esc", "F0", "F21", "PAGE", "LEFT!", "ESCAPES", "0X", "0XZZ", "0X8000"}) {
+        EXPECT_EQ(KeyCode::kNone, caps::core::LookupKeyName(unknown)) << unknown;
+    }
+    EXPECT_TRUE(caps::core::IsNativeKey(caps::core::LookupKeyName("0X0")));
+    EXPECT_EQ(0x7Bu, caps::core::NativeKeyCode(caps::core::LookupKeyName("0X7B")));
+}
+
+TEST(KeyCodesTest, NativeCodesRoundTripOnEveryPlatform) {
+    for (const Platform platform : {Platform::kMac, Platform::kWindows, Platform::kLinux}) {
+        for (const auto& info : caps::core::detail::kKeys) {
+            const std::uint16_t code = caps::core::ToNative(info.key, platform);
+            ASSERT_NE(caps::core::kNoNativeCode, code) << info.name;
+            EXPECT_EQ(info.key, caps::core::FromNative(code, platform)) << info.name;
+            EXPECT_EQ(info.name, caps::core::NativeKeyToken(code, platform));
+        }
+    }
+
+    // Spot checks against the platform headers.
+    EXPECT_EQ(0x7Bu, caps::core::ToNative(KeyCode::kLeft, Platform::kMac));      // kVK_LeftArrow
+    EXPECT_EQ(0x25u, caps::core::ToNative(KeyCode::kLeft, Platform::kWindows));  // VK_LEFT
+    EXPECT_EQ(105u, caps::core::ToNative(KeyCode::kLeft, Platform::kLinux));     // KEY_LEFT
+    EXPECT_EQ(0x00u, caps::core::ToNative(KeyCode::kA, Platform::kMac));         // kVK_ANSI_A
+    EXPECT_EQ(KeyCode::kLeftShift, caps::core::FromNative(0x10, Platform::kWindows)); // VK_SHIFT
+
+    // Unnamed codes keep the hex spelling the hooks have always reported.
+    EXPECT_EQ("0X7F", caps::core::NativeKeyToken(0x7F, Platform::kMac));
+    EXPECT_EQ("0X5", caps::core::NativeKeyToken(0x05, Platform::kWindows));
+    EXPECT_EQ("", caps::core::NativeKeyToken(0x100, Platform::kWindows));
+    EXPECT_EQ(caps::core::kNoNativeCode, caps::core::ToNative(KeyCode::kNone, Platform::kMac));
+}
+
+TEST(KeyCodesTest, HexConfigKeysAreStoredUnderTheNamesHooksReport) {
+    EXPECT_EQ("ESC", caps::core::CanonicalKeyToken("ESCAPE"));
+    EXPECT_EQ("LEFT", caps::core::CanonicalKeyToken("0X7B", Platform::kMac));
+    EXPECT_EQ("LEFT", caps::core::CanonicalKeyToken("0X25", Platform::kWindows));
+    EXPECT_EQ("0X7F", caps::core::CanonicalKeyToken("0X07F", Platform::kMac));
+    EXPECT_EQ("", caps::core::CanonicalKeyToken("CUSTOM"));
+
+    char left[8];
+    std::snprintf(left, sizeof(left), "0x%x", caps::core::ToNative(KeyCode::kLeft));
+    const caps::test::TempDir dir;
+    const fs::path path = dir / "capsunlocked.ini";
+    std::ofstream(path) << "[modifiers]\nshift\n\n[maps]\n[*] [Escape] [Enter]\n[*] [" << left
+                        << "] [Home]\n[*] [shift ;] [End]\n[*] [0x1F0] [Tab]\n";
+    caps::core::ConfigLoader loader;
+    loader.Load(path.string());
+
+    const auto& defs = loader.Mappings().at("*");
+    ASSERT_EQ(4u, defs.size());
+    EXPECT_EQ("ESCAPE", defs[0].source); // names are kept as written
+    EXPECT_EQ("LEFT", defs[1].source);
+    EXPECT_EQ(";", defs[2].source);
+    EXPECT_EQ((std::vector<std::string>{"SHIFT"}), defs[2].required_mods);
+    EXPECT_EQ("0X1F0", defs[3].source); // no name on any platform
+    EXPECT_EQ((caps::core::ConfigLoader::ModifierSet{"SHIFT"}), loader.Modifiers());
+}
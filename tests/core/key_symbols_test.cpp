@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "core/mapping/key_symbols.h"
+
+using caps::core::KeyId;
+using caps::core::KeySymbolTable;
+using caps::core::kInvalidKeyId;
+
+TEST(KeySymbolTableTest, InternsDenseIdsAndNormalizes) {
+    KeySymbolTable table;
+
+    const KeyId j = table.Intern("j");
+    const KeyId page_down = table.Intern(" Page Down ");
+    EXPECT_EQ(0u, j);
+    EXPECT_EQ(1u, page_down);
+    EXPECT_EQ(j, table.Intern("J"));
+    EXPECT_EQ(2u, table.Size());
+
+    EXPECT_EQ("J", table.Name(j));
+    EXPECT_EQ("PAGEDOWN", table.Name(page_down));
+}
+
+TEST(KeySymbolTableTest, FindNormalizesWithoutInserting) {
+    KeySymbolTable table;
+    const KeyId shift = table.Intern("Shift");
+
+    EXPECT_EQ(shift, table.Find("shift"));
+    EXPECT_EQ(shift, table.Find("SH IFT"));
+    EXPECT_EQ(kInvalidKeyId, table.Find("ctrl"));
+    EXPECT_EQ(kInvalidKeyId, table.Find(""));
+    EXPECT_EQ(kInvalidKeyId, table.Intern("   "));
+    EXPECT_EQ(1u, table.Size());
+}
+
+TEST(KeySymbolTableTest, SurvivesGrowth) {
+    KeySymbolTable table;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(static_cast<KeyId>(i), table.Intern("KEY" + std::to_string(i)));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(static_cast<KeyId>(i), table.Find("key" + std::to_string(i)));
+    }
+}
@@ -1,12 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <initializer_list>
+#include <set>
 #include <vector>
 
+#include "allocation_scope.h"
 #include "core/config/config_loader.h"
+#include "core/layer/emitter.h"
+#include "core/layer/held_keys.h"
 #include "core/layer/layer_controller.h"
+#include "core/logging.h"
 #include "core/mapping/mapping_engine.h"
+#include "temp_dir.h"
 
 namespace fs = std::filesystem;
 
@@ -14,17 +22,6 @@ namespace {
 
 class LayerControllerTest : public ::testing::Test {
 protected:
-    void SetUp() override {
-        static int counter = 0;
-        temp_dir_ = fs::temp_directory_path() /
-                    fs::path("capsunlocked_layer_test_" + std::to_string(++counter));
-        fs::create_directories(temp_dir_);
-    }
-
-    void TearDown() override {
-        fs::remove_all(temp_dir_);
-    }
-
     fs::path WriteConfig(const std::string& contents) {
         const fs::path path = temp_dir_ / "capsunlocked.ini";
         std::ofstream stream(path);
@@ -32,7 +29,7 @@ protected:
         return path;
     }
 
-    fs::path temp_dir_;
+    caps::test::TempDir temp_dir_;
 };
 
 } // namespace
@@ -258,3 +255,334 @@ d
     ASSERT_EQ(1u, emitted.size());
     EXPECT_EQ("NO MODS", emitted[0].first);
 }
+
+TEST_F(LayerControllerTest, ModifierMaskSelectsMostSpecificBracketMapping) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+s
+
+[maps]
+[*] [j] [Down]
+[*] [a j] [PageDown]
+[*] [a s j] [End]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    std::vector<std::pair<std::string, bool>> emitted;
+    controller.SetActionCallback(
+        [&emitted](const std::string& action, bool pressed) { emitted.emplace_back(action, pressed); });
+
+    controller.OnCapsLockPressed();
+
+    controller.OnKeyEvent({"s", "", true});
+    controller.OnKeyEvent({"j", "", true});
+    controller.OnKeyEvent({"a", "", true});
+    controller.OnKeyEvent({"j", "", true});
+    EXPECT_EQ((std::set<std::string>{"A", "S"}), controller.GetActiveModifiers());
+    controller.OnKeyEvent({"s", "", false});
+    controller.OnKeyEvent({"j", "", true});
+
+    ASSERT_EQ(3u, emitted.size());
+    EXPECT_EQ("DOWN", emitted[0].first);
+    EXPECT_EQ("END", emitted[1].first);
+    EXPECT_EQ("PAGEDOWN", emitted[2].first);
+}
+
+TEST_F(LayerControllerTest, ProgramCallbackReceivesPrecompiledOps) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+
+[maps]
+[*] [j] [Left]
+[*] [a j] [Shift! Left]
+[*] [k] [Page Down]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    using Op = std::pair<caps::core::KeyCode, bool>;
+    std::vector<std::pair<std::vector<Op>, bool>> emitted;
+    controller.SetProgramCallback([&emitted](const caps::core::ActionProgram& program, bool pressed) {
+        std::vector<Op> ops;
+        for (const auto& op : program) {
+            ops.emplace_back(op.key, op.down != 0);
+        }
+        emitted.emplace_back(std::move(ops), pressed);
+    });
+
+    controller.OnCapsLockPressed();
+    controller.OnKeyEvent({"j", "", true});
+    controller.OnKeyEvent({"j", "", false});
+    controller.OnKeyEvent({"a", "", true});
+    controller.OnKeyEvent({"j", "", true});
+    controller.OnKeyEvent({"k", "", true});
+
+    using caps::core::KeyCode;
+    ASSERT_EQ(4u, emitted.size());
+    const std::vector<Op> left = {{KeyCode::kLeft, true}, {KeyCode::kLeft, false}};
+    EXPECT_EQ(left, emitted[0].first);
+    EXPECT_TRUE(emitted[0].second);
+    EXPECT_EQ(left, emitted[1].first);
+    EXPECT_FALSE(emitted[1].second);
+    const std::vector<Op> select_left = {
+        {KeyCode::kLeftShift, true}, {KeyCode::kLeft, true}, {KeyCode::kLeft, false}, {KeyCode::kLeftShift, false}};
+    EXPECT_EQ(select_left, emitted[2].first);
+    // "PAGE DOWN" names no key: still consumed, with nothing to emit.
+    EXPECT_TRUE(emitted[3].first.empty());
+}
+
+TEST_F(LayerControllerTest, HookPreChecksMatchTheLoadedConfig) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+
+[maps]
+[*] [j] [Left]
+[*] [a k] [Home]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    EXPECT_FALSE(controller.IsLayerActive());
+    controller.OnCapsLockPressed();
+    EXPECT_TRUE(controller.IsLayerActive());
+    controller.OnCapsLockReleased();
+    EXPECT_FALSE(controller.IsLayerActive());
+
+    using caps::core::KeyCode;
+    EXPECT_TRUE(controller.IsKeyOfInterest(KeyCode::kJ));
+    EXPECT_TRUE(controller.IsKeyOfInterest(KeyCode::kK));
+    EXPECT_TRUE(controller.IsKeyOfInterest(KeyCode::kA)); // modifier
+    EXPECT_FALSE(controller.IsKeyOfInterest(KeyCode::kH));
+    EXPECT_FALSE(controller.IsKeyOfInterest(KeyCode::kF5));
+    EXPECT_FALSE(controller.IsKeyOfInterest(KeyCode::kLeft)); // targets do not count
+    // Keys the table cannot name always take the full path.
+    EXPECT_TRUE(controller.IsKeyOfInterest(KeyCode::kNone));
+
+    // Compiled-in defaults: sources and their modifiers only.
+    const auto defaults = caps::core::CompiledTable::Defaults();
+    for (const KeyCode key : {KeyCode::kJ, KeyCode::kK, KeyCode::kI, KeyCode::kL, KeyCode::kD, KeyCode::kS}) {
+        EXPECT_TRUE(defaults->IsKeyOfInterest(key));
+    }
+    EXPECT_FALSE(defaults->IsKeyOfInterest(KeyCode::kQ));
+}
+
+TEST_F(LayerControllerTest, AppResolverOnlyRunsForKeysWithAppMappings) {
+    const fs::path config_path = WriteConfig(R"(
+[maps]
+[*] [j] [Left]
+[*] [k] [Down]
+[chrome] [k] [Home]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    std::vector<std::string> emitted;
+    controller.SetActionCallback([&emitted](const std::string& action, bool pressed) {
+        if (pressed) emitted.push_back(action);
+    });
+    int focus_queries = 0;
+    controller.SetAppResolver([&focus_queries] {
+        ++focus_queries;
+        return caps::core::MappingEngine::FocusedApp{"CHROME", 1};
+    });
+
+    controller.OnCapsLockPressed();
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", true}));
+    EXPECT_EQ(0, focus_queries);
+    EXPECT_TRUE(controller.OnKeyEvent({"k", "", true}));
+    EXPECT_EQ(1, focus_queries);
+    // An app the hook already knows is used as given.
+    EXPECT_TRUE(controller.OnKeyEvent({"k", "firefox", true}));
+    EXPECT_EQ(1, focus_queries);
+
+    EXPECT_EQ((std::vector<std::string>{"LEFT", "HOME", "DOWN"}), emitted);
+}
+
+TEST_F(LayerControllerTest, HeldKeysRepeatAndReleaseWhatThePressResolved) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+
+[maps]
+[*] [a j] [End]
+[*] [j] [Down]
+[chrome] [k] [Home]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    std::vector<std::pair<std::string, bool>> emitted;
+    controller.SetActionCallback(
+        [&emitted](const std::string& action, bool pressed) { emitted.emplace_back(action, pressed); });
+    std::uint64_t focus_queries = 0;
+    controller.SetAppResolver([&focus_queries] {
+        // A new generation every time: only a real resolution would notice.
+        ++focus_queries;
+        return caps::core::MappingEngine::FocusedApp{"CHROME", focus_queries};
+    });
+
+    controller.OnCapsLockPressed();
+
+    // Auto-repeat: one focus query for the press, none for the repeats or the release.
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(controller.OnKeyEvent({"k", "", true}));
+    }
+    EXPECT_TRUE(controller.OnKeyEvent({"k", "", false}));
+    EXPECT_EQ(1u, focus_queries);
+    ASSERT_EQ(6u, emitted.size());
+    EXPECT_EQ(std::make_pair(std::string("HOME"), false), emitted.back());
+    emitted.clear();
+
+    // The release matches the press even when a modifier went down in between.
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", true}));
+    EXPECT_TRUE(controller.OnKeyEvent({"a", "", true}));
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", false}));
+    ASSERT_EQ(2u, emitted.size());
+    EXPECT_EQ(std::make_pair(std::string("DOWN"), true), emitted[0]);
+    EXPECT_EQ(std::make_pair(std::string("DOWN"), false), emitted[1]);
+    emitted.clear();
+
+    // Pressed again under the modifier, it resolves afresh.
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", true}));
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", true}));
+    EXPECT_TRUE(controller.OnKeyEvent({"a", "", false}));
+    EXPECT_TRUE(controller.OnKeyEvent({"j", "", false}));
+    ASSERT_EQ(3u, emitted.size());
+    EXPECT_EQ("END", emitted[0].first);
+    EXPECT_EQ("END", emitted[1].first);
+    EXPECT_EQ(std::make_pair(std::string("END"), false), emitted[2]);
+}
+
+TEST(HeldKeysTest, CollidingKeysSurviveErasure) {
+    caps::core::HeldKeys held;
+    constexpr auto kCap = static_cast<caps::core::KeyId>(caps::core::HeldKeys::kCapacity);
+    // 3, 3 + cap and 3 + 2 * cap share a home slot; 4 lands in the middle of their chain.
+    for (caps::core::KeyId key : {caps::core::KeyId{3}, caps::core::KeyId(3 + kCap), caps::core::KeyId{4},
+                                  caps::core::KeyId(3 + 2 * kCap)}) {
+        ASSERT_TRUE(held.Insert({key, 1, 0, key, true}));
+    }
+    held.Erase(3);
+    held.Erase(4);
+    EXPECT_EQ(nullptr, held.Find(3));
+    EXPECT_EQ(nullptr, held.Find(4));
+    ASSERT_NE(nullptr, held.Find(3 + kCap));
+    ASSERT_NE(nullptr, held.Find(3 + 2 * kCap));
+    EXPECT_EQ(3u + 2 * kCap, held.Find(3 + 2 * kCap)->action);
+
+    // Full means nothing more is cached, not that anything is overwritten.
+    held.Clear();
+    for (caps::core::KeyId key = 0; key < kCap; ++key) {
+        ASSERT_TRUE(held.Insert({key, 1, 0, key, true}));
+    }
+    EXPECT_FALSE(held.Insert({kCap, 1, 0, 0, true}));
+    EXPECT_EQ(caps::core::HeldKeys::kCapacity, held.Size());
+}
+
+TEST_F(LayerControllerTest, KeyPathDoesNotAllocateOnceWarm) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+
+[maps]
+[*] [j] [Down]
+[*] [a j] [Shift End]
+[*] [k] [Up]
+[chrome] [k] [Ctrl Shift Alt Home]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+
+    caps::core::LayerController controller(mapping);
+
+    std::size_t emitted_ops = 0;
+    caps::core::Emitter emitter([&emitted_ops](const caps::core::ActionProgram& program, bool) {
+        emitted_ops += program.size();
+    });
+    emitter.Start();
+    controller.SetProgramCallback(
+        [&emitter](const caps::core::ActionProgram& program, bool pressed) { emitter.Post(program, pressed); });
+    // Long enough to defeat the small-string buffer, so the action text really is reused.
+    std::string last_action;
+    last_action.reserve(64);
+    controller.SetActionCallback([&last_action](const std::string& action, bool) { last_action = action; });
+    std::uint64_t generation = 1;
+    controller.SetAppResolver([&generation] { return caps::core::MappingEngine::FocusedApp{"CHROME", generation}; });
+
+    // Built up front: constructing the events is the hook's business, not the layer's.
+    const caps::core::KeyEvent j_down{"j", "", true};
+    const caps::core::KeyEvent j_up{"j", "", false};
+    const caps::core::KeyEvent k_down{"k", "", true};
+    const caps::core::KeyEvent k_up{"k", "", false};
+    const caps::core::KeyEvent a_down{"a", "", true};
+    const caps::core::KeyEvent a_up{"a", "", false};
+    const caps::core::KeyEvent unmapped{"z", "", true};
+    const auto play = [&](std::initializer_list<const caps::core::KeyEvent*> events) {
+        for (const auto* event : events) {
+            controller.OnKeyEvent(*event);
+        }
+    };
+    const std::initializer_list<const caps::core::KeyEvent*> session = {
+        &j_down, &j_down, &j_down, &j_up,          // press, auto-repeat, release
+        &a_down, &j_down, &j_down, &a_up, &j_up,   // modified mapping, released after the modifier
+        &k_down, &k_down, &k_up, &unmapped,        // app-specific mapping, unmapped key
+    };
+
+    controller.OnCapsLockPressed();
+    play(session); // warm-up: first-touch growth in the epoch domain and the action buffer
+    emitter.Flush();
+
+    // At the shipped default level, so the per-key debug lines are formatted too.
+    const auto level = caps::core::logging::GetLevel();
+    caps::core::logging::SetLevel(caps::core::logging::Level::Debug);
+    std::size_t allocations = 0;
+    {
+        caps::test::AllocationScope scope;
+        ++generation; // a focus change re-resolves the app row without allocating either
+        play(session);
+        allocations = scope.Count();
+    }
+    caps::core::logging::SetLevel(level);
+    emitter.Flush();
+    EXPECT_EQ(0u, allocations);
+    EXPECT_EQ(0u, emitter.Dropped());
+    EXPECT_GT(emitted_ops, 0u);
+    EXPECT_EQ("CTRL SHIFT ALT HOME", last_action);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/logging.h"
+
+namespace logging = caps::core::logging;
+
+namespace {
+
+// Routes the writer into a vector for the duration of a test.
+class LoggingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        level_ = logging::GetLevel();
+        logging::SetLevel(logging::Level::Debug);
+        logging::Flush();
+        logging::SetSink([this](logging::Level, std::string_view line) {
+            if (gate_) {
+                entered_.store(true);
+                while (gate_->load() == false) {
+                    std::this_thread::yield();
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.emplace_back(line);
+        });
+    }
+
+    void TearDown() override {
+        logging::Flush();
+        logging::SetSink({});
+        logging::SetLevel(level_);
+    }
+
+    std::vector<std::string> Lines() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_;
+    }
+
+    logging::Level level_{logging::Level::Debug};
+    std::atomic<bool>* gate_{nullptr}; // when set, the sink holds the writer until it opens
+    std::atomic<bool> entered_{false};
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+};
+
+} // namespace
+
+TEST_F(LoggingTest, WriterFormatsLinesAndCutsLongMessages) {
+    logging::Info("[Test] hello");
+    logging::Debug(std::string(2 * logging::kMaxMessage, 'x'));
+    logging::Flush();
+
+    const auto lines = Lines();
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_TRUE(std::regex_match(lines[0], std::regex(R"(\[\d\d:\d\d:\d\d\] \[INFO\] \[Test\] hello)"))) << lines[0];
+    const std::string prefix = lines[1].substr(0, lines[1].find("] x") + 2);
+    EXPECT_EQ(prefix.size() + logging::kMaxMessage, lines[1].size());
+    EXPECT_EQ("...", lines[1].substr(lines[1].size() - 3));
+}
+
+TEST_F(LoggingTest, FullRingDropsAndCountsInsteadOfBlocking) {
+    std::atomic<bool> open{false};
+    gate_ = &open;
+    logging::Info("[Test] stalls the writer");
+    while (!entered_.load()) {
+        std::this_thread::yield();
+    }
+
+    // The writer is stuck in the sink: the ring takes kQueueDepth more, the rest drop.
+    const std::uint64_t dropped_before = logging::Dropped();
+    for (std::size_t i = 0; i < logging::kQueueDepth + 10; ++i) {
+        logging::Debug("[Test] filler");
+    }
+    EXPECT_EQ(10u, logging::Dropped() - dropped_before);
+
+    open.store(true);
+    logging::Flush();
+    const auto lines = Lines();
+    EXPECT_EQ(logging::kQueueDepth + 2, lines.size()); // stall, ring contents, drop report
+    EXPECT_NE(std::string::npos, lines.back().find("[WARN] [Logging] Log queue full; dropped 10 message(s)"))
+        << lines.back();
+}
+
+TEST_F(LoggingTest, SubsystemLevelsOverrideTheGlobalOne) {
+    logging::SetLevel(logging::Level::Info);
+    ASSERT_TRUE(logging::ApplyLevelSpec("Layer=debug"));
+    EXPECT_TRUE(logging::IsEnabled(logging::Level::Debug, logging::Subsystem::Layer));
+    EXPECT_FALSE(logging::IsEnabled(logging::Level::Debug, logging::Subsystem::Output));
+    EXPECT_FALSE(logging::IsEnabled(logging::Level::Debug));
+
+    // The override survives global changes until it is cleared.
+    logging::SetLevel(logging::Level::Error);
+    EXPECT_TRUE(logging::IsEnabled(logging::Level::Debug, logging::Subsystem::Layer));
+    EXPECT_FALSE(logging::IsEnabled(logging::Level::Warning, logging::Subsystem::Output));
+    logging::SetSubsystemLevel(logging::Subsystem::Layer, std::nullopt);
+    EXPECT_FALSE(logging::IsEnabled(logging::Level::Debug, logging::Subsystem::Layer));
+
+    EXPECT_TRUE(logging::ApplyLevelSpec("hook:trace"));
+    EXPECT_TRUE(logging::IsEnabled(logging::Level::Trace, logging::Subsystem::KeyboardHook));
+    logging::SetSubsystemLevel(logging::Subsystem::KeyboardHook, std::nullopt);
+    EXPECT_FALSE(logging::ApplyLevelSpec("layer=loud"));
+    EXPECT_FALSE(logging::ApplyLevelSpec("mouse=debug"));
+    EXPECT_FALSE(logging::ApplyLevelSpec("verbose"));
+    EXPECT_EQ(logging::Level::Error, logging::GetLevel());
+}
+
+TEST_F(LoggingTest, MacrosOnlyFormatEnabledMessages) {
+    int formatted = 0;
+    const auto count = [&formatted] {
+        ++formatted;
+        return "x";
+    };
+
+    logging::SetLevel(logging::Level::Info);
+    logging::SetSubsystemLevel(logging::Subsystem::Output, logging::Level::Trace);
+    CAPS_LOG_DEBUG(Layer, "[Test] layer " << count());
+    CAPS_LOG_TRACE(Output, "[Test] output " << count());
+    CAPS_LOG_INFO(Layer, "[Test] info " << count() << ' ' << 42);
+    logging::SetSubsystemLevel(logging::Subsystem::Output, std::nullopt);
+    logging::Flush();
+
+    EXPECT_EQ(2, formatted);
+    const auto lines = Lines();
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("[TRACE] [Test] output x"));
+    EXPECT_NE(std::string::npos, lines[1].find("[INFO] [Test] info x 42"));
+
+// What a CAPS_STRIP_DEBUG_LOGS Release build sees: the statements are gone entirely.
+#undef CAPS_LOG_MIN_LEVEL
+#define CAPS_LOG_MIN_LEVEL 2
+    logging::SetLevel(logging::Level::Trace);
+    CAPS_LOG_DEBUG(Layer, "[Test] stripped " << count());
+    CAPS_LOG_TRACE(General, "[Test] stripped " << count());
+    CAPS_LOG_WARN(General, "[Test] kept " << count());
+    EXPECT_EQ(3, formatted);
+#undef CAPS_LOG_MIN_LEVEL
+#define CAPS_LOG_MIN_LEVEL 0
+}
@@ -2,10 +2,13 @@
 
 #include <filesystem>
 #include <fstream>
+#include <atomic>
 #include <set>
+#include <thread>
 
 #include "core/config/config_loader.h"
 #include "core/mapping/mapping_engine.h"
+#include "temp_dir.h"
 
 namespace fs = std::filesystem;
 
@@ -13,17 +16,6 @@ namespace {
 
 class MappingEngineTest : public ::testing::Test {
 protected:
-    void SetUp() override {
-        static int counter = 0;
-        temp_dir_ = fs::temp_directory_path() /
-                    fs::path("capsunlocked_mapping_test_" + std::to_string(++counter));
-        fs::create_directories(temp_dir_);
-    }
-
-    void TearDown() override {
-        fs::remove_all(temp_dir_);
-    }
-
     fs::path WriteConfig(const std::string& contents) {
         const fs::path path = temp_dir_ / "capsunlocked.ini";
         std::ofstream stream(path);
@@ -31,7 +23,7 @@ protected:
         return path;
     }
 
-    fs::path temp_dir_;
+    caps::test::TempDir temp_dir_;
 };
 
 } // namespace
@@ -229,3 +221,168 @@ a
     EXPECT_EQ(1u, entries[0].required_mods.size());
     EXPECT_EQ("A", entries[0].required_mods[0]);
 }
+
+TEST_F(MappingEngineTest, ResolvesByInternedKeyId) {
+    const fs::path config_path = WriteConfig(R"(
+[modifiers]
+a
+
+[maps]
+[*] [j] [Down]
+[*] [a j] [PageDown]
+[chrome] [j] [Left]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine engine(loader);
+    engine.Initialize();
+
+    const caps::core::KeyId j = engine.LookupKey("j");
+    const caps::core::KeyId a = engine.LookupKey(" A ");
+    ASSERT_NE(caps::core::kInvalidKeyId, j);
+    ASSERT_NE(caps::core::kInvalidKeyId, a);
+    EXPECT_EQ(j, engine.LookupKey("J"));
+    EXPECT_EQ(caps::core::kInvalidKeyId, engine.LookupKey("z"));
+    EXPECT_EQ("J", engine.KeyName(j));
+    EXPECT_TRUE(engine.IsModifier(a));
+    EXPECT_FALSE(engine.IsModifier(j));
+    EXPECT_EQ(0u, engine.ModifierBit(j));
+    EXPECT_EQ(a, engine.ModifierKey(0));
+
+    auto result = engine.ResolveMapping(j, "", 0);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("DOWN", result->action);
+
+    result = engine.ResolveMapping(j, "", engine.ModifierBit(a));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("PAGEDOWN", result->action);
+    ASSERT_EQ(1u, result->required_mods.size());
+    EXPECT_EQ("A", result->required_mods[0]);
+
+    // App-specific rows win ties; the more specific fallback still wins with the modifier held.
+    result = engine.ResolveMapping(j, "Chrome", 0);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("LEFT", result->action);
+    EXPECT_EQ("CHROME", result->app);
+
+    result = engine.ResolveMapping(j, "Chrome", engine.ModifierBit(a));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("PAGEDOWN", result->action);
+    EXPECT_EQ("*", result->app);
+
+    EXPECT_FALSE(engine.ResolveMapping(caps::core::kInvalidKeyId, "", 0).has_value());
+}
+
+TEST_F(MappingEngineTest, FailedReloadKeepsPreviousSnapshotLive) {
+    const fs::path config_path = WriteConfig("[*] [j] [Down]\n");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+    caps::core::MappingEngine engine(loader);
+    engine.Initialize();
+
+    WriteConfig("[*] [j\n");
+    EXPECT_THROW(loader.Reload(), std::runtime_error);
+    engine.UpdateFromConfig();
+
+    auto result = engine.ResolveMapping("J", "");
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("DOWN", result->action);
+}
+
+// Publishes alternating tables while a reader resolves continuously. Every resolve must
+// see one complete snapshot; build with CAPS_ENABLE_TSAN=ON to check for data races.
+TEST_F(MappingEngineTest, ResolvesWhileReloadingConcurrently) {
+    using caps::core::CompiledTable;
+    using caps::core::MappingDefinition;
+    const auto left = CompiledTable::Build({{"*", {MappingDefinition{"J", "LEFT", {}},
+                                                   MappingDefinition{"J", "HOME", {"A"}}}}},
+                                           {"A"});
+    // Different interning order, so a mixed-up KeyId would resolve the wrong row.
+    const auto right = CompiledTable::Build({{"*", {MappingDefinition{"K", "UP", {}},
+                                                    MappingDefinition{"J", "RIGHT", {}},
+                                                    MappingDefinition{"J", "END", {"A"}}}}},
+                                            {"A"});
+
+    caps::core::ConfigLoader loader;
+    caps::core::MappingEngine engine(loader);
+    engine.Publish(left);
+
+    constexpr int kEvents = 1'000'000;
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+    std::thread reader([&] {
+        for (int i = 0; i < kEvents; ++i) {
+            const auto snapshot = engine.Acquire();
+            const caps::core::KeyId j = snapshot->FindKey("J");
+            const caps::core::ModifierMask mods = (i & 1) ? snapshot->ModifierBit(snapshot->FindKey("A")) : 0;
+            const auto result = caps::core::MappingEngine::ResolveMapping(snapshot, j, "", mods);
+            const bool ok = result && ((i & 1) ? (result->action == "HOME" || result->action == "END")
+                                               : (result->action == "LEFT" || result->action == "RIGHT"));
+            if (!ok) {
+                mismatches.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        done.store(true);
+    });
+
+    int reloads = 0;
+    while (!done.load()) {
+        engine.Publish((reloads++ & 1) ? left : right);
+        std::this_thread::yield();
+    }
+    reader.join();
+
+    EXPECT_EQ(0, mismatches.load());
+    EXPECT_GT(reloads, 0);
+    caps::core::EpochDomain::Global().Synchronize();
+    EXPECT_EQ(0u, caps::core::EpochDomain::Global().PendingCount());
+}
+
+TEST_F(MappingEngineTest, ActiveAppLooksUpTheRowOncePerFocusOrReload) {
+    const fs::path config_path = WriteConfig(R"(
+[*] [j] [Down]
+[chrome] [j] [Left]
+[code] [j] [End]
+)");
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config_path.string());
+
+    caps::core::MappingEngine engine(loader);
+    engine.Initialize();
+
+    using caps::core::MappingEngine;
+    MappingEngine::FocusedApp focused{"chrome", 1};
+    const MappingEngine::AppResolver resolver = [&focused] { return focused; };
+    MappingEngine::ActiveApp active;
+    const auto resolve = [&] {
+        const auto snapshot = engine.Acquire();
+        const auto result = MappingEngine::ResolveMapping(snapshot, snapshot->FindKey("J"), active, resolver, 0);
+        return result ? result->action : std::string();
+    };
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ("LEFT", resolve());
+    }
+    EXPECT_EQ(1u, active.Lookups());
+
+    focused = {"code", 2};
+    EXPECT_EQ("END", resolve());
+    EXPECT_EQ("END", resolve());
+    EXPECT_EQ(2u, active.Lookups());
+
+    // A reload publishes a new table, whose app ids may differ: looked up once more.
+    WriteConfig("[*] [j] [Down]\n[code] [j] [Home]\n");
+    loader.Reload();
+    engine.UpdateFromConfig();
+    EXPECT_EQ("HOME", resolve());
+    EXPECT_EQ("HOME", resolve());
+    EXPECT_EQ(3u, active.Lookups());
+
+    focused = {"firefox", 3};
+    EXPECT_EQ("DOWN", resolve());
+    EXPECT_EQ(4u, active.Lookups());
+}
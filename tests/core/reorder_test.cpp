@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/layer/layer_controller.h"
+#include "core/layer/reorder_buffer.h"
+#include "core/mapping/mapping_engine.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+
+TEST(ReorderBufferTest, ReleasesInTimeOrderUpToTheKey) {
+    caps::core::ReorderBuffer buffer;
+    EXPECT_TRUE(buffer.CaughtUp(1000)); // no lagging source reported yet: nothing to wait for
+
+    EXPECT_FALSE(buffer.Insert({300, false}));
+    EXPECT_FALSE(buffer.Insert({100, true}));
+    EXPECT_FALSE(buffer.Insert({500, true}));
+
+    std::vector<std::uint64_t> released;
+    const auto collect = [&released](const caps::core::CapsTransition& t) { released.push_back(t.time); };
+    buffer.Release(300, collect);
+    EXPECT_EQ((std::vector<std::uint64_t>{100, 300}), released);
+    EXPECT_EQ(1u, buffer.Size());
+
+    buffer.Advance(400);
+    EXPECT_TRUE(buffer.CaughtUp(400));
+    EXPECT_FALSE(buffer.CaughtUp(401));
+    buffer.Advance(200); // never moves back
+    EXPECT_TRUE(buffer.CaughtUp(400));
+
+    // A full buffer hands back its oldest entry instead of dropping anything.
+    for (std::uint64_t t = 1; t < caps::core::ReorderBuffer::kCapacity; ++t) {
+        EXPECT_FALSE(buffer.Insert({1000 + t, true}));
+    }
+    const auto evicted = buffer.Insert({2000, false});
+    ASSERT_TRUE(evicted);
+    EXPECT_EQ(500u, evicted->time);
+
+    // A late transition older than everything buffered is itself the one handed back.
+    const auto late = buffer.Insert({900, true});
+    ASSERT_TRUE(late);
+    EXPECT_EQ(900u, late->time);
+
+    released.clear();
+    buffer.ReleaseAll(collect);
+    ASSERT_EQ(caps::core::ReorderBuffer::kCapacity, released.size());
+    EXPECT_EQ(1001u, released.front());
+    EXPECT_EQ(2000u, released.back());
+    EXPECT_EQ(0u, buffer.Size());
+}
+
+namespace {
+
+// Drives a LayerController against a virtual clock: each clock read advances time by a
+// fixed step and lets the test play the IOHID thread at a chosen moment.
+class LayerReorderTest : public ::testing::Test {
+protected:
+    static constexpr std::uint64_t kStepUs = 100;
+    static constexpr auto kWindow = std::chrono::microseconds(2000);
+
+    void SetUp() override {
+        const fs::path path = dir_ / "capsunlocked.ini";
+        std::ofstream(path) << "[*] [h] [Left]\n";
+        loader_.Load(path.string());
+        mapping_.Initialize();
+        controller_.SetActionCallback([this](const std::string& action, bool pressed) {
+            if (pressed) emitted_.push_back(action);
+        });
+        controller_.SetReorderWindow(kWindow, [this] {
+            now_ += kStepUs;
+            if (on_tick_) on_tick_(now_);
+            return now_;
+        });
+    }
+
+    caps::test::TempDir dir_;
+    caps::core::ConfigLoader loader_;
+    caps::core::MappingEngine mapping_{loader_};
+    caps::core::LayerController controller_{mapping_};
+    std::vector<std::string> emitted_;
+    std::uint64_t now_{0};
+    std::function<void(std::uint64_t)> on_tick_;
+};
+
+} // namespace
+
+TEST_F(LayerReorderTest, KeyTypedAfterALateCapsLockReleasePassesThrough) {
+    controller_.OnCapsLockPressed();
+    controller_.AdvanceCapsSource(500);
+
+    // The release happened at 1000 but the IOHID thread only reports it 300us into the
+    // wait, after the tap has already delivered the key typed at 1010.
+    on_tick_ = [this](std::uint64_t now) {
+        if (now == 300) {
+            controller_.PostCapsLock(false, 1000);
+            controller_.AdvanceCapsSource(1020);
+        }
+    };
+    EXPECT_FALSE(controller_.OnKeyEvent({"h", "", true, 1010}));
+    EXPECT_TRUE(emitted_.empty());
+    EXPECT_LT(now_, 2000u); // stopped waiting as soon as the source caught up
+}
+
+TEST_F(LayerReorderTest, CapsLockPressReportedAfterTheKeyStillMapsIt) {
+    controller_.AdvanceCapsSource(500);
+
+    // A fast Caps+h roll: the press happened at 1000, but the IOHID thread only reports it
+    // 300us into the wait, after the tap has already delivered the h typed at 1010.
+    on_tick_ = [this](std::uint64_t now) {
+        if (now == 300) {
+            controller_.PostCapsLock(true, 1000);
+            controller_.AdvanceCapsSource(1020);
+        }
+    };
+    EXPECT_TRUE(controller_.OnKeyEvent({"h", "", true, 1010}));
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted_);
+    EXPECT_LT(now_, 2000u);
+
+    // The hook's pre-check already waited for this key; OnKeyEvent() does not wait again.
+    controller_.DrainInbox(1030);
+    const std::uint64_t after_first = now_;
+    EXPECT_TRUE(controller_.OnKeyEvent({"h", "", false, 1030}));
+    EXPECT_EQ(after_first, now_);
+}
+
+TEST_F(LayerReorderTest, WaitEndsWhenTheSourceThreadCatchesUp) {
+    // Real clock and a real source thread: the owner blocks until the source signals,
+    // rather than sleeping out the window.
+    constexpr auto kLongWindow = std::chrono::milliseconds(500);
+    controller_.SetReorderWindow(kLongWindow);
+    controller_.AdvanceCapsSource(500);
+
+    std::thread source([this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        controller_.PostCapsLock(true, 1000);
+        controller_.AdvanceCapsSource(1020);
+    });
+    const auto start = std::chrono::steady_clock::now();
+    const bool consumed = controller_.OnKeyEvent({"h", "", true, 1010});
+    const auto waited = std::chrono::steady_clock::now() - start;
+    source.join();
+
+    EXPECT_TRUE(consumed);
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted_);
+    EXPECT_LT(waited, kLongWindow / 2);
+}
+
+TEST_F(LayerReorderTest, LaterTransitionsStayBufferedForLaterKeys) {
+    controller_.PostCapsLock(true, 100);
+    controller_.PostCapsLock(false, 3000);
+    controller_.AdvanceCapsSource(4000);
+
+    // Both transitions were posted before the key, but the release happened after it.
+    EXPECT_TRUE(controller_.OnKeyEvent({"h", "", true, 2000}));
+    EXPECT_TRUE(controller_.IsLayerActive());
+    EXPECT_FALSE(controller_.OnKeyEvent({"h", "", true, 3500}));
+    EXPECT_FALSE(controller_.IsLayerActive());
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted_);
+    EXPECT_EQ(0u, now_); // the source was ahead both times: no clock reads, no waiting
+}
+
+TEST_F(LayerReorderTest, WaitIsBoundedByTheWindow) {
+    controller_.OnCapsLockPressed();
+    controller_.AdvanceCapsSource(500);
+
+    // The source stalls: the key goes through as it stands once the window has passed.
+    EXPECT_TRUE(controller_.OnKeyEvent({"h", "", true, 1000}));
+    EXPECT_GE(now_, 2000u);
+    EXPECT_LE(now_, 2000u + 2 * kStepUs);
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted_);
+
+    // A transition that did arrive meanwhile is applied to the next key it precedes.
+    controller_.PostCapsLock(false, 1100);
+    now_ = 0;
+    EXPECT_FALSE(controller_.OnKeyEvent({"h", "", true, 1200}));
+    EXPECT_EQ(std::vector<std::string>{"LEFT"}, emitted_);
+
+    // Unstamped keys never wait and see everything posted so far.
+    controller_.PostCapsLock(true, 5000);
+    now_ = 0;
+    EXPECT_TRUE(controller_.OnKeyEvent({"h", "", true}));
+    EXPECT_EQ(0u, now_);
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "core/config/config_loader.h"
+#include "core/layer/layer_controller.h"
+#include "core/mapping/mapping_engine.h"
+#include "core/replay/replayer.h"
+#include "core/replay/trace.h"
+#include "temp_dir.h"
+
+namespace fs = std::filesystem;
+
+using caps::core::TraceRecord;
+
+TEST(TraceTest, RoundTripsRecordsAndRejectsDamagedStreams) {
+    std::stringstream stream;
+    caps::core::TraceWriter writer(stream);
+    writer.CapsLock(true, 5000);
+    writer.Key({"A", "", true, 4000}, true, true, "SHIFT! LEFT"); // stamped before the transition
+    writer.Focus("chrome");
+    writer.Key({"A", "chrome", false, 0}, true, true, "SHIFT! LEFT");
+    writer.CapsLock(false, 0);
+    writer.Flush();
+    EXPECT_EQ(5u, writer.Records());
+
+    const std::string bytes = stream.str();
+    const std::vector<TraceRecord> records = caps::core::ReadTrace(stream);
+    ASSERT_EQ(5u, records.size());
+
+    EXPECT_EQ(TraceRecord::Kind::kCapsLock, records[0].kind);
+    EXPECT_TRUE(records[0].pressed);
+    EXPECT_EQ(5000u, records[0].time);
+
+    EXPECT_EQ(TraceRecord::Kind::kKey, records[1].kind);
+    EXPECT_EQ("A", records[1].key);
+    EXPECT_EQ("", records[1].app);
+    EXPECT_EQ(4000u, records[1].time);
+    EXPECT_TRUE(records[1].pressed);
+    EXPECT_TRUE(records[1].consumed);
+    EXPECT_TRUE(records[1].emitted);
+    EXPECT_EQ("SHIFT! LEFT", records[1].action);
+
+    EXPECT_EQ(TraceRecord::Kind::kFocus, records[2].kind);
+    EXPECT_EQ("chrome", records[2].app);
+
+    EXPECT_EQ("chrome", records[3].app);
+    EXPECT_EQ(0u, records[3].time);
+    EXPECT_FALSE(records[3].pressed);
+    EXPECT_EQ("SHIFT! LEFT", records[3].action);
+
+    EXPECT_FALSE(records[4].pressed);
+    for (std::size_t i = 1; i < records.size(); ++i) {
+        EXPECT_GE(records[i].arrival_us, records[i - 1].arrival_us);
+    }
+
+    // Repeated strings are references: the second key costs a handful of bytes.
+    EXPECT_LT(bytes.size(), 64u);
+
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    EXPECT_THROW(caps::core::ReadTrace(truncated), std::runtime_error);
+    std::istringstream foreign("[*] [h] [Left]\n");
+    EXPECT_THROW(caps::core::ReadTrace(foreign), std::runtime_error);
+
+    // A key record whose string claims ~2^63 bytes: rejected, not allocated.
+    std::string huge = bytes.substr(0, sizeof(caps::core::TraceWriter::kMagic) + 1);
+    huge += std::string("\x02\x00\x00\x00", 4);
+    huge += std::string(8, '\xff') + '\x7f';
+    std::istringstream damaged(huge);
+    EXPECT_THROW(caps::core::ReadTrace(damaged), std::runtime_error);
+}
+
+namespace {
+
+class ReplayTest : public ::testing::Test {
+protected:
+    fs::path WriteConfig(const std::string& name, const std::string& contents) {
+        const fs::path path = temp_dir_ / name;
+        std::ofstream(path) << contents;
+        return path;
+    }
+
+    // Types a short session through a controller that records it.
+    std::vector<TraceRecord> Record(const fs::path& config_path) {
+        caps::core::ConfigLoader loader;
+        loader.Load(config_path.string());
+        caps::core::MappingEngine mapping(loader);
+        mapping.Initialize();
+        caps::core::LayerController controller(mapping);
+
+        std::string focus = "chrome";
+        std::uint64_t generation = 1;
+        controller.SetAppResolver(
+            [&] { return caps::core::MappingEngine::FocusedApp{focus, generation}; });
+
+        std::stringstream stream;
+        caps::core::TraceWriter writer(stream);
+        controller.SetTraceWriter(&writer);
+
+        EXPECT_FALSE(controller.OnKeyEvent({"h", "", true}));
+        EXPECT_FALSE(controller.OnKeyEvent({"h", "", false}));
+        controller.OnCapsLockPressed();
+        for (const char* key : {"h", "k", "j", "x"}) {
+            EXPECT_TRUE(controller.OnKeyEvent({key, "", true}));
+            EXPECT_TRUE(controller.OnKeyEvent({key, "", true})); // auto-repeat
+            EXPECT_TRUE(controller.OnKeyEvent({key, "", false}));
+        }
+        focus = "terminal";
+        ++generation;
+        EXPECT_TRUE(controller.OnKeyEvent({"k", "", true}));
+        EXPECT_TRUE(controller.OnKeyEvent({"k", "", false}));
+        EXPECT_TRUE(controller.OnKeyEvent({"k", "chrome", true}));
+        EXPECT_TRUE(controller.OnKeyEvent({"k", "chrome", false}));
+        controller.OnCapsLockReleased();
+        EXPECT_FALSE(controller.OnKeyEvent({"h", "", true}));
+        controller.SetTraceWriter(nullptr);
+        EXPECT_FALSE(controller.OnKeyEvent({"h", "", false})); // not recorded
+
+        writer.Flush();
+        return caps::core::ReadTrace(stream);
+    }
+
+    caps::core::ReplayReport Replay(const fs::path& config_path,
+                                    const std::vector<TraceRecord>& records,
+                                    const caps::core::ReplayOptions& options = {}) {
+        caps::core::ConfigLoader loader;
+        loader.Load(config_path.string());
+        caps::core::MappingEngine mapping(loader);
+        mapping.Initialize();
+        caps::core::LayerController controller(mapping);
+        caps::core::Replayer replayer(controller, records);
+        return replayer.Run(options);
+    }
+
+    static constexpr const char* kConfig = R"(
+[*] [h] [Left]
+[*] [k] [Down]
+[chrome] [k] [Home]
+[*] [j] [Shift! End]
+)";
+
+    caps::test::TempDir temp_dir_;
+};
+
+} // namespace
+
+TEST_F(ReplayTest, ReplayingUnderTheSameConfigReproducesEveryKey) {
+    const fs::path config = WriteConfig("capsunlocked.ini", kConfig);
+    const std::vector<TraceRecord> records = Record(config);
+
+    std::size_t keys = 0, transitions = 0, focus_changes = 0;
+    for (const TraceRecord& record : records) {
+        keys += record.kind == TraceRecord::Kind::kKey;
+        transitions += record.kind == TraceRecord::Kind::kCapsLock;
+        focus_changes += record.kind == TraceRecord::Kind::kFocus;
+    }
+    EXPECT_EQ(19u, keys);
+    EXPECT_EQ(2u, transitions);
+    EXPECT_EQ(2u, focus_changes); // chrome on the first k, terminal after the switch
+
+    caps::core::ReplayOptions options;
+    options.passes = 3;
+    const caps::core::ReplayReport report = Replay(config, records, options);
+    EXPECT_EQ(0u, report.mismatches);
+    EXPECT_TRUE(report.first_mismatches.empty());
+    EXPECT_EQ(3 * keys, report.keys);
+    EXPECT_EQ(3 * transitions, report.caps_transitions);
+    EXPECT_EQ(3 * focus_changes, report.focus_changes);
+    EXPECT_GT(report.keys_per_second, 0.0);
+    EXPECT_LE(report.p50_ns, report.p90_ns);
+    EXPECT_LE(report.p90_ns, report.p99_ns);
+    EXPECT_LE(report.p99_ns, report.p999_ns);
+    EXPECT_LE(report.p999_ns, report.max_ns);
+}
+
+TEST_F(ReplayTest, ReportsKeysThatNowRouteDifferently) {
+    const std::vector<TraceRecord> records = Record(WriteConfig("capsunlocked.ini", kConfig));
+
+    // h now emits something else and j is no longer mapped at all.
+    const fs::path changed = WriteConfig("changed.ini", R"(
+[*] [h] [Right]
+[*] [k] [Down]
+[chrome] [k] [Home]
+)");
+    const caps::core::ReplayReport report = Replay(changed, records);
+    EXPECT_EQ(6u, report.mismatches); // three h and three j events under the layer
+    ASSERT_FALSE(report.first_mismatches.empty());
+    EXPECT_NE(std::string::npos, report.first_mismatches.front().find("emitted LEFT"))
+        << report.first_mismatches.front();
+}
+
+TEST_F(ReplayTest, ReplayerHandsTheAppResolverBack) {
+    const fs::path config = WriteConfig("capsunlocked.ini", kConfig);
+    const std::vector<TraceRecord> records = Record(config);
+
+    caps::core::ConfigLoader loader;
+    loader.Load(config.string());
+    caps::core::MappingEngine mapping(loader);
+    mapping.Initialize();
+    caps::core::LayerController controller(mapping);
+    {
+        caps::core::Replayer replayer(controller, records);
+        EXPECT_EQ(0u, replayer.Run().mismatches);
+    }
+
+    // With no resolver left, an app-specific key falls back to its "*" mapping.
+    std::vector<std::string> emitted;
+    controller.SetActionCallback([&emitted](const std::string& action, bool pressed) {
+        if (pressed) emitted.push_back(action);
+    });
+    controller.OnCapsLockPressed();
+    EXPECT_TRUE(controller.OnKeyEvent({"k", "", true}));
+    EXPECT_EQ(std::vector<std::string>{"DOWN"}, emitted);
+}
@@ -0,0 +1,51 @@
+#include "temp_dir.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace caps::test {
+
+namespace {
+
+long ProcessId() {
+#if defined(_WIN32)
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(getpid());
+#endif
+}
+
+} // namespace
+
+TempDir::TempDir() {
+    // A test may hold several at once; the sequence number tells them apart.
+    static int sequence = 0;
+    std::string name = "capsunlocked_";
+    if (const auto* info = ::testing::UnitTest::GetInstance()->current_test_info()) {
+        name += std::string(info->test_suite_name()) + "." + info->name() + "_";
+    }
+    name += std::to_string(ProcessId()) + "_" + std::to_string(++sequence);
+    // Parameterized names contain '/'.
+    for (char& c : name) {
+        if (c == '/') c = '_';
+    }
+
+    path_ = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path_); // left behind by a crashed run with a recycled pid
+    std::filesystem::create_directories(path_);
+}
+
+TempDir::~TempDir() {
+    std::error_code ignored;
+    std::filesystem::remove_all(path_, ignored);
+}
+
+} // namespace caps::test
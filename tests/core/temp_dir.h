@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+namespace caps::test {
+
+// A fresh directory under the system temp dir for one test, removed with its contents
+// when the TempDir goes. The name carries the running test's name and the process id,
+// so discovered tests run as separate processes (ctest -j) and concurrent runs from
+// other build trees never share files.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& Path() const { return path_; }
+    [[nodiscard]] std::filesystem::path operator/(const std::filesystem::path& name) const { return path_ / name; }
+
+private:
+    std::filesystem::path path_;
+};
+
+} // namespace caps::test